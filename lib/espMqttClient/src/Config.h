@@ -73,3 +73,36 @@ the LICENSE file.
     #define EMC_SIZE_POOL_ELEMENTS 128
   #endif
 #endif
+
+#ifndef EMC_OUTBOX_POOL_ELEMENTS
+  #if EMC_USE_MEMPOOL
+    #define EMC_OUTBOX_POOL_ELEMENTS EMC_NUM_POOL_ELEMENTS
+  #else
+    #define EMC_OUTBOX_POOL_ELEMENTS 0
+  #endif
+#endif
+
+#ifndef EMC_PROPERTIES_BUFFER_SIZE
+#define EMC_PROPERTIES_BUFFER_SIZE 128
+#endif
+
+#ifndef EMC_MAX_USER_PROPERTIES
+#define EMC_MAX_USER_PROPERTIES 4
+#endif
+
+#ifndef EMC_SESSION_EXPIRY_INTERVAL
+// MQTT 5: applied when cleanSession is false, 0xFFFFFFFF keeps the session like MQTT 3.1.1 does
+#define EMC_SESSION_EXPIRY_INTERVAL 0xFFFFFFFF
+#endif
+
+#ifndef EMC_MAX_TOPIC_ALIASES
+#define EMC_MAX_TOPIC_ALIASES 10
+#endif
+
+#ifndef EMC_TOPIC_ALIAS_CANDIDATES
+#define EMC_TOPIC_ALIAS_CANDIDATES 32
+#endif
+
+#ifndef EMC_TOPIC_ALIAS_THRESHOLD
+#define EMC_TOPIC_ALIAS_THRESHOLD 3
+#endif
@@ -38,6 +38,7 @@ MqttClient::MqttClient(espMqttClientTypes::UseInternalTask useInternalTask, uint
 , _willQos(0)
 , _willRetain(false)
 , _timeout(EMC_TX_TIMEOUT)
+, _protocolVersion(espMqttClientTypes::ProtocolVersion::V3_1_1)
 , _state(State::disconnected)
 , _generatedClientId{0}
 , _packetId(0)
@@ -53,6 +54,10 @@ MqttClient::MqttClient(espMqttClientTypes::UseInternalTask useInternalTask, uint
 , _lastServerActivity(0)
 , _pingSent(false)
 , _disconnectReason(DisconnectReason::TCP_DISCONNECTED)
+, _topicAliases{nullptr}
+, _topicAliasMaximum(0)
+, _topicAliasCount(0)
+, _topicAliasCandidates()
 #if defined(ARDUINO_ARCH_ESP32) && ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_INFO
 , _highWaterMark(4294967295)
 #endif
@@ -75,6 +80,7 @@ MqttClient::MqttClient(espMqttClientTypes::UseInternalTask useInternalTask, uint
 MqttClient::~MqttClient() {
   disconnect(true);
   _clearQueue(2);
+  _clearTopicAliases();
 #if defined(ARDUINO_ARCH_ESP32)
   vSemaphoreDelete(_xSemaphore);
   if (_useInternalTask == espMqttClientTypes::UseInternalTask::YES) {
@@ -109,8 +115,10 @@ bool MqttClient::connect() {
                         _willPayload,
                         _willPayloadLength,
                         (uint16_t)(_keepAlive / 1000),  // 32b to 16b doesn't overflow because it comes from 16b orignally
-                        _clientId)) {
+                        _clientId,
+                        _protocolVersion)) {
       result = true;
+      _parser.setProtocolVersion(_protocolVersion);
       _setState(State::connectingTcp1);
       #if defined(ARDUINO_ARCH_ESP32)
       if (_useInternalTask == espMqttClientTypes::UseInternalTask::YES) {
@@ -140,7 +148,9 @@ bool MqttClient::disconnect(bool force) {
   return false;
 }
 
-uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, const uint8_t* payload, size_t length) {
+template <typename TPayload>
+uint16_t MqttClient::_publish(const char* topic, uint8_t qos, bool retain, TPayload payload, size_t length,
+                              const espMqttClientTypes::PublishProperties* properties, espMqttClientTypes::PublishMode mode) {
   #if !EMC_ALLOW_NOT_CONNECTED_PUBLISH
   if (_state != State::connected) {
   #else
@@ -149,8 +159,36 @@ uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, const
     return 0;
   }
   EMC_SEMAPHORE_TAKE();
-  uint16_t packetId = (qos > 0) ? _getNextPacketId() : 1;
-  if (!_addPacket(packetId, topic, payload, length, qos, retain)) {
+  espMqttClientInternals::Outbox<OutgoingPacket>::Iterator queued;
+  if (mode == espMqttClientTypes::PublishMode::LAST_VALUE) {
+    queued = _findUnsentPublish(topic, retain);
+  }
+  // only a LAST_VALUE publish may take the place of a queued one, everything else is dropped when the outbox is full
+  if (!queued && _outbox.full()) {
+    emc_log_w("Outbox full, PUBLISH dropped");
+    EMC_SEMAPHORE_GIVE();
+    _onError(0, Error::OUTBOX_FULL);
+    return 0;
+  }
+  uint16_t packetId = _getPublishPacketId(queued, qos);
+  bool added = false;
+  if (_protocolVersion == espMqttClientTypes::ProtocolVersion::V5) {
+    bool known = false;
+    uint16_t topicAlias = _getTopicAlias(topic, &known);
+    // the alias may have been set up after the queued packet, only an alias-only packet can be replaced by one
+    if (queued && queued.get()->packet.topicAlias() == 0) known = false;
+    const char* packetTopic = known ? "" : topic;
+    if (queued) {
+      added = _replacePacket(queued, packetId, packetTopic, payload, length, qos, retain, topicAlias, properties);
+    } else {
+      added = _addPacket(packetId, packetTopic, payload, length, qos, retain, topicAlias, properties);
+    }
+  } else if (queued) {
+    added = _replacePacket(queued, packetId, topic, payload, length, qos, retain);
+  } else {
+    added = _addPacket(packetId, topic, payload, length, qos, retain);
+  }
+  if (!added) {
     emc_log_e("Could not create PUBLISH packet");
     EMC_SEMAPHORE_GIVE();
     _onError(packetId, Error::OUT_OF_MEMORY);
@@ -161,12 +199,44 @@ uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, const
   return packetId;
 }
 
-uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, const char* payload) {
+uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, const uint8_t* payload, size_t length,
+                             const espMqttClientTypes::PublishProperties* properties, espMqttClientTypes::PublishMode mode) {
+  return _publish(topic, qos, retain, payload, length, properties, mode);
+}
+
+uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, espMqttClientTypes::PayloadWriter writer, size_t length,
+                             const espMqttClientTypes::PublishProperties* properties, espMqttClientTypes::PublishMode mode) {
+  return _publish(topic, qos, retain, writer, length, properties, mode);
+}
+
+uint16_t MqttClient::subscribe(const espMqttClientTypes::SubscribeItem* list, size_t numberTopics) {
+  uint16_t packetId = 0;
+  if (_state != State::connected) {
+    return packetId;
+  }
+  EMC_SEMAPHORE_TAKE();
+  packetId = _getNextPacketId();
+  if (!_addPacket(packetId, list, numberTopics, _protocolVersion)) {
+    emc_log_e("Could not create SUBSCRIBE packet");
+    packetId = 0;
+  }
+  EMC_SEMAPHORE_GIVE();
+  return packetId;
+}
+
+uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, const char* payload,
+                             const espMqttClientTypes::PublishProperties* properties, espMqttClientTypes::PublishMode mode) {
   size_t len = strlen(payload);
-  return publish(topic, qos, retain, reinterpret_cast<const uint8_t*>(payload), len);
+  return publish(topic, qos, retain, reinterpret_cast<const uint8_t*>(payload), len, properties, mode);
 }
 
-uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, espMqttClientTypes::PayloadCallback callback, size_t length) {
+uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, std::nullptr_t payload, size_t length,
+                             const espMqttClientTypes::PublishProperties* properties, espMqttClientTypes::PublishMode mode) {
+  return publish(topic, qos, retain, static_cast<const uint8_t*>(payload), length, properties, mode);
+}
+
+uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, espMqttClientTypes::PayloadCallback callback, size_t length,
+                             const espMqttClientTypes::PublishProperties* properties, espMqttClientTypes::PublishMode mode) {
   #if !EMC_ALLOW_NOT_CONNECTED_PUBLISH
   if (_state != State::connected) {
   #else
@@ -175,8 +245,31 @@ uint16_t MqttClient::publish(const char* topic, uint8_t qos, bool retain, espMqt
     return 0;
   }
   EMC_SEMAPHORE_TAKE();
-  uint16_t packetId = (qos > 0) ? _getNextPacketId() : 1;
-  if (!_addPacket(packetId, topic, callback, length, qos, retain)) {
+  espMqttClientInternals::Outbox<OutgoingPacket>::Iterator queued;
+  if (mode == espMqttClientTypes::PublishMode::LAST_VALUE) {
+    queued = _findUnsentPublish(topic, retain);
+  }
+  // only a LAST_VALUE publish may take the place of a queued one, everything else is dropped when the outbox is full
+  if (!queued && _outbox.full()) {
+    emc_log_w("Outbox full, PUBLISH dropped");
+    EMC_SEMAPHORE_GIVE();
+    _onError(0, Error::OUTBOX_FULL);
+    return 0;
+  }
+  uint16_t packetId = _getPublishPacketId(queued, qos);
+  bool added = false;
+  if (_protocolVersion == espMqttClientTypes::ProtocolVersion::V5) {
+    if (queued) {
+      added = _replacePacket(queued, packetId, topic, callback, length, qos, retain, static_cast<uint16_t>(0), properties);
+    } else {
+      added = _addPacket(packetId, topic, callback, length, qos, retain, static_cast<uint16_t>(0), properties);
+    }
+  } else if (queued) {
+    added = _replacePacket(queued, packetId, topic, callback, length, qos, retain);
+  } else {
+    added = _addPacket(packetId, topic, callback, length, qos, retain);
+  }
+  if (!added) {
     emc_log_e("Could not create PUBLISH packet");
     EMC_SEMAPHORE_GIVE();
     _onError(packetId, Error::OUT_OF_MEMORY);
@@ -197,6 +290,10 @@ const char* MqttClient::getClientId() const {
   return _clientId;
 }
 
+uint16_t MqttClient::topicAliasCount() const {
+  return _topicAliasCount;
+}
+
 size_t MqttClient::queueSize() {
   size_t ret = 0;
   EMC_SEMAPHORE_TAKE();
@@ -205,6 +302,34 @@ size_t MqttClient::queueSize() {
   return ret;
 }
 
+size_t MqttClient::queueHighWaterMark() {
+  size_t ret = 0;
+  EMC_SEMAPHORE_TAKE();
+  ret = _outbox.highWaterMark();
+  EMC_SEMAPHORE_GIVE();
+  return ret;
+}
+
+void MqttClient::resetQueueHighWaterMark() {
+  EMC_SEMAPHORE_TAKE();
+  _outbox.resetHighWaterMark();
+  EMC_SEMAPHORE_GIVE();
+}
+
+void MqttClient::setQueueCapacity(size_t capacity) {
+  EMC_SEMAPHORE_TAKE();
+  _outbox.setCapacity(capacity);
+  EMC_SEMAPHORE_GIVE();
+}
+
+size_t MqttClient::queueCapacity() {
+  size_t ret = 0;
+  EMC_SEMAPHORE_TAKE();
+  ret = _outbox.capacity();
+  EMC_SEMAPHORE_GIVE();
+  return ret;
+}
+
 void MqttClient::loop() {
   switch (_state) {
     case State::disconnected:
@@ -295,6 +420,7 @@ void MqttClient::loop() {
       if (_transport->disconnected()) {
         EMC_SEMAPHORE_TAKE();
         _clearQueue(0);
+        _clearTopicAliases();
         EMC_SEMAPHORE_GIVE();
         _bytesSent = 0;
         _setState(State::disconnected);
@@ -342,6 +468,107 @@ uint16_t MqttClient::_getNextPacketId() {
   return _packetId;
 }
 
+uint16_t MqttClient::_getPublishPacketId(const espMqttClientInternals::Outbox<OutgoingPacket>::Iterator& queued, uint8_t qos) {
+  if (qos == 0) return 1;
+  // a replacement takes over the packet ID, so the ID returned for the replaced packet still gets its onPublish
+  if (queued && queued.get()->packet.packetId() != 0) return queued.get()->packet.packetId();
+  return _getNextPacketId();
+}
+
+uint16_t MqttClient::_getTopicAlias(const char* topic, bool* known) {
+  *known = false;
+  // aliases are negotiated in CONNACK, packets queued before that go out with the full topic
+  if (_state != State::connected) return 0;
+
+  for (uint16_t i = 0; i < _topicAliasCount; ++i) {
+    if (strcmp(_topicAliases[i], topic) == 0) {
+      *known = true;
+      return i + 1;
+    }
+  }
+  if (_topicAliasCount >= _topicAliasMaximum) return 0;
+
+  uint32_t hash = 2166136261;  // FNV-1a
+  for (const char* c = topic; *c; ++c) {
+    hash = (hash ^ static_cast<uint8_t>(*c)) * 16777619;
+  }
+
+  // keep counting a known candidate, otherwise replace the least published one
+  TopicAliasCandidate* candidate = &_topicAliasCandidates[0];
+  bool found = false;
+  for (size_t i = 0; i < EMC_TOPIC_ALIAS_CANDIDATES; ++i) {
+    if (_topicAliasCandidates[i].count > 0 && _topicAliasCandidates[i].hash == hash) {
+      candidate = &_topicAliasCandidates[i];
+      found = true;
+      break;
+    }
+    if (_topicAliasCandidates[i].count < candidate->count) {
+      candidate = &_topicAliasCandidates[i];
+    }
+  }
+  if (!found) {
+    candidate->hash = hash;
+    candidate->count = 0;
+  }
+  if (++candidate->count < EMC_TOPIC_ALIAS_THRESHOLD) return 0;
+
+  size_t length = strlen(topic);
+  char* copy = reinterpret_cast<char*>(malloc(length + 1));
+  if (!copy) return 0;
+  memcpy(copy, topic, length + 1);
+  _topicAliases[_topicAliasCount++] = copy;
+  candidate->count = 0;
+  emc_log_i("Topic alias %u: %s", _topicAliasCount, topic);
+  return _topicAliasCount;
+}
+
+void MqttClient::_clearTopicAliases() {
+  // the server forgets aliases when the connection closes, packets kept for the next session need their topic back
+  espMqttClientInternals::Outbox<OutgoingPacket>::Iterator it = _outbox.front();
+  while (it) {
+    uint16_t topicAlias = it.get()->packet.topicAlias();
+    if (topicAlias != 0 && (topicAlias > _topicAliasCount || !it.get()->packet.expandTopicAlias(_topicAliases[topicAlias - 1]))) {
+      emc_log_e("Could not restore topic of packet %u", it.get()->packet.packetId());
+      _outbox.remove(it);
+    } else {
+      ++it;
+    }
+  }
+  for (uint16_t i = 0; i < _topicAliasCount; ++i) {
+    free(_topicAliases[i]);
+    _topicAliases[i] = nullptr;
+  }
+  _topicAliasCount = 0;
+  _topicAliasMaximum = 0;
+  for (size_t i = 0; i < EMC_TOPIC_ALIAS_CANDIDATES; ++i) {
+    _topicAliasCandidates[i].count = 0;
+  }
+}
+
+bool MqttClient::_publishesTo(const espMqttClientInternals::Packet& packet, const char* topic) const {
+  uint16_t topicAlias = packet.topicAlias();
+  if (topicAlias != 0) {
+    return topicAlias <= _topicAliasCount && strcmp(_topicAliases[topicAlias - 1], topic) == 0;
+  }
+  return packet.hasTopic(topic);
+}
+
+espMqttClientInternals::Outbox<MqttClient::OutgoingPacket>::Iterator MqttClient::_findUnsentPublish(const char* topic, bool retain) {
+  espMqttClientInternals::Outbox<OutgoingPacket>::Iterator it = _outbox.current();
+  while (it) {
+    const espMqttClientInternals::Packet& packet = it.get()->packet;
+    if (it.get()->timeSent == 0 &&
+        packet.packetType() == PacketType.PUBLISH &&
+        packet.retain() == retain &&
+        _publishesTo(packet, topic)) {
+      emc_log_i("Found unsent PUBLISH %u", packet.packetId());
+      break;
+    }
+    ++it;
+  }
+  return it;
+}
+
 void MqttClient::_checkOutbox() {
   while (_sendPacket() > 0) {
     if (!_advanceOutbox()) {
@@ -436,6 +663,9 @@ void MqttClient::_checkIncoming() {
           case PacketType.PINGRESP:
             _pingSent = false;
             break;
+          case PacketType.DISCONNECT:
+            _onDisconnect();
+            return;
         }
       } else if (result ==  espMqttClientInternals::ParserResult::protocolError) {
         emc_log_w("Disconnecting, protocol error");
@@ -492,6 +722,9 @@ void MqttClient::_checkTimeout() {
 void MqttClient::_onConnack() {
   if (_parser.getPacket().variableHeader.fixed.connackVarHeader.returnCode == 0x00) {
     _pingSent = false;  // reset after keepalive timeout disconnect
+    if (_protocolVersion == espMqttClientTypes::ProtocolVersion::V5) {
+      _topicAliasMaximum = std::min(_parser.getPacket().properties.topicAliasMaximum, static_cast<uint16_t>(EMC_MAX_TOPIC_ALIASES));
+    }
     _setState(State::connected);
     _advanceOutbox();
     if (_parser.getPacket().variableHeader.fixed.connackVarHeader.sessionPresent == 0) {
@@ -504,8 +737,29 @@ void MqttClient::_onConnack() {
     }
   } else {
     _setState(State::disconnectingTcp1);
-    // cast is safe because the parser already checked for a valid return code
-    _disconnectReason = static_cast<DisconnectReason>(_parser.getPacket().variableHeader.fixed.connackVarHeader.returnCode);
+    uint8_t returnCode = _parser.getPacket().variableHeader.fixed.connackVarHeader.returnCode;
+    if (_protocolVersion == espMqttClientTypes::ProtocolVersion::V5) {
+      switch (returnCode) {
+        case 0x84:  // unsupported protocol version
+          _disconnectReason = DisconnectReason::MQTT_UNACCEPTABLE_PROTOCOL_VERSION;
+          break;
+        case 0x85:  // client identifier not valid
+          _disconnectReason = DisconnectReason::MQTT_IDENTIFIER_REJECTED;
+          break;
+        case 0x86:  // bad user name or password
+          _disconnectReason = DisconnectReason::MQTT_MALFORMED_CREDENTIALS;
+          break;
+        case 0x87:  // not authorized
+          _disconnectReason = DisconnectReason::MQTT_NOT_AUTHORIZED;
+          break;
+        default:
+          _disconnectReason = DisconnectReason::MQTT_SERVER_UNAVAILABLE;
+          break;
+      }
+    } else {
+      // cast is safe because the parser already checked for a valid return code
+      _disconnectReason = static_cast<DisconnectReason>(returnCode);
+    }
   }
 }
 
@@ -539,8 +793,15 @@ void MqttClient::_onPublish() {
     }
   }
   if (callback && _onMessageCallback) {
+    const espMqttClientInternals::IncomingProperties& properties = p.properties;
     EMC_SEMAPHORE_GIVE();
-    _onMessageCallback({qos, dup, retain, packetId},
+    _onMessageCallback({qos, dup, retain, packetId,
+                        properties.messageExpiryInterval,
+                        properties.responseTopic,
+                        properties.correlationData,
+                        properties.correlationDataLength,
+                        properties.userProperties,
+                        properties.userPropertyCount},
                        p.variableHeader.topic,
                        p.payload.data,
                        p.payload.length,
@@ -706,6 +967,12 @@ void MqttClient::_onUnsuback() {
   }
 }
 
+void MqttClient::_onDisconnect() {
+  emc_log_w("Disconnected by server (reason 0x%02x)", _parser.getPacket().variableHeader.reasonCode);
+  _setState(State::disconnectingTcp1);
+  _disconnectReason = DisconnectReason::MQTT_SERVER_DISCONNECT;
+}
+
 void MqttClient::_clearQueue(int clearData) {
   emc_log_i("clearing queue (clear session: %d)", clearData);
   espMqttClientInternals::Outbox<OutgoingPacket>::Iterator it = _outbox.front();
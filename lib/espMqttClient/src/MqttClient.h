@@ -12,6 +12,7 @@ the LICENSE file.
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <utility>
 
 #include "Helpers.h"
@@ -38,7 +39,9 @@ class MqttClient {
     } else {
       EMC_SEMAPHORE_TAKE();
       packetId = _getNextPacketId();
-      if (!_addPacket(packetId, topic, qos, std::forward<Args>(args) ...)) {
+      espMqttClientTypes::SubscribeItem list[1 + sizeof...(Args) / 2];
+      _fillList(list, topic, qos, std::forward<Args>(args) ...);
+      if (!_addPacket(packetId, list, 1 + sizeof...(Args) / 2, _protocolVersion)) {
         emc_log_e("Could not create SUBSCRIBE packet");
         packetId = 0;
       }
@@ -46,6 +49,7 @@ class MqttClient {
     }
     return packetId;
   }
+  uint16_t subscribe(const espMqttClientTypes::SubscribeItem* list, size_t numberTopics);
   template <typename... Args>
   uint16_t unsubscribe(const char* topic, Args&&... args) {
     uint16_t packetId = 0;
@@ -54,7 +58,9 @@ class MqttClient {
     } else {
       EMC_SEMAPHORE_TAKE();
       packetId = _getNextPacketId();
-      if (!_addPacket(packetId, topic, std::forward<Args>(args) ...)) {
+      const char* list[1 + sizeof...(Args)];
+      _fillList(list, topic, std::forward<Args>(args) ...);
+      if (!_addPacket(packetId, list, 1 + sizeof...(Args), _protocolVersion)) {
         emc_log_e("Could not create UNSUBSCRIBE packet");
         packetId = 0;
       }
@@ -62,12 +68,33 @@ class MqttClient {
     }
     return packetId;
   }
-  uint16_t publish(const char* topic, uint8_t qos, bool retain, const uint8_t* payload, size_t length);
-  uint16_t publish(const char* topic, uint8_t qos, bool retain, const char* payload);
-  uint16_t publish(const char* topic, uint8_t qos, bool retain, espMqttClientTypes::PayloadCallback callback, size_t length);
+  // properties are only sent when connecting with MQTT 5
+  uint16_t publish(const char* topic, uint8_t qos, bool retain, const uint8_t* payload, size_t length,
+                   const espMqttClientTypes::PublishProperties* properties = nullptr,
+                   espMqttClientTypes::PublishMode mode = espMqttClientTypes::PublishMode::QUEUE_ALL);
+  uint16_t publish(const char* topic, uint8_t qos, bool retain, const char* payload,
+                   const espMqttClientTypes::PublishProperties* properties = nullptr,
+                   espMqttClientTypes::PublishMode mode = espMqttClientTypes::PublishMode::QUEUE_ALL);
+  // empty payload, publish(topic, qos, retain, nullptr, 0) would otherwise be ambiguous with the overload above
+  uint16_t publish(const char* topic, uint8_t qos, bool retain, std::nullptr_t payload, size_t length,
+                   const espMqttClientTypes::PublishProperties* properties = nullptr,
+                   espMqttClientTypes::PublishMode mode = espMqttClientTypes::PublishMode::QUEUE_ALL);
+  uint16_t publish(const char* topic, uint8_t qos, bool retain, espMqttClientTypes::PayloadCallback callback, size_t length,
+                   const espMqttClientTypes::PublishProperties* properties = nullptr,
+                   espMqttClientTypes::PublishMode mode = espMqttClientTypes::PublishMode::QUEUE_ALL);
+  // 'writer' has to write exactly 'length' bytes, it is called once before publish returns
+  uint16_t publish(const char* topic, uint8_t qos, bool retain, espMqttClientTypes::PayloadWriter writer, size_t length,
+                   const espMqttClientTypes::PublishProperties* properties = nullptr,
+                   espMqttClientTypes::PublishMode mode = espMqttClientTypes::PublishMode::QUEUE_ALL);
   void clearQueue(bool deleteSessionData = false);  // Not MQTT compliant and may cause unpredictable results when `deleteSessionData` = true!
   const char* getClientId() const;
+  uint16_t topicAliasCount() const;
   size_t queueSize();  // No const because of mutex
+  size_t queueHighWaterMark();
+  void resetQueueHighWaterMark();
+  // publishes are refused once the queue holds 'capacity' packets, unless they replace a queued one in PublishMode::LAST_VALUE
+  void setQueueCapacity(size_t capacity);
+  size_t queueCapacity();
   void loop();
 
  protected:
@@ -98,6 +125,7 @@ class MqttClient {
   uint8_t _willQos;
   bool _willRetain;
   uint32_t _timeout;
+  espMqttClientTypes::ProtocolVersion _protocolVersion;
 
   // state is protected to allow state changes by the transport system, defined in child classes
   // eg. to allow AsyncTCP
@@ -146,7 +174,49 @@ class MqttClient {
   bool _pingSent;
   espMqttClientTypes::DisconnectReason _disconnectReason;
 
+  // MQTT 5 topic aliases, alias n maps to _topicAliases[n - 1]
+  // topics become alias candidates when published and get an alias once published EMC_TOPIC_ALIAS_THRESHOLD times
+  // while they're still a candidate. Aliases are valid for a single connection.
+  struct TopicAliasCandidate {
+    uint32_t hash;
+    uint16_t count;
+  };
+  char* _topicAliases[EMC_MAX_TOPIC_ALIASES];
+  uint16_t _topicAliasMaximum;
+  uint16_t _topicAliasCount;
+  TopicAliasCandidate _topicAliasCandidates[EMC_TOPIC_ALIAS_CANDIDATES];
+
   uint16_t _getNextPacketId();
+  uint16_t _getPublishPacketId(const espMqttClientInternals::Outbox<OutgoingPacket>::Iterator& queued, uint8_t qos);
+  uint16_t _getTopicAlias(const char* topic, bool* known);
+  void _clearTopicAliases();
+  bool _publishesTo(const espMqttClientInternals::Packet& packet, const char* topic) const;
+  espMqttClientInternals::Outbox<OutgoingPacket>::Iterator _findUnsentPublish(const char* topic, bool retain);
+  // publishes a payload that is copied or written into the packet, 'payload' is a buffer or a PayloadWriter
+  template <typename TPayload>
+  uint16_t _publish(const char* topic, uint8_t qos, bool retain, TPayload payload, size_t length,
+                    const espMqttClientTypes::PublishProperties* properties, espMqttClientTypes::PublishMode mode);
+
+  static void _fillList(espMqttClientTypes::SubscribeItem* list) {
+    (void) list;
+  }
+
+  template <typename... Args>
+  static void _fillList(espMqttClientTypes::SubscribeItem* list, const char* topic, uint8_t qos, Args&&... args) {
+    list->topic = topic;
+    list->qos = qos;
+    _fillList(list + 1, std::forward<Args>(args) ...);
+  }
+
+  static void _fillList(const char** list) {
+    (void) list;
+  }
+
+  template <typename... Args>
+  static void _fillList(const char** list, const char* topic, Args&&... args) {
+    *list = topic;
+    _fillList(list + 1, std::forward<Args>(args) ...);
+  }
 
   template <typename... Args>
   bool _addPacket(Args&&... args) {
@@ -160,6 +230,19 @@ class MqttClient {
     }
   }
 
+  // replaces the packet at 'it' in place, the packet is removed if the new one can't be created
+  template <typename... Args>
+  bool _replacePacket(espMqttClientInternals::Outbox<OutgoingPacket>::Iterator& it, Args&&... args) {  // NOLINT(runtime/references)
+    espMqttClientTypes::Error error(espMqttClientTypes::Error::SUCCESS);
+    _outbox.replace(it, 0, error, std::forward<Args>(args) ...);
+    if (error == espMqttClientTypes::Error::SUCCESS) {
+      return true;
+    } else {
+      _outbox.remove(it);
+      return false;
+    }
+  }
+
   template <typename... Args>
   bool _addPacketFront(Args&&... args) {
     espMqttClientTypes::Error error(espMqttClientTypes::Error::SUCCESS);
@@ -187,6 +270,7 @@ class MqttClient {
   void _onPubcomp();
   void _onSuback();
   void _onUnsuback();
+  void _onDisconnect();
 
   void _clearQueue(int clearData);  // 0: keep session,
                                     // 1: keep only PUBLISH qos > 0
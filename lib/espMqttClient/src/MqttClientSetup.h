@@ -59,6 +59,12 @@ class MqttClientSetup : public MqttClient {
     return setWill(topic, qos, retain, reinterpret_cast<const uint8_t*>(payload), strlen(payload));
   }
 
+  // takes effect on the next connect
+  T& setProtocolVersion(espMqttClientTypes::ProtocolVersion version) {
+    _protocolVersion = version;
+    return static_cast<T&>(*this);
+  }
+
   T& setServer(IPAddress ip, uint16_t port) {
     _ip = ip;
     _port = port;
@@ -9,12 +9,13 @@ the LICENSE file.
 
 #pragma once
 
-#if EMC_USE_MEMPOOL
+#include "Config.h"
+#if EMC_OUTBOX_POOL_ELEMENTS > 0
   #include "MemoryPool/src/MemoryPool.h"
-  #include "Config.h"
 #else
   #include <new>  // new (std::nothrow)
 #endif
+#include <stddef.h>  // size_t
 #include <utility>  // std::forward
 
 namespace espMqttClientInternals {
@@ -24,6 +25,8 @@ namespace espMqttClientInternals {
  * 
  * Queue items can only be emplaced, at front and back of the queue.
  * Remove items using an iterator or the builtin iterator.
+ * The capacity is advisory: emplacing only fails when memory (or the pool) is exhausted,
+ * it's up to the user to check full() before adding items that may be refused.
  */
 
 template <typename T>
@@ -34,14 +37,17 @@ class Outbox {
   , _last(nullptr)
   , _current(nullptr)
   , _prev(nullptr)
-  #if EMC_USE_MEMPOOL
+  , _size(0)
+  , _highWaterMark(0)
+  , _capacity(EMC_OUTBOX_POOL_ELEMENTS)
+  #if EMC_OUTBOX_POOL_ELEMENTS > 0
   , _memPool()
   #endif
   {}
   ~Outbox() {
     while (_first) {
       Node* n = _first->next;
-      #if EMC_USE_MEMPOOL
+      #if EMC_OUTBOX_POOL_ELEMENTS > 0
       _first->~Node();
       _memPool.free(_first);
       #else
@@ -93,7 +99,7 @@ class Outbox {
   template <class... Args>
   Iterator emplace(Args&&... args) {
     Iterator it;
-    #if EMC_USE_MEMPOOL
+    #if EMC_OUTBOX_POOL_ELEMENTS > 0
     void* buf = _memPool.malloc();
     Node* node = nullptr;
     if (buf) {
@@ -117,6 +123,7 @@ class Outbox {
       if (!_current) {
         _current = _last;
       }
+      _grow();
     }
     return it;
   }
@@ -125,7 +132,7 @@ class Outbox {
   template <class... Args>
   Iterator emplaceFront(Args&&... args) {
     Iterator it;
-    #if EMC_USE_MEMPOOL
+    #if EMC_OUTBOX_POOL_ELEMENTS > 0
     void* buf = _memPool.malloc();
     Node* node = nullptr;
     if (buf) {
@@ -145,10 +152,19 @@ class Outbox {
       _current = _first = node;
       _prev = nullptr;
       it._node = node;
+      _grow();
     }
     return it;
   }
 
+  // replace item at iterator, the item keeps its place in the queue
+  template <class... Args>
+  void replace(Iterator& it, Args&&... args) {  // NOLINT(runtime/references)
+    if (!it) return;
+    it._node->data.~T();
+    new(&(it._node->data)) T(std::forward<Args>(args) ...);
+  }
+
   // remove node at iterator, iterator points to next
   void remove(Iterator& it) {  // NOLINT(runtime/references)
     if (!it) return;
@@ -179,6 +195,14 @@ class Outbox {
     return it;
   }
 
+  // Iterator pointing to current item, items from here onwards have not been handled yet
+  Iterator current() const {
+    Iterator it;
+    it._node = _current;
+    it._prev = _prev;
+    return it;
+  }
+
   // Advance current item
   void next() {
     if (_current) {
@@ -194,13 +218,32 @@ class Outbox {
   }
 
   size_t size() const {
-    Node* n = _first;
-    size_t count = 0;
-    while (n) {
-      n = n->next;
-      ++count;
-    }
-    return count;
+    return _size;
+  }
+
+  // Largest size since creation or since the last reset
+  size_t highWaterMark() const {
+    return _highWaterMark;
+  }
+
+  void resetHighWaterMark() {
+    _highWaterMark = _size;
+  }
+
+  // 0 means unlimited, when using a pool the capacity is limited to the pool size
+  void setCapacity(size_t capacity) {
+    #if EMC_OUTBOX_POOL_ELEMENTS > 0
+    if (capacity == 0 || capacity > EMC_OUTBOX_POOL_ELEMENTS) capacity = EMC_OUTBOX_POOL_ELEMENTS;
+    #endif
+    _capacity = capacity;
+  }
+
+  size_t capacity() const {
+    return _capacity;
+  }
+
+  bool full() const {
+    return _capacity > 0 && _size >= _capacity;
   }
 
  private:
@@ -208,10 +251,18 @@ class Outbox {
   Node* _last;
   Node* _current;
   Node* _prev;  // element just before _current
-  #if EMC_USE_MEMPOOL
-  MemoryPool::Fixed<EMC_NUM_POOL_ELEMENTS, sizeof(Node)> _memPool;
+  size_t _size;
+  size_t _highWaterMark;
+  size_t _capacity;
+  #if EMC_OUTBOX_POOL_ELEMENTS > 0
+  MemoryPool::Fixed<EMC_OUTBOX_POOL_ELEMENTS, sizeof(Node)> _memPool;
   #endif
 
+  void _grow() {
+    ++_size;
+    if (_size > _highWaterMark) _highWaterMark = _size;
+  }
+
   void _remove(Node* prev, Node* node) {
     if (!node) return;
 
@@ -243,12 +294,13 @@ class Outbox {
     }
 
     // finally, delete the node
-      #if EMC_USE_MEMPOOL
+      #if EMC_OUTBOX_POOL_ELEMENTS > 0
       node->~Node();
       _memPool.free(node);
       #else
       delete node;
       #endif
+    --_size;
   }
 };
 
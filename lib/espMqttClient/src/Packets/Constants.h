@@ -17,6 +17,7 @@ namespace espMqttClientInternals {
 
 constexpr const char PROTOCOL[] = "MQTT";
 constexpr const uint8_t PROTOCOL_LEVEL = 0b00000100;
+constexpr const uint8_t PROTOCOL_LEVEL_5 = 0b00000101;
 
 typedef uint8_t MQTTPacketType;
 
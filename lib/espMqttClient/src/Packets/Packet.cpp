@@ -15,11 +15,7 @@ MemoryPool::Variable<EMC_NUM_POOL_ELEMENTS, EMC_SIZE_POOL_ELEMENTS> Packet::_mem
 #endif
 
 Packet::~Packet() {
-  #if EMC_USE_MEMPOOL
-  _memPool.free(_data);
-  #else
-  free(_data);
-  #endif
+  _free(_data);
 }
 
 size_t Packet::available(size_t index) {
@@ -63,6 +59,64 @@ bool Packet::removable() const {
   return false;
 }
 
+bool Packet::retain() const {
+  if (packetType() != PacketType.PUBLISH) return false;
+  return (_data[0] & 0x01) != 0;
+}
+
+bool Packet::hasTopic(const char* topic) const {
+  if (packetType() != PacketType.PUBLISH) return false;
+  size_t pos = 1 + remainingLengthLength(decodeRemainingLength(&_data[1]));
+  size_t topicLength = (_data[pos] << 8) | _data[pos + 1];
+  if (strlen(topic) != topicLength) return false;
+  return memcmp(&_data[pos + 2], topic, topicLength) == 0;
+}
+
+uint16_t Packet::topicAlias() const {
+  return _topicAlias;
+}
+
+bool Packet::expandTopicAlias(const char* topic) {
+  if (_topicAlias == 0) return true;
+
+  // layout: header, remaining length, empty topic, [packet ID], property length, topic alias (3 bytes), other properties, payload
+  uint8_t* oldData = _data;
+  size_t oldSize = _size;
+  size_t oldRemainingLength = decodeRemainingLength(&oldData[1]);
+  size_t pos = 1 + remainingLengthLength(oldRemainingLength) + 2 + (_packetId != 0 ? 2 : 0);
+  size_t oldPropertiesLength = decodeRemainingLength(&oldData[pos]);
+  size_t propertiesIndex = pos + remainingLengthLength(oldPropertiesLength) + 3;
+  size_t propertiesLength = oldPropertiesLength - 3;
+  size_t payloadIndex = propertiesIndex + propertiesLength;
+
+  size_t remainingLength =
+    2 + strlen(topic) +
+    (_packetId != 0 ? 2 : 0) +
+    remainingLengthLength(propertiesLength) + propertiesLength +
+    oldSize - payloadIndex;
+
+  if (!_allocate(remainingLength, true)) {
+    _data = oldData;
+    _size = oldSize;
+    return false;
+  }
+
+  pos = 0;
+  _data[pos++] = oldData[0];
+  pos += encodeRemainingLength(remainingLength, &_data[pos]);
+  pos += encodeString(topic, &_data[pos]);
+  if (_packetId != 0) {
+    _data[pos++] = _packetId >> 8;
+    _data[pos++] = _packetId & 0xFF;
+  }
+  pos += encodeRemainingLength(propertiesLength, &_data[pos]);
+  memcpy(&_data[pos], &oldData[propertiesIndex], oldSize - propertiesIndex);
+
+  _free(oldData);
+  _topicAlias = 0;
+  return true;
+}
+
 Packet::Packet(espMqttClientTypes::Error& error,
                bool cleanSession,
                const char* username,
@@ -73,10 +127,12 @@ Packet::Packet(espMqttClientTypes::Error& error,
                const uint8_t* willPayload,
                uint16_t willPayloadLength,
                uint16_t keepAlive,
-               const char* clientId)
+               const char* clientId,
+               ProtocolVersion version)
 : _packetId(0)
 , _data(nullptr)
 , _size(0)
+, _topicAlias(0)
 , _payloadIndex(0)
 , _payloadStartIndex(0)
 , _payloadEndIndex(0)
@@ -96,14 +152,19 @@ Packet::Packet(espMqttClientTypes::Error& error,
     return;
   }
 
+  // MQTT 5 has no clean session flag to keep the session after disconnecting, set a session expiry instead
+  bool v5 = version == ProtocolVersion::V5;
+  size_t propertiesLength = (v5 && !cleanSession) ? 1 + 4 : 0;
+
   // Calculate size
   size_t remainingLength =
   6 +  // protocol
   1 +  // protocol level
   1 +  // connect flags
   2 +  // keepalive
+  (v5 ? 1 + propertiesLength : 0) +
   2 + strlen(clientId) +
-  (willTopic ? 2 + strlen(willTopic) + 2 + willPayloadLength : 0) +
+  (willTopic ? (v5 ? 1 : 0) + 2 + strlen(willTopic) + 2 + willPayloadLength : 0) +
   (username ? 2 + strlen(username) : 0) +
   (password ? 2 + strlen(password) : 0);
 
@@ -120,7 +181,7 @@ Packet::Packet(espMqttClientTypes::Error& error,
   _data[pos++] = PacketType.CONNECT | HeaderFlag.CONNECT_RESERVED;
   pos += encodeRemainingLength(remainingLength, &_data[pos]);
   pos += encodeString(PROTOCOL, &_data[pos]);
-  _data[pos++] = PROTOCOL_LEVEL;
+  _data[pos++] = v5 ? PROTOCOL_LEVEL_5 : PROTOCOL_LEVEL;
   uint8_t connectFlags = 0;
   if (cleanSession) connectFlags |= espMqttClientInternals::ConnectFlag.CLEAN_SESSION;
   if (username != nullptr) connectFlags |= espMqttClientInternals::ConnectFlag.USERNAME;
@@ -143,12 +204,23 @@ Packet::Packet(espMqttClientTypes::Error& error,
   _data[pos++] = connectFlags;
   _data[pos++] = keepAlive >> 8;
   _data[pos++] = keepAlive & 0xFF;
+  if (v5) {
+    _data[pos++] = propertiesLength;
+    if (propertiesLength > 0) {
+      _data[pos++] = PropertyId.SESSION_EXPIRY_INTERVAL;
+      _data[pos++] = static_cast<uint32_t>(EMC_SESSION_EXPIRY_INTERVAL) >> 24;
+      _data[pos++] = (static_cast<uint32_t>(EMC_SESSION_EXPIRY_INTERVAL) >> 16) & 0xFF;
+      _data[pos++] = (static_cast<uint32_t>(EMC_SESSION_EXPIRY_INTERVAL) >> 8) & 0xFF;
+      _data[pos++] = static_cast<uint32_t>(EMC_SESSION_EXPIRY_INTERVAL) & 0xFF;
+    }
+  }
 
   // PAYLOAD
   // client ID
   pos += encodeString(clientId, &_data[pos]);
   // will
   if (willTopic != nullptr && willPayload != nullptr) {
+    if (v5) _data[pos++] = 0;  // no will properties
     pos += encodeString(willTopic, &_data[pos]);
     _data[pos++] = willPayloadLength >> 8;
     _data[pos++] = willPayloadLength & 0xFF;
@@ -172,6 +244,7 @@ Packet::Packet(espMqttClientTypes::Error& error,
 : _packetId(packetId)
 , _data(nullptr)
 , _size(0)
+, _topicAlias(0)
 , _payloadIndex(0)
 , _payloadStartIndex(0)
 , _payloadEndIndex(0)
@@ -193,8 +266,8 @@ Packet::Packet(espMqttClientTypes::Error& error,
 
   size_t pos = _fillPublishHeader(packetId, topic, remainingLength, qos, retain);
 
-  // PAYLOAD
-  memcpy(&_data[pos], payload, payloadLength);
+  // PAYLOAD, written by the caller when constructed from a PayloadWriter
+  if (payload) memcpy(&_data[pos], payload, payloadLength);
 
   error = espMqttClientTypes::Error::SUCCESS;
 }
@@ -209,13 +282,112 @@ Packet::Packet(espMqttClientTypes::Error& error,
 : _packetId(packetId)
 , _data(nullptr)
 , _size(0)
+, _topicAlias(0)
+, _payloadIndex(0)
+, _payloadStartIndex(0)
+, _payloadEndIndex(0)
+, _getPayload(payloadCallback) {
+  size_t remainingLength =
+    2 + strlen(topic) +  // topic length + topic
+    2 +                  // packet ID
+    payloadLength;
+
+  if (qos == 0) {
+    remainingLength -= 2;
+    _packetId = 0;
+  }
+
+  if (!_allocate(remainingLength - payloadLength + std::min(payloadLength, static_cast<size_t>(EMC_RX_BUFFER_SIZE)), true)) {
+    error = espMqttClientTypes::Error::OUT_OF_MEMORY;
+    return;
+  }
+
+  size_t pos = _fillPublishHeader(packetId, topic, remainingLength, qos, retain);
+
+  // payload will be added by 'Packet::available'
+  _size = pos + payloadLength;
+  _payloadIndex = pos;
+  _payloadStartIndex = _payloadIndex;
+  _payloadEndIndex = _payloadIndex;
+
+  error = espMqttClientTypes::Error::SUCCESS;
+}
+
+Packet::Packet(espMqttClientTypes::Error& error,
+               uint16_t packetId,
+               const char* topic,
+               const uint8_t* payload,
+               size_t payloadLength,
+               uint8_t qos,
+               bool retain,
+               uint16_t topicAlias,
+               const espMqttClientTypes::PublishProperties* properties)
+: _packetId(packetId)
+, _data(nullptr)
+, _size(0)
+, _topicAlias(0)
+, _payloadIndex(0)
+, _payloadStartIndex(0)
+, _payloadEndIndex(0)
+, _getPayload(nullptr) {
+  if (strlen(topic) == 0 && topicAlias == 0) {
+    error = espMqttClientTypes::Error::MALFORMED_PARAMETER;
+    return;
+  }
+
+  size_t remainingLength =
+    2 + strlen(topic) +  // topic length + topic
+    2 +                  // packet ID
+    publishPropertiesLength(topicAlias, properties) +
+    payloadLength;
+
+  if (qos == 0) {
+    remainingLength -= 2;
+    _packetId = 0;
+  }
+
+  if (!_allocate(remainingLength, true)) {
+    error = espMqttClientTypes::Error::OUT_OF_MEMORY;
+    return;
+  }
+
+  size_t pos = _fillPublishHeader(packetId, topic, remainingLength, qos, retain);
+  pos += encodePublishProperties(topicAlias, properties, &_data[pos]);
+  if (strlen(topic) == 0) _topicAlias = topicAlias;
+
+  // PAYLOAD, written by the caller when constructed from a PayloadWriter
+  if (payload) memcpy(&_data[pos], payload, payloadLength);
+
+  error = espMqttClientTypes::Error::SUCCESS;
+}
+
+Packet::Packet(espMqttClientTypes::Error& error,
+               uint16_t packetId,
+               const char* topic,
+               espMqttClientTypes::PayloadCallback payloadCallback,
+               size_t payloadLength,
+               uint8_t qos,
+               bool retain,
+               uint16_t topicAlias,
+               const espMqttClientTypes::PublishProperties* properties)
+: _packetId(packetId)
+, _data(nullptr)
+, _size(0)
+, _topicAlias(0)
 , _payloadIndex(0)
 , _payloadStartIndex(0)
 , _payloadEndIndex(0)
 , _getPayload(payloadCallback) {
+  // the header of a chunked packet can't be rewritten later on, so the topic is mandatory
+  if (strlen(topic) == 0) {
+    error = espMqttClientTypes::Error::MALFORMED_PARAMETER;
+    return;
+  }
+
   size_t remainingLength =
     2 + strlen(topic) +  // topic length + topic
     2 +                  // packet ID
+    publishPropertiesLength(topicAlias, properties) +
     payloadLength;
 
   if (qos == 0) {
@@ -229,6 +401,7 @@ Packet::Packet(espMqttClientTypes::Error& error,
   }
 
   size_t pos = _fillPublishHeader(packetId, topic, remainingLength, qos, retain);
+  pos += encodePublishProperties(topicAlias, properties, &_data[pos]);
 
   // payload will be added by 'Packet::available'
   _size = pos + payloadLength;
@@ -239,10 +412,35 @@ Packet::Packet(espMqttClientTypes::Error& error,
   error = espMqttClientTypes::Error::SUCCESS;
 }
 
+Packet::Packet(espMqttClientTypes::Error& error,
+               uint16_t packetId,
+               const char* topic,
+               espMqttClientTypes::PayloadWriter payloadWriter,
+               size_t payloadLength,
+               uint8_t qos,
+               bool retain)
+: Packet(error, packetId, topic, static_cast<const uint8_t*>(nullptr), payloadLength, qos, retain) {
+  _writePayload(error, payloadWriter, payloadLength);
+}
+
+Packet::Packet(espMqttClientTypes::Error& error,
+               uint16_t packetId,
+               const char* topic,
+               espMqttClientTypes::PayloadWriter payloadWriter,
+               size_t payloadLength,
+               uint8_t qos,
+               bool retain,
+               uint16_t topicAlias,
+               const espMqttClientTypes::PublishProperties* properties)
+: Packet(error, packetId, topic, static_cast<const uint8_t*>(nullptr), payloadLength, qos, retain, topicAlias, properties) {
+  _writePayload(error, payloadWriter, payloadLength);
+}
+
 Packet::Packet(espMqttClientTypes::Error& error, uint16_t packetId, const char* topic, uint8_t qos)
 : _packetId(packetId)
 , _data(nullptr)
 , _size(0)
+, _topicAlias(0)
 , _payloadIndex(0)
 , _payloadStartIndex(0)
 , _payloadEndIndex(0)
@@ -251,10 +449,27 @@ Packet::Packet(espMqttClientTypes::Error& error, uint16_t packetId, const char*
   _createSubscribe(error, list, 1);
 }
 
+Packet::Packet(espMqttClientTypes::Error& error, uint16_t packetId, const SubscribeItem* list, size_t numberTopics, ProtocolVersion version)
+: _packetId(packetId)
+, _data(nullptr)
+, _size(0)
+, _topicAlias(0)
+, _payloadIndex(0)
+, _payloadStartIndex(0)
+, _payloadEndIndex(0)
+, _getPayload(nullptr) {
+  if (!list || numberTopics == 0) {
+    error = espMqttClientTypes::Error::MALFORMED_PARAMETER;
+    return;
+  }
+  _createSubscribe(error, list, numberTopics, version);
+}
+
 Packet::Packet(espMqttClientTypes::Error& error, MQTTPacketType type, uint16_t packetId)
 : _packetId(packetId)
 , _data(nullptr)
 , _size(0)
+, _topicAlias(0)
 , _payloadIndex(0)
 , _payloadStartIndex(0)
 , _payloadEndIndex(0)
@@ -282,6 +497,7 @@ Packet::Packet(espMqttClientTypes::Error& error, uint16_t packetId, const char*
 : _packetId(packetId)
 , _data(nullptr)
 , _size(0)
+, _topicAlias(0)
 , _payloadIndex(0)
 , _payloadStartIndex(0)
 , _payloadEndIndex(0)
@@ -290,10 +506,27 @@ Packet::Packet(espMqttClientTypes::Error& error, uint16_t packetId, const char*
   _createUnsubscribe(error, list, 1);
 }
 
+Packet::Packet(espMqttClientTypes::Error& error, uint16_t packetId, const char** list, size_t numberTopics, ProtocolVersion version)
+: _packetId(packetId)
+, _data(nullptr)
+, _size(0)
+, _topicAlias(0)
+, _payloadIndex(0)
+, _payloadStartIndex(0)
+, _payloadEndIndex(0)
+, _getPayload(nullptr) {
+  if (!list || numberTopics == 0) {
+    error = espMqttClientTypes::Error::MALFORMED_PARAMETER;
+    return;
+  }
+  _createUnsubscribe(error, list, numberTopics, version);
+}
+
 Packet::Packet(espMqttClientTypes::Error& error, MQTTPacketType type)
 : _packetId(0)
 , _data(nullptr)
 , _size(0)
+, _topicAlias(0)
 , _payloadIndex(0)
 , _payloadStartIndex(0)
 , _payloadEndIndex(0)
@@ -362,15 +595,26 @@ size_t Packet::_fillPublishHeader(uint16_t packetId,
   return index;
 }
 
+void Packet::_writePayload(espMqttClientTypes::Error& error, espMqttClientTypes::PayloadWriter payloadWriter, size_t payloadLength) {
+  if (error != espMqttClientTypes::Error::SUCCESS) return;
+  // the payload is the last part of the packet
+  if (payloadWriter(&_data[_size - payloadLength], payloadLength) != payloadLength) {
+    emc_log_w("Payload writer didn't fill the payload");
+    error = espMqttClientTypes::Error::MALFORMED_PARAMETER;
+  }
+}
+
 void Packet::_createSubscribe(espMqttClientTypes::Error& error,
-                              SubscribeItem* list,
-                              size_t numberTopics) {
+                              const SubscribeItem* list,
+                              size_t numberTopics,
+                              ProtocolVersion version) {
   // Calculate size
   size_t payload = 0;
   for (size_t i = 0; i < numberTopics; ++i) {
     payload += 2 + strlen(list[i].topic) + 1;  // length bytes, string, qos
   }
-  size_t remainingLength = 2 + payload;  // packetId + payload
+  bool v5 = version == ProtocolVersion::V5;
+  size_t remainingLength = 2 + (v5 ? 1 : 0) + payload;  // packetId + [property length] + payload
 
   // allocate memory
   if (!_allocate(remainingLength, true)) {
@@ -384,6 +628,7 @@ void Packet::_createSubscribe(espMqttClientTypes::Error& error,
   pos += encodeRemainingLength(remainingLength, &_data[pos]);
   _data[pos++] = _packetId >> 8;
   _data[pos++] = _packetId & 0xFF;
+  if (v5) _data[pos++] = 0;  // no properties
   for (size_t i = 0; i < numberTopics; ++i) {
     pos += encodeString(list[i].topic, &_data[pos]);
     _data[pos++] = list[i].qos;
@@ -394,13 +639,15 @@ void Packet::_createSubscribe(espMqttClientTypes::Error& error,
 
 void Packet::_createUnsubscribe(espMqttClientTypes::Error& error,
                                 const char** list,
-                                size_t numberTopics) {
+                                size_t numberTopics,
+                                ProtocolVersion version) {
   // Calculate size
   size_t payload = 0;
   for (size_t i = 0; i < numberTopics; ++i) {
     payload += 2 + strlen(list[i]);  // length bytes, string
   }
-  size_t remainingLength = 2 + payload;  // packetId + payload
+  bool v5 = version == ProtocolVersion::V5;
+  size_t remainingLength = 2 + (v5 ? 1 : 0) + payload;  // packetId + [property length] + payload
 
   // allocate memory
   if (!_allocate(remainingLength, true)) {
@@ -414,6 +661,7 @@ void Packet::_createUnsubscribe(espMqttClientTypes::Error& error,
   pos += encodeRemainingLength(remainingLength, &_data[pos]);
   _data[pos++] = _packetId >> 8;
   _data[pos++] = _packetId & 0xFF;
+  if (v5) _data[pos++] = 0;  // no properties
   for (size_t i = 0; i < numberTopics; ++i) {
     pos += encodeString(list[i], &_data[pos]);
   }
@@ -421,6 +669,14 @@ void Packet::_createUnsubscribe(espMqttClientTypes::Error& error,
   error = espMqttClientTypes::Error::SUCCESS;
 }
 
+void Packet::_free(uint8_t* data) {
+  #if EMC_USE_MEMPOOL
+  _memPool.free(data);
+  #else
+  free(data);
+  #endif
+}
+
 size_t Packet::_chunkedAvailable(size_t index) {
   // index vs size check done in 'available(index)'
 
@@ -18,6 +18,7 @@ the LICENSE file.
 #include "../Logging.h"
 #include "RemainingLength.h"
 #include "StringUtil.h"
+#include "Properties.h"
 
 #if EMC_USE_MEMPOOL
   #include "MemoryPool/src/MemoryPool.h"
@@ -36,11 +37,20 @@ class Packet {
   uint16_t packetId() const;
   MQTTPacketType packetType() const;
   bool removable() const;
+  // PUBLISH: retain flag is set
+  bool retain() const;
+  // PUBLISH: packet carries 'topic', packets sent by topic alias only carry an empty topic
+  bool hasTopic(const char* topic) const;
+  // MQTT 5: topic alias of a PUBLISH packet sent without topic, 0 otherwise
+  uint16_t topicAlias() const;
+  // MQTT 5: rewrites a PUBLISH packet sent without topic to carry the full topic and no alias
+  bool expandTopicAlias(const char* topic);
 
  protected:
   uint16_t _packetId;  // save as separate variable: will be accessed frequently
   uint8_t* _data;
   size_t _size;
+  uint16_t _topicAlias;
 
   // variables for chunked payload handling
   size_t _payloadIndex;
@@ -48,10 +58,8 @@ class Packet {
   size_t _payloadEndIndex;
   espMqttClientTypes::PayloadCallback _getPayload;
 
-  struct SubscribeItem {
-    const char* topic;
-    uint8_t qos;
-  };
+  typedef espMqttClientTypes::SubscribeItem SubscribeItem;
+  typedef espMqttClientTypes::ProtocolVersion ProtocolVersion;
 
  public:
   // CONNECT
@@ -65,7 +73,8 @@ class Packet {
          const uint8_t* willPayload,
          uint16_t willPayloadLength,
          uint16_t keepAlive,
-         const char* clientId);
+         const char* clientId,
+         ProtocolVersion version = ProtocolVersion::V3_1_1);
   // PUBLISH
   Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
          uint16_t packetId,
@@ -81,6 +90,42 @@ class Packet {
          size_t payloadLength,
          uint8_t qos,
          bool retain);
+  // PUBLISH, the payload is written by 'payloadWriter' once while the packet is constructed
+  Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
+         uint16_t packetId,
+         const char* topic,
+         espMqttClientTypes::PayloadWriter payloadWriter,
+         size_t payloadLength,
+         uint8_t qos,
+         bool retain);
+  // PUBLISH (MQTT 5), pass an empty topic to publish by topic alias only
+  Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
+         uint16_t packetId,
+         const char* topic,
+         const uint8_t* payload,
+         size_t payloadLength,
+         uint8_t qos,
+         bool retain,
+         uint16_t topicAlias,
+         const espMqttClientTypes::PublishProperties* properties);
+  Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
+         uint16_t packetId,
+         const char* topic,
+         espMqttClientTypes::PayloadCallback payloadCallback,
+         size_t payloadLength,
+         uint8_t qos,
+         bool retain,
+         uint16_t topicAlias,
+         const espMqttClientTypes::PublishProperties* properties);
+  Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
+         uint16_t packetId,
+         const char* topic,
+         espMqttClientTypes::PayloadWriter payloadWriter,
+         size_t payloadLength,
+         uint8_t qos,
+         bool retain,
+         uint16_t topicAlias,
+         const espMqttClientTypes::PublishProperties* properties);
   // SUBSCRIBE
   Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
          uint16_t packetId,
@@ -97,6 +142,7 @@ class Packet {
   : _packetId(packetId)
   , _data(nullptr)
   , _size(0)
+  , _topicAlias(0)
   , _payloadIndex(0)
   , _payloadStartIndex(0)
   , _payloadEndIndex(0)
@@ -106,6 +152,11 @@ class Packet {
     SubscribeItem list[numberTopics] = {topic1, qos1, topic2, qos2, args...};
     _createSubscribe(error, list, numberTopics);
   }
+  Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
+         uint16_t packetId,
+         const SubscribeItem* list,
+         size_t numberTopics,
+         ProtocolVersion version = ProtocolVersion::V3_1_1);
   // UNSUBSCRIBE
   Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
          uint16_t packetId,
@@ -119,6 +170,7 @@ class Packet {
   : _packetId(packetId)
   , _data(nullptr)
   , _size(0)
+  , _topicAlias(0)
   , _payloadIndex(0)
   , _payloadStartIndex(0)
   , _payloadEndIndex(0)
@@ -127,6 +179,11 @@ class Packet {
     const char* list[numberTopics] = {topic1, topic2, args...};
     _createUnsubscribe(error, list, numberTopics);
   }
+  Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
+         uint16_t packetId,
+         const char** list,
+         size_t numberTopics,
+         ProtocolVersion version = ProtocolVersion::V3_1_1);
   // PUBACK, PUBREC, PUBREL, PUBCOMP
   Packet(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
          MQTTPacketType type,
@@ -145,12 +202,19 @@ class Packet {
                             size_t remainingLength,
                             uint8_t qos,
                             bool retain);
+  // lets 'payloadWriter' fill the payload of a PUBLISH packet constructed without payload
+  void _writePayload(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
+                     espMqttClientTypes::PayloadWriter payloadWriter,
+                     size_t payloadLength);
   void _createSubscribe(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
-                        SubscribeItem* list,
-                        size_t numberTopics);
+                        const SubscribeItem* list,
+                        size_t numberTopics,
+                        ProtocolVersion version = ProtocolVersion::V3_1_1);
   void _createUnsubscribe(espMqttClientTypes::Error& error,  // NOLINT(runtime/references)
                           const char** list,
-                          size_t numberTopics);
+                          size_t numberTopics,
+                          ProtocolVersion version = ProtocolVersion::V3_1_1);
+  void _free(uint8_t* data);
 
   size_t _chunkedAvailable(size_t index);
   const uint8_t* _chunkedData(size_t index) const;
@@ -29,6 +29,8 @@ void IncomingPacket::reset() {
   fixedHeader.packetType = 0;
   variableHeader.topicLength = 0;
   variableHeader.fixed.packetId = 0;
+  variableHeader.reasonCode = 0;
+  properties.reset();
   payload.index = 0;
   payload.length = 0;
 }
@@ -40,7 +42,13 @@ Parser::Parser()
 , _bytePos(0)
 , _parse(_fixedHeader)
 , _packet()
-, _payloadBuffer{0} {
+, _payloadBuffer{0}
+, _protocolVersion(espMqttClientTypes::ProtocolVersion::V3_1_1)
+, _propertiesLength(0)
+, _propertiesLengthLength(0)
+, _propertiesPos(0)
+, _propertiesBuffer{0}
+, _propertiesStrings{0} {
   // empty
 }
 
@@ -68,6 +76,10 @@ void Parser::reset() {
   _packet.reset();
 }
 
+void Parser::setProtocolVersion(espMqttClientTypes::ProtocolVersion version) {
+  _protocolVersion = version;
+}
+
 ParserResult Parser::_fixedHeader(Parser* p) {
   p->_packet.reset();
   p->_packet.fixedHeader.packetType = p->_data[p->_bytesRead];
@@ -94,6 +106,7 @@ ParserResult Parser::_fixedHeader(Parser* p) {
       return ParserResult::protocolError;
     }
   } else {
+    bool v5 = p->_protocolVersion == espMqttClientTypes::ProtocolVersion::V5;
     switch (p->_packet.fixedHeader.packetType) {
       case PacketType.CONNACK | HeaderFlag.CONNACK_RESERVED:
       case PacketType.PUBACK | HeaderFlag.PUBACK_RESERVED:
@@ -101,7 +114,12 @@ ParserResult Parser::_fixedHeader(Parser* p) {
       case PacketType.PUBREL | HeaderFlag.PUBREL_RESERVED:
       case PacketType.PUBCOMP | HeaderFlag.PUBCOMP_RESERVED:
       case PacketType.UNSUBACK | HeaderFlag.UNSUBACK_RESERVED:
-        p->_parse = _remainingLengthFixed;
+        if (v5) {
+          p->_parse = _remainingLengthVariable;
+          p->_bytePos = 0;
+        } else {
+          p->_parse = _remainingLengthFixed;
+        }
         break;
       case PacketType.SUBACK | HeaderFlag.SUBACK_RESERVED:
         p->_parse = _remainingLengthVariable;
@@ -110,6 +128,14 @@ ParserResult Parser::_fixedHeader(Parser* p) {
       case PacketType.PINGRESP | HeaderFlag.PINGRESP_RESERVED:
         p->_parse = _remainingLengthNone;
         break;
+      case PacketType.DISCONNECT | HeaderFlag.DISCONNECT_RESERVED:
+        if (v5) {
+          p->_parse = _remainingLengthVariable;
+          p->_bytePos = 0;
+          break;
+        }
+        emc_log_w("Invalid packet header: 0x%02x", p->_packet.fixedHeader.packetType);
+        return ParserResult::protocolError;
       default:
         emc_log_w("Invalid packet header: 0x%02x", p->_packet.fixedHeader.packetType);
         return ParserResult::protocolError;
@@ -151,13 +177,43 @@ ParserResult Parser::_remainingLengthVariable(Parser* p) {
   // no need to check for negative decoded length, check is already done
   p->_packet.fixedHeader.remainingLength.remainingLength = decodeRemainingLength(p->_packet.fixedHeader.remainingLength.remainingLengthRaw);
 
-  if ((p->_packet.fixedHeader.packetType & 0xF0) == PacketType.PUBLISH) {
+  MQTTPacketType packetType = p->_packet.fixedHeader.packetType & 0xF0;
+  size_t remainingLength = p->_packet.fixedHeader.remainingLength.remainingLength;
+  if (packetType == PacketType.PUBLISH) {
     p->_parse = _varHeaderTopicLength1;
-    emc_log_i("Remaining length: %zu", p->_packet.fixedHeader.remainingLength.remainingLength);
+    emc_log_i("Remaining length: %zu", remainingLength);
     return ParserResult::awaitData;
+  } else if (p->_protocolVersion == espMqttClientTypes::ProtocolVersion::V5) {
+    // the payload length of SUBACK and UNSUBACK is checked once the properties are known
+    bool valid = false;
+    if (packetType == PacketType.CONNACK) {
+      valid = remainingLength >= 3;  // flags, reason code, property length
+      p->_parse = _varHeaderConnack1;
+    } else if (packetType == PacketType.DISCONNECT) {
+      if (remainingLength == 0) {
+        p->_parse = _fixedHeader;
+        emc_log_i("Packet complete");
+        return ParserResult::packet;
+      }
+      valid = true;
+      p->_parse = _varHeaderReasonCode;
+    } else if (packetType == PacketType.SUBACK || packetType == PacketType.UNSUBACK) {
+      valid = remainingLength >= 4;  // packet ID, property length, reason code
+      p->_packet.payload.data = p->_payloadBuffer;
+      p->_packet.payload.total = remainingLength - 2;
+      p->_parse = _varHeaderPacketId1;
+    } else {
+      valid = remainingLength >= 2;  // packet ID
+      p->_parse = _varHeaderPacketId1;
+    }
+    if (valid) {
+      emc_log_i("Remaining length: %zu", remainingLength);
+      return ParserResult::awaitData;
+    }
+    emc_log_w("Invalid remaining length: %zu", remainingLength);
   } else {
     int32_t payloadSize = p->_packet.fixedHeader.remainingLength.remainingLength - 2;  // total - packet ID
-    if (0 < payloadSize && payloadSize < EMC_PAYLOAD_BUFFER_SIZE) {
+    if (0 < payloadSize && payloadSize <= EMC_PAYLOAD_BUFFER_SIZE) {
       p->_bytePos = 0;
       p->_packet.payload.data = p->_payloadBuffer;
       p->_packet.payload.index = 0;
@@ -200,6 +256,16 @@ ParserResult Parser::_varHeaderConnack1(Parser* p) {
 ParserResult Parser::_varHeaderConnack2(Parser* p) {
   uint8_t data = p->_data[p->_bytesRead];
   p->_parse = _fixedHeader;
+  if (p->_protocolVersion == espMqttClientTypes::ProtocolVersion::V5) {
+    if (data == 0x00 || data >= 0x80) {  // success or error reason code
+      p->_packet.variableHeader.fixed.connackVarHeader.returnCode = data;
+      p->_parse = _propertyLength;
+      p->_bytePos = 0;
+      return ParserResult::awaitData;
+    }
+    emc_log_w("Invalid connack reason code");
+    return ParserResult::protocolError;
+  }
   if (data <= 5) {  // connect return code max is 5
     p->_packet.variableHeader.fixed.connackVarHeader.returnCode = data;
     emc_log_i("Packet complete");
@@ -220,10 +286,25 @@ ParserResult Parser::_varHeaderPacketId2(Parser* p) {
   p->_parse = _fixedHeader;
   if (p->_packet.variableHeader.fixed.packetId != 0) {
     emc_log_i("Packet variable header complete");
-    if ((p->_packet.fixedHeader.packetType & 0xF0) == PacketType.SUBACK) {
+    MQTTPacketType packetType = p->_packet.fixedHeader.packetType & 0xF0;
+    if (p->_protocolVersion == espMqttClientTypes::ProtocolVersion::V5) {
+      if (packetType == PacketType.PUBLISH) {
+        p->_packet.payload.total -= 2;  // substract packet id length from payload
+      }
+      if (packetType == PacketType.PUBLISH || packetType == PacketType.SUBACK || packetType == PacketType.UNSUBACK) {
+        p->_parse = _propertyLength;
+        p->_bytePos = 0;
+        return ParserResult::awaitData;
+      } else if (p->_packet.fixedHeader.remainingLength.remainingLength > 2) {
+        p->_parse = _varHeaderReasonCode;
+        return ParserResult::awaitData;
+      }
+      return ParserResult::packet;
+    }
+    if (packetType == PacketType.SUBACK) {
       p->_parse = _payloadSuback;
       return ParserResult::awaitData;
-    } else if ((p->_packet.fixedHeader.packetType & 0xF0) == PacketType.PUBLISH) {
+    } else if (packetType == PacketType.PUBLISH) {
       p->_packet.payload.total -= 2;  // substract packet id length from payload
       if (p->_packet.payload.total == 0) {
         p->_parse = _fixedHeader;
@@ -257,6 +338,10 @@ ParserResult Parser::_varHeaderTopicLength2(Parser* p) {
     p->_parse = _varHeaderTopic;
     p->_bytePos = 0;
     p->_packet.payload.total = p->_packet.fixedHeader.remainingLength.remainingLength - 2 - p->_packet.variableHeader.topicLength;
+    if (p->_packet.variableHeader.topicLength == 0) {  // MQTT 5 topic alias
+      p->_packet.variableHeader.topic[0] = 0x00;
+      return _varHeaderTopicComplete(p);
+    }
     return ParserResult::awaitData;
   }
   emc_log_w("Invalid topic length: %u > %zu", p->_packet.variableHeader.topicLength, maxTopicLength);
@@ -270,19 +355,125 @@ ParserResult Parser::_varHeaderTopic(Parser* p) {
   p->_bytePos++;
   if (p->_bytePos == p->_packet.variableHeader.topicLength || p->_bytePos == EMC_MAX_TOPIC_LENGTH) {
     p->_packet.variableHeader.topic[p->_bytePos] = 0x00;  // add c-string delimiter
-    emc_log_i("Packet variable header topic complete");
-    if (p->_packet.fixedHeader.packetType & (HeaderFlag.PUBLISH_QOS1 | HeaderFlag.PUBLISH_QOS2)) {
-      p->_parse = _varHeaderPacketId1;
-    } else if (p->_packet.payload.total == 0) {
+    return _varHeaderTopicComplete(p);
+  }
+  return ParserResult::awaitData;
+}
+
+ParserResult Parser::_varHeaderTopicComplete(Parser* p) {
+  emc_log_i("Packet variable header topic complete");
+  if (p->_packet.fixedHeader.packetType & (HeaderFlag.PUBLISH_QOS1 | HeaderFlag.PUBLISH_QOS2)) {
+    p->_parse = _varHeaderPacketId1;
+  } else if (p->_protocolVersion == espMqttClientTypes::ProtocolVersion::V5) {
+    p->_parse = _propertyLength;
+    p->_bytePos = 0;
+  } else if (p->_packet.payload.total == 0) {
+    p->_parse = _fixedHeader;
+    return ParserResult::packet;
+  } else {
+    p->_parse = _payloadPublish;
+  }
+  return ParserResult::awaitData;
+}
+
+ParserResult Parser::_varHeaderReasonCode(Parser* p) {
+  p->_packet.variableHeader.reasonCode = p->_data[p->_bytesRead];
+  size_t consumed = ((p->_packet.fixedHeader.packetType & 0xF0) == PacketType.DISCONNECT) ? 1 : 3;  // [packet ID] + reason code
+  if (p->_packet.fixedHeader.remainingLength.remainingLength == consumed) {
+    p->_parse = _fixedHeader;
+    emc_log_i("Packet complete");
+    return ParserResult::packet;
+  }
+  p->_parse = _propertyLength;
+  p->_bytePos = 0;
+  return ParserResult::awaitData;
+}
+
+ParserResult Parser::_propertyLength(Parser* p) {
+  // the property buffer is only filled once the length is known, borrow it for the encoded length
+  uint8_t* raw = p->_propertiesBuffer;
+  raw[p->_bytePos] = p->_data[p->_bytesRead];
+  if (raw[p->_bytePos] & 0x80) {
+    p->_bytePos++;
+    if (p->_bytePos == 4) {
       p->_parse = _fixedHeader;
-      return ParserResult::packet;
-    } else {
-      p->_parse = _payloadPublish;
+      emc_log_w("Invalid property length");
+      return ParserResult::protocolError;
     }
+    return ParserResult::awaitData;
+  }
+  p->_propertiesLength = decodeRemainingLength(raw);
+  p->_propertiesLengthLength = p->_bytePos + 1;
+  p->_propertiesPos = 0;
+  if (p->_propertiesLength == 0) {
+    return _propertiesComplete(p);
   }
+  p->_parse = _properties;
   return ParserResult::awaitData;
 }
 
+ParserResult Parser::_properties(Parser* p) {
+  if (p->_propertiesPos < EMC_PROPERTIES_BUFFER_SIZE) {
+    p->_propertiesBuffer[p->_propertiesPos] = p->_data[p->_bytesRead];
+  }
+  p->_propertiesPos++;
+  if (p->_propertiesPos < p->_propertiesLength) {
+    return ParserResult::awaitData;
+  }
+  if (p->_propertiesLength > EMC_PROPERTIES_BUFFER_SIZE) {
+    emc_log_w("Properties too large, skipped (l:%zu)", p->_propertiesLength);
+  } else if (!decodeProperties(p->_propertiesBuffer, p->_propertiesLength, &p->_packet.properties, p->_propertiesStrings)) {
+    p->_parse = _fixedHeader;
+    emc_log_w("Invalid properties");
+    return ParserResult::protocolError;
+  }
+  return _propertiesComplete(p);
+}
+
+ParserResult Parser::_propertiesComplete(Parser* p) {
+  MQTTPacketType packetType = p->_packet.fixedHeader.packetType & 0xF0;
+  size_t remainingLength = p->_packet.fixedHeader.remainingLength.remainingLength;
+  size_t propertiesSize = p->_propertiesLengthLength + p->_propertiesLength;
+  p->_parse = _fixedHeader;
+
+  if (packetType == PacketType.PUBLISH || packetType == PacketType.SUBACK || packetType == PacketType.UNSUBACK) {
+    if (propertiesSize > p->_packet.payload.total) {
+      emc_log_w("Invalid property length");
+      return ParserResult::protocolError;
+    }
+    p->_packet.payload.total -= propertiesSize;
+    if (packetType == PacketType.PUBLISH) {
+      if (p->_packet.payload.total == 0) {
+        emc_log_i("Packet complete");
+        return ParserResult::packet;
+      }
+      p->_parse = _payloadPublish;
+      return ParserResult::awaitData;
+    }
+    if (0 < p->_packet.payload.total && p->_packet.payload.total <= EMC_PAYLOAD_BUFFER_SIZE) {
+      p->_packet.payload.length = p->_packet.payload.total;
+      p->_bytePos = 0;
+      p->_parse = _payloadReasonCodes;
+      return ParserResult::awaitData;
+    }
+    emc_log_w("Invalid payload length");
+    return ParserResult::protocolError;
+  }
+
+  size_t consumed = 3;  // packet ID + reason code
+  if (packetType == PacketType.CONNACK) {
+    consumed = 2;  // flags + reason code
+  } else if (packetType == PacketType.DISCONNECT) {
+    consumed = 1;  // reason code
+  }
+  if (consumed + propertiesSize != remainingLength) {
+    emc_log_w("Invalid property length");
+    return ParserResult::protocolError;
+  }
+  emc_log_i("Packet complete");
+  return ParserResult::packet;
+}
+
 ParserResult Parser::_payloadSuback(Parser* p) {
   uint8_t data = p->_data[p->_bytesRead];
   if (data < 0x03 || data == 0x80) {
@@ -301,6 +492,17 @@ ParserResult Parser::_payloadSuback(Parser* p) {
   return ParserResult::awaitData;
 }
 
+ParserResult Parser::_payloadReasonCodes(Parser* p) {
+  p->_payloadBuffer[p->_bytePos] = p->_data[p->_bytesRead];
+  p->_bytePos++;
+  if (p->_bytePos == p->_packet.payload.total) {
+    p->_parse = _fixedHeader;
+    emc_log_i("Packet complete");
+    return ParserResult::packet;
+  }
+  return ParserResult::awaitData;
+}
+
 ParserResult Parser::_payloadPublish(Parser* p) {
   p->_packet.payload.index += p->_packet.payload.length;
   p->_packet.payload.data = &p->_data[p->_bytesRead];
@@ -13,9 +13,11 @@ the LICENSE file.
 #include <algorithm>
 
 #include "../Config.h"
+#include "../TypeDefs.h"
 #include "Constants.h"
 #include "../Logging.h"
 #include "RemainingLength.h"
+#include "Properties.h"
 
 namespace espMqttClientInternals {
 
@@ -37,7 +39,9 @@ struct IncomingPacket {
       } connackVarHeader;
       uint16_t packetId;
     } fixed;
+    uint8_t reasonCode;  // MQTT 5: PUBACK, PUBREC, PUBREL, PUBCOMP and DISCONNECT
   } variableHeader;
+  IncomingProperties properties;  // MQTT 5
   struct {
     const uint8_t* data;
     size_t length;
@@ -66,6 +70,7 @@ class Parser {
   ParserResult parse(const uint8_t* data, size_t len, size_t* bytesRead);
   const IncomingPacket& getPacket() const;
   void reset();
+  void setProtocolVersion(espMqttClientTypes::ProtocolVersion version);
 
  private:
   // keep data variables in class to avoid copying on every iteration of the parser
@@ -76,6 +81,12 @@ class Parser {
   ParserFunc _parse;
   IncomingPacket _packet;
   uint8_t _payloadBuffer[EMC_PAYLOAD_BUFFER_SIZE];
+  espMqttClientTypes::ProtocolVersion _protocolVersion;
+  size_t _propertiesLength;
+  uint8_t _propertiesLengthLength;
+  size_t _propertiesPos;
+  uint8_t _propertiesBuffer[EMC_PROPERTIES_BUFFER_SIZE];
+  char _propertiesStrings[EMC_PROPERTIES_BUFFER_SIZE];
 
   static ParserResult _fixedHeader(Parser* p);
   static ParserResult _remainingLengthFixed(Parser* p);
@@ -92,8 +103,16 @@ class Parser {
   static ParserResult _varHeaderTopicLength1(Parser* p);
   static ParserResult _varHeaderTopicLength2(Parser* p);
   static ParserResult _varHeaderTopic(Parser* p);
+  static ParserResult _varHeaderTopicComplete(Parser* p);
+
+  static ParserResult _varHeaderReasonCode(Parser* p);
+
+  static ParserResult _propertyLength(Parser* p);
+  static ParserResult _properties(Parser* p);
+  static ParserResult _propertiesComplete(Parser* p);
 
   static ParserResult _payloadSuback(Parser* p);
+  static ParserResult _payloadReasonCodes(Parser* p);
   static ParserResult _payloadPublish(Parser* p);
 };
 
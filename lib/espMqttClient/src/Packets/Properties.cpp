@@ -0,0 +1,183 @@
+/*
+Copyright (c) 2022 Bert Melis. All rights reserved.
+
+This work is licensed under the terms of the MIT license.  
+For a copy, see <https://opensource.org/licenses/MIT> or
+the LICENSE file.
+*/
+
+#include "Properties.h"
+
+namespace espMqttClientInternals {
+
+void IncomingProperties::reset() {
+  messageExpiryInterval = 0;
+  topicAlias = 0;
+  topicAliasMaximum = 0;
+  responseTopic = nullptr;
+  correlationData = nullptr;
+  correlationDataLength = 0;
+  userPropertyCount = 0;
+}
+
+static size_t _publishPropertiesSize(uint16_t topicAlias, const espMqttClientTypes::PublishProperties* properties) {
+  size_t size = 0;
+  if (topicAlias != 0) size += 1 + 2;
+  if (properties) {
+    if (properties->messageExpiryInterval != 0) size += 1 + 4;
+    if (properties->responseTopic) size += 1 + 2 + strlen(properties->responseTopic);
+    if (properties->correlationData && properties->correlationDataLength > 0) size += 1 + 2 + properties->correlationDataLength;
+    if (properties->userProperties) {
+      for (size_t i = 0; i < properties->userPropertyCount; ++i) {
+        size += 1 + 2 + strlen(properties->userProperties[i].key) + 2 + strlen(properties->userProperties[i].value);
+      }
+    }
+  }
+  return size;
+}
+
+static const char* _copyString(const uint8_t* source, size_t length, char* strings, size_t* stringPos) {
+  char* dest = &strings[*stringPos];
+  memcpy(dest, source, length);
+  dest[length] = 0x00;
+  (*stringPos) += length + 1;
+  return dest;
+}
+
+size_t publishPropertiesLength(uint16_t topicAlias, const espMqttClientTypes::PublishProperties* properties) {
+  size_t size = _publishPropertiesSize(topicAlias, properties);
+  return remainingLengthLength(size) + size;
+}
+
+size_t encodePublishProperties(uint16_t topicAlias, const espMqttClientTypes::PublishProperties* properties, uint8_t* dest) {
+  size_t pos = encodeRemainingLength(_publishPropertiesSize(topicAlias, properties), dest);
+  if (topicAlias != 0) {
+    dest[pos++] = PropertyId.TOPIC_ALIAS;
+    dest[pos++] = topicAlias >> 8;
+    dest[pos++] = topicAlias & 0xFF;
+  }
+  if (!properties) return pos;
+  if (properties->messageExpiryInterval != 0) {
+    dest[pos++] = PropertyId.MESSAGE_EXPIRY_INTERVAL;
+    dest[pos++] = properties->messageExpiryInterval >> 24;
+    dest[pos++] = (properties->messageExpiryInterval >> 16) & 0xFF;
+    dest[pos++] = (properties->messageExpiryInterval >> 8) & 0xFF;
+    dest[pos++] = properties->messageExpiryInterval & 0xFF;
+  }
+  if (properties->responseTopic) {
+    dest[pos++] = PropertyId.RESPONSE_TOPIC;
+    pos += encodeString(properties->responseTopic, &dest[pos]);
+  }
+  if (properties->correlationData && properties->correlationDataLength > 0) {
+    dest[pos++] = PropertyId.CORRELATION_DATA;
+    dest[pos++] = properties->correlationDataLength >> 8;
+    dest[pos++] = properties->correlationDataLength & 0xFF;
+    memcpy(&dest[pos], properties->correlationData, properties->correlationDataLength);
+    pos += properties->correlationDataLength;
+  }
+  if (properties->userProperties) {
+    for (size_t i = 0; i < properties->userPropertyCount; ++i) {
+      dest[pos++] = PropertyId.USER_PROPERTY;
+      pos += encodeString(properties->userProperties[i].key, &dest[pos]);
+      pos += encodeString(properties->userProperties[i].value, &dest[pos]);
+    }
+  }
+  return pos;
+}
+
+bool decodeProperties(const uint8_t* data, size_t length, IncomingProperties* properties, char* strings) {
+  size_t pos = 0;
+  size_t stringPos = 0;
+  while (pos < length) {
+    uint8_t id = data[pos++];
+    size_t size = 0;  // size of the property value
+
+    switch (id) {
+      case PropertyId.PAYLOAD_FORMAT_INDICATOR:
+      case PropertyId.REQUEST_PROBLEM_INFORMATION:
+      case PropertyId.REQUEST_RESPONSE_INFORMATION:
+      case PropertyId.MAXIMUM_QOS:
+      case PropertyId.RETAIN_AVAILABLE:
+      case PropertyId.WILDCARD_SUBSCRIPTION_AVAILABLE:
+      case PropertyId.SUBSCRIPTION_IDENTIFIER_AVAILABLE:
+      case PropertyId.SHARED_SUBSCRIPTION_AVAILABLE:
+        size = 1;
+        break;
+      case PropertyId.SERVER_KEEP_ALIVE:
+      case PropertyId.RECEIVE_MAXIMUM:
+      case PropertyId.TOPIC_ALIAS_MAXIMUM:
+      case PropertyId.TOPIC_ALIAS:
+        size = 2;
+        break;
+      case PropertyId.MESSAGE_EXPIRY_INTERVAL:
+      case PropertyId.SESSION_EXPIRY_INTERVAL:
+      case PropertyId.WILL_DELAY_INTERVAL:
+      case PropertyId.MAXIMUM_PACKET_SIZE:
+        size = 4;
+        break;
+      case PropertyId.CONTENT_TYPE:
+      case PropertyId.RESPONSE_TOPIC:
+      case PropertyId.CORRELATION_DATA:
+      case PropertyId.ASSIGNED_CLIENT_IDENTIFIER:
+      case PropertyId.AUTHENTICATION_METHOD:
+      case PropertyId.AUTHENTICATION_DATA:
+      case PropertyId.RESPONSE_INFORMATION:
+      case PropertyId.SERVER_REFERENCE:
+      case PropertyId.REASON_STRING:
+        if (pos + 2 > length) return false;
+        size = 2 + ((data[pos] << 8) | data[pos + 1]);
+        break;
+      case PropertyId.USER_PROPERTY:
+        if (pos + 2 > length) return false;
+        size = 2 + ((data[pos] << 8) | data[pos + 1]);
+        if (pos + size + 2 > length) return false;
+        size += 2 + ((data[pos + size] << 8) | data[pos + size + 1]);
+        break;
+      case PropertyId.SUBSCRIPTION_IDENTIFIER:
+        do {
+          if (pos + size >= length || size == 4) return false;
+        } while (data[pos + size++] & 0x80);
+        break;
+      default:
+        emc_log_w("Invalid property: 0x%02x", id);
+        return false;
+    }
+    if (pos + size > length) return false;
+
+    const uint8_t* value = &data[pos];
+    switch (id) {
+      case PropertyId.MESSAGE_EXPIRY_INTERVAL:
+        properties->messageExpiryInterval = (static_cast<uint32_t>(value[0]) << 24) | (value[1] << 16) | (value[2] << 8) | value[3];
+        break;
+      case PropertyId.TOPIC_ALIAS:
+        properties->topicAlias = (value[0] << 8) | value[1];
+        break;
+      case PropertyId.TOPIC_ALIAS_MAXIMUM:
+        properties->topicAliasMaximum = (value[0] << 8) | value[1];
+        break;
+      case PropertyId.RESPONSE_TOPIC:
+        properties->responseTopic = _copyString(&value[2], size - 2, strings, &stringPos);
+        break;
+      case PropertyId.CORRELATION_DATA:
+        properties->correlationData = &value[2];
+        properties->correlationDataLength = size - 2;
+        break;
+      case PropertyId.USER_PROPERTY:
+        if (properties->userPropertyCount < EMC_MAX_USER_PROPERTIES) {
+          size_t keyLength = (value[0] << 8) | value[1];
+          espMqttClientTypes::UserProperty& userProperty = properties->userProperties[properties->userPropertyCount++];
+          userProperty.key = _copyString(&value[2], keyLength, strings, &stringPos);
+          userProperty.value = _copyString(&value[2 + keyLength + 2], size - keyLength - 4, strings, &stringPos);
+        } else {
+          emc_log_w("User property dropped");
+        }
+        break;
+      default:
+        break;
+    }
+    pos += size;
+  }
+  return true;
+}
+
+}  // end namespace espMqttClientInternals
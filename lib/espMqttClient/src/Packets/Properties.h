@@ -0,0 +1,81 @@
+/*
+Copyright (c) 2022 Bert Melis. All rights reserved.
+
+This work is licensed under the terms of the MIT license.  
+For a copy, see <https://opensource.org/licenses/MIT> or
+the LICENSE file.
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "../Config.h"
+#include "../TypeDefs.h"
+#include "../Logging.h"
+#include "RemainingLength.h"
+#include "StringUtil.h"
+
+namespace espMqttClientInternals {
+
+// MQTT 5 property identifiers, section 2.2.2.2 of the MQTT 5 specification
+constexpr struct {
+  const uint8_t PAYLOAD_FORMAT_INDICATOR          = 0x01;
+  const uint8_t MESSAGE_EXPIRY_INTERVAL           = 0x02;
+  const uint8_t CONTENT_TYPE                      = 0x03;
+  const uint8_t RESPONSE_TOPIC                    = 0x08;
+  const uint8_t CORRELATION_DATA                  = 0x09;
+  const uint8_t SUBSCRIPTION_IDENTIFIER           = 0x0B;
+  const uint8_t SESSION_EXPIRY_INTERVAL           = 0x11;
+  const uint8_t ASSIGNED_CLIENT_IDENTIFIER        = 0x12;
+  const uint8_t SERVER_KEEP_ALIVE                 = 0x13;
+  const uint8_t AUTHENTICATION_METHOD             = 0x15;
+  const uint8_t AUTHENTICATION_DATA               = 0x16;
+  const uint8_t REQUEST_PROBLEM_INFORMATION       = 0x17;
+  const uint8_t WILL_DELAY_INTERVAL               = 0x18;
+  const uint8_t REQUEST_RESPONSE_INFORMATION      = 0x19;
+  const uint8_t RESPONSE_INFORMATION              = 0x1A;
+  const uint8_t SERVER_REFERENCE                  = 0x1C;
+  const uint8_t REASON_STRING                     = 0x1F;
+  const uint8_t RECEIVE_MAXIMUM                   = 0x21;
+  const uint8_t TOPIC_ALIAS_MAXIMUM               = 0x22;
+  const uint8_t TOPIC_ALIAS                       = 0x23;
+  const uint8_t MAXIMUM_QOS                       = 0x24;
+  const uint8_t RETAIN_AVAILABLE                  = 0x25;
+  const uint8_t USER_PROPERTY                     = 0x26;
+  const uint8_t MAXIMUM_PACKET_SIZE               = 0x27;
+  const uint8_t WILDCARD_SUBSCRIPTION_AVAILABLE   = 0x28;
+  const uint8_t SUBSCRIPTION_IDENTIFIER_AVAILABLE = 0x29;
+  const uint8_t SHARED_SUBSCRIPTION_AVAILABLE     = 0x2A;
+} PropertyId;
+
+// Properties of incoming packets the client acts upon or passes to the user, others are validated and skipped
+struct IncomingProperties {
+  uint32_t messageExpiryInterval;
+  uint16_t topicAlias;
+  uint16_t topicAliasMaximum;
+  const char* responseTopic;
+  const uint8_t* correlationData;
+  uint16_t correlationDataLength;
+  espMqttClientTypes::UserProperty userProperties[EMC_MAX_USER_PROPERTIES];
+  size_t userPropertyCount;
+
+  void reset();
+};
+
+// returns the number of bytes needed to encode the PUBLISH properties, including the property length
+// topicAlias 0 is not sent, properties may be nullptr
+size_t publishPropertiesLength(uint16_t topicAlias, const espMqttClientTypes::PublishProperties* properties);
+
+// encodes the PUBLISH properties, including the property length, and returns number of bytes used
+// the topic alias is always the first property
+size_t encodePublishProperties(uint16_t topicAlias, const espMqttClientTypes::PublishProperties* properties, uint8_t* dest);
+
+// decodes a complete property block (without the property length) into 'properties'
+// strings are copied null-terminated into 'strings', which has to be at least 'length' bytes large
+// binary data points into 'data'
+// returns false on malformed or unknown properties
+bool decodeProperties(const uint8_t* data, size_t length, IncomingProperties* properties, char* strings);
+
+}  // end namespace espMqttClientInternals
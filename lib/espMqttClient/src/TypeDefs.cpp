@@ -23,6 +23,7 @@ const char* disconnectReasonToString(DisconnectReason reason) {
     case DisconnectReason::MQTT_NOT_AUTHORIZED:                return "Not authorized";
     case DisconnectReason::TLS_BAD_FINGERPRINT:                return "Bad fingerprint";
     case DisconnectReason::TCP_DISCONNECTED:                   return "TCP disconnected";
+    case DisconnectReason::MQTT_SERVER_DISCONNECT:             return "Server disconnected";
     default:                                                   return "";
   }
 }
@@ -44,6 +45,7 @@ const char* errorToString(Error error) {
     case Error::MAX_RETRIES:         return "Maximum retries exceeded";
     case Error::MALFORMED_PARAMETER: return "Malformed parameters";
     case Error::MISC_ERROR:          return "Misc error";
+    case Error::OUTBOX_FULL:         return "Outbox full";
     default:                         return "";
   }
 }
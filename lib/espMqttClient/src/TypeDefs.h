@@ -25,7 +25,8 @@ enum class DisconnectReason : uint8_t {
   MQTT_MALFORMED_CREDENTIALS = 4,
   MQTT_NOT_AUTHORIZED = 5,
   TLS_BAD_FINGERPRINT = 6,
-  TCP_DISCONNECTED = 7
+  TCP_DISCONNECTED = 7,
+  MQTT_SERVER_DISCONNECT = 8  // MQTT 5: server sent DISCONNECT
 };
 
 const char* disconnectReasonToString(DisconnectReason reason);
@@ -44,16 +45,55 @@ enum class Error : uint8_t {
   OUT_OF_MEMORY = 1,
   MAX_RETRIES = 2,
   MALFORMED_PARAMETER = 3,
-  MISC_ERROR = 4
+  MISC_ERROR = 4,
+  OUTBOX_FULL = 5
 };
 
 const char* errorToString(Error error);
 
+enum class ProtocolVersion : uint8_t {
+  V3_1_1 = 4,
+  V5 = 5
+};
+
+// LAST_VALUE: replace a queued PUBLISH to the same topic (and with the same retain flag) that hasn't been sent yet
+enum class PublishMode : uint8_t {
+  QUEUE_ALL = 0,
+  LAST_VALUE = 1
+};
+
+struct SubscribeItem {
+  const char* topic;
+  uint8_t qos;
+};
+
+struct UserProperty {
+  const char* key;
+  const char* value;
+};
+
+// MQTT 5 only, ignored when connecting with MQTT 3.1.1. Zero/nullptr members are not sent.
+struct PublishProperties {
+  uint32_t messageExpiryInterval;  // s
+  const char* responseTopic;
+  const uint8_t* correlationData;
+  uint16_t correlationDataLength;
+  const UserProperty* userProperties;
+  size_t userPropertyCount;
+};
+
 struct MessageProperties {
   uint8_t qos;
   bool dup;
   bool retain;
   uint16_t packetId;
+  // MQTT 5 only, pointers are valid during the message callback
+  uint32_t messageExpiryInterval;
+  const char* responseTopic;
+  const uint8_t* correlationData;
+  uint16_t correlationDataLength;
+  const UserProperty* userProperties;
+  size_t userPropertyCount;
 };
 
 typedef std::function<void(bool sessionPresent)> OnConnectCallback;
@@ -63,6 +103,7 @@ typedef std::function<void(uint16_t packetId)> OnUnsubscribeCallback;
 typedef std::function<void(const MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total)> OnMessageCallback;
 typedef std::function<void(uint16_t packetId)> OnPublishCallback;
 typedef std::function<size_t(uint8_t* data, size_t maxSize, size_t index)> PayloadCallback;
+typedef std::function<size_t(uint8_t* data, size_t length)> PayloadWriter;
 typedef std::function<void(uint16_t packetId, Error error)> OnErrorCallback;
 
 enum class UseInternalTask {
@@ -317,6 +317,48 @@ void test_disconnect() {
   mqttClient.removeOnDisconnect(onDisconnectCbId);
 }
 
+void test_pub_last_value() {
+  TEST_ASSERT_TRUE(mqttClient.disconnected());
+  TEST_ASSERT_EQUAL_UINT32(0, mqttClient.queueSize());
+
+  uint16_t first = mqttClient.publish("test/state", 1, true, "value1", nullptr, espMqttClientTypes::PublishMode::LAST_VALUE);
+  uint16_t second = mqttClient.publish("test/state", 1, true, "value2", nullptr, espMqttClientTypes::PublishMode::LAST_VALUE);
+  uint16_t other = mqttClient.publish("test/other", 1, true, "value3", nullptr, espMqttClientTypes::PublishMode::LAST_VALUE);
+  uint16_t notRetained = mqttClient.publish("test/state", 1, false, "value4", nullptr, espMqttClientTypes::PublishMode::LAST_VALUE);
+  uint16_t queueAll = mqttClient.publish("test/state", 1, true, "value5");
+
+  TEST_ASSERT_GREATER_THAN_UINT16(0, first);
+  TEST_ASSERT_EQUAL_UINT16(first, second);  // replacement keeps the packet ID
+  TEST_ASSERT_NOT_EQUAL(first, other);
+  TEST_ASSERT_NOT_EQUAL(first, notRetained);
+  TEST_ASSERT_NOT_EQUAL(first, queueAll);
+  TEST_ASSERT_EQUAL_UINT32(4, mqttClient.queueSize());
+
+  mqttClient.clearQueue(true);
+  TEST_ASSERT_EQUAL_UINT32(0, mqttClient.queueSize());
+}
+
+void test_pub_outbox_full() {
+  TEST_ASSERT_TRUE(mqttClient.disconnected());
+  TEST_ASSERT_EQUAL_UINT32(0, mqttClient.queueSize());
+  mqttClient.setQueueCapacity(2);
+
+  uint16_t first = mqttClient.publish("test/log", 1, true, "event1");
+  uint16_t second = mqttClient.publish("test/state", 1, true, "value1", nullptr, espMqttClientTypes::PublishMode::LAST_VALUE);
+  uint16_t dropped = mqttClient.publish("test/log", 1, true, "event2");  // never supersedes the queued event
+  uint16_t replaced = mqttClient.publish("test/state", 1, true, "value2", nullptr, espMqttClientTypes::PublishMode::LAST_VALUE);
+
+  TEST_ASSERT_GREATER_THAN_UINT16(0, first);
+  TEST_ASSERT_GREATER_THAN_UINT16(0, second);
+  TEST_ASSERT_EQUAL_UINT16(0, dropped);
+  TEST_ASSERT_EQUAL_UINT16(second, replaced);
+  TEST_ASSERT_EQUAL_UINT32(2, mqttClient.queueSize());
+
+  mqttClient.setQueueCapacity(0);
+  mqttClient.clearQueue(true);
+  TEST_ASSERT_EQUAL_UINT32(0, mqttClient.queueSize());
+}
+
 void test_pub_before_connect() {
   std::atomic<bool> onConnectCalledTest(false);
   std::atomic<int> publishSendTest(0);
@@ -397,6 +439,8 @@ int main() {
   RUN_TEST(test_receive2);
   RUN_TEST(test_unsubscribe);
   RUN_TEST(test_disconnect);
+  RUN_TEST(test_pub_last_value);
+  RUN_TEST(test_pub_outbox_full);
   RUN_TEST(test_pub_before_connect);
   final_disconnect();
   exitProgram = true;
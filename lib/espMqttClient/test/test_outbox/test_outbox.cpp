@@ -159,6 +159,91 @@ void test_outbox_removeCurrent() {
   // Valgrind should not detect a leak here
 }
 
+void test_outbox_size() {
+  Outbox<uint32_t> outbox;
+  outbox.emplace(1);
+  outbox.emplace(2);
+  outbox.emplaceFront(3);
+  // 3 1 2
+  TEST_ASSERT_EQUAL_UINT32(3, outbox.size());
+  TEST_ASSERT_EQUAL_UINT32(3, outbox.highWaterMark());
+
+  outbox.removeCurrent();
+  Outbox<uint32_t>::Iterator it = outbox.front();
+  outbox.remove(it);
+  // 2
+  TEST_ASSERT_EQUAL_UINT32(1, outbox.size());
+  TEST_ASSERT_EQUAL_UINT32(3, outbox.highWaterMark());
+
+  outbox.resetHighWaterMark();
+  TEST_ASSERT_EQUAL_UINT32(1, outbox.highWaterMark());
+  outbox.emplace(4);
+  TEST_ASSERT_EQUAL_UINT32(2, outbox.highWaterMark());
+}
+
+void test_outbox_capacity() {
+  Outbox<uint32_t> outbox;
+  // pool size when using a pool
+  TEST_ASSERT_EQUAL_UINT32(EMC_OUTBOX_POOL_ELEMENTS, outbox.capacity());
+
+  outbox.setCapacity(2);
+  TEST_ASSERT_EQUAL_UINT32(2, outbox.capacity());
+  outbox.emplace(1);
+  TEST_ASSERT_FALSE(outbox.full());
+  outbox.emplace(2);
+  TEST_ASSERT_TRUE(outbox.full());
+
+  // capacity is advisory, emplacing still works
+  Outbox<uint32_t>::Iterator it = outbox.emplace(3);
+  TEST_ASSERT_TRUE(static_cast<bool>(it));
+  TEST_ASSERT_TRUE(outbox.full());
+
+  outbox.removeCurrent();
+  outbox.removeCurrent();
+  TEST_ASSERT_FALSE(outbox.full());
+
+  outbox.setCapacity(EMC_OUTBOX_POOL_ELEMENTS + 1);
+  TEST_ASSERT_EQUAL_UINT32(EMC_OUTBOX_POOL_ELEMENTS, outbox.capacity());
+  outbox.setCapacity(0);
+  TEST_ASSERT_EQUAL_UINT32(EMC_OUTBOX_POOL_ELEMENTS, outbox.capacity());
+}
+
+void test_outbox_current() {
+  Outbox<uint32_t> outbox;
+  outbox.emplace(1);
+  outbox.emplace(2);
+  outbox.emplace(3);
+  outbox.next();
+  Outbox<uint32_t>::Iterator it = outbox.current();
+  // 1 2 3, current and it point to 2
+  TEST_ASSERT_EQUAL_UINT32(2, *(it.get()));
+
+  outbox.remove(it);
+  // 1 3, current and it point to 3
+  TEST_ASSERT_EQUAL_UINT32(3, *(it.get()));
+  TEST_ASSERT_EQUAL_UINT32(3, *(outbox.getCurrent()));
+  TEST_ASSERT_EQUAL_UINT32(2, outbox.size());
+}
+
+void test_outbox_replace() {
+  Outbox<uint32_t> outbox;
+  outbox.emplace(1);
+  outbox.emplace(2);
+  outbox.emplace(3);
+  Outbox<uint32_t>::Iterator it = outbox.front();
+  ++it;
+  outbox.replace(it, 4);
+  // 1 4 3, it points to 4
+  TEST_ASSERT_EQUAL_UINT32(4, *(it.get()));
+  TEST_ASSERT_EQUAL_UINT32(3, outbox.size());
+  it = outbox.front();
+  TEST_ASSERT_EQUAL_UINT32(1, *(it.get()));
+  ++it;
+  TEST_ASSERT_EQUAL_UINT32(4, *(it.get()));
+  ++it;
+  TEST_ASSERT_EQUAL_UINT32(3, *(it.get()));
+}
+
 int main() {
   UNITY_BEGIN();
   RUN_TEST(test_outbox_create);
@@ -167,5 +252,9 @@ int main() {
   RUN_TEST(test_outbox_remove1);
   RUN_TEST(test_outbox_remove2);
   RUN_TEST(test_outbox_removeCurrent);
+  RUN_TEST(test_outbox_size);
+  RUN_TEST(test_outbox_capacity);
+  RUN_TEST(test_outbox_current);
+  RUN_TEST(test_outbox_replace);
   return UNITY_END();
 }
@@ -0,0 +1,103 @@
+#include <unity.h>
+
+#include <chrono>  // NOLINT [build/c++11]
+#include <stdio.h>
+
+#include <Outbox.h>
+#include <Packets/Packet.h>
+
+using espMqttClientInternals::Outbox;
+using espMqttClientInternals::Packet;
+
+/*
+ * Enqueue/dequeue throughput of the outbox. The numbers are printed for comparison between
+ * configurations (heap vs pool, EMC_OUTBOX_POOL_ELEMENTS), the tests only check the outbox
+ * behaved correctly while being hammered.
+ */
+
+static const size_t iterations = 200000;
+
+void setUp() {}
+void tearDown() {}
+
+static void report(const char* name, std::chrono::steady_clock::time_point start, size_t operations) {
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  printf("%s: %zu ops, %.1f ns/op\n", name, operations, elapsed.count() / operations);
+}
+
+// queue with a constant depth, like a connection that keeps up with the publish rate
+void test_outbox_benchmark_steady() {
+  Outbox<uint32_t> outbox;
+  const size_t depth = 8;
+  size_t added = 0;
+  for (size_t i = 0; i < depth; ++i) {
+    if (outbox.emplace(i)) ++added;
+  }
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    if (outbox.emplace(i)) ++added;
+    outbox.removeCurrent();
+  }
+  report("steady", start, iterations * 2);
+
+  TEST_ASSERT_EQUAL_UINT32(depth + iterations, added);
+  TEST_ASSERT_EQUAL_UINT32(depth, outbox.size());
+  TEST_ASSERT_EQUAL_UINT32(depth + 1, outbox.highWaterMark());
+}
+
+// queue filled to capacity and drained again, like a burst during a slow connection
+void test_outbox_benchmark_burst() {
+  Outbox<uint32_t> outbox;
+  outbox.setCapacity(24);
+  size_t added = 0;
+  size_t rounds = iterations / outbox.capacity();
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < rounds; ++r) {
+    while (!outbox.full()) {
+      if (!outbox.emplace(r)) break;
+      ++added;
+    }
+    while (!outbox.empty()) {
+      outbox.removeCurrent();
+    }
+  }
+  report("burst", start, added * 2);
+
+  TEST_ASSERT_EQUAL_UINT32(rounds * outbox.capacity(), added);
+  TEST_ASSERT_TRUE(outbox.empty());
+  TEST_ASSERT_EQUAL_UINT32(outbox.capacity(), outbox.highWaterMark());
+}
+
+// complete PUBLISH packets, includes encoding and the packet data allocation
+// on PC the packet allocation is always logged, so this one runs less often
+void test_outbox_benchmark_publish() {
+  const size_t packets = iterations / 20;
+  Outbox<Packet> outbox;
+  const char* topic = "nukihub/lock/state";
+  const uint8_t payload[] = "unlocked";
+  size_t added = 0;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < packets; ++i) {
+    espMqttClientTypes::Error error(espMqttClientTypes::Error::SUCCESS);
+    Outbox<Packet>::Iterator it = outbox.emplace(error, static_cast<uint16_t>(i % 0xFFFF + 1), topic, payload, sizeof(payload) - 1, 1, true);
+    if (it && error == espMqttClientTypes::Error::SUCCESS) ++added;
+    if (outbox.size() > 4) {
+      outbox.removeCurrent();
+    }
+  }
+  report("publish", start, packets * 2);
+
+  TEST_ASSERT_EQUAL_UINT32(packets, added);
+  TEST_ASSERT_EQUAL_UINT32(5, outbox.highWaterMark());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_outbox_benchmark_steady);
+  RUN_TEST(test_outbox_benchmark_burst);
+  RUN_TEST(test_outbox_benchmark_publish);
+  return UNITY_END();
+}
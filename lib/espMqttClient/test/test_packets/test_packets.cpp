@@ -479,6 +479,48 @@ void test_encodeMultiSubscribe3() {
   TEST_ASSERT_EQUAL_UINT16(packetId, packet.packetId());
 }
 
+void test_encodeSubscribeList() {
+  const uint8_t check[] = {
+    0b10000010,                 // header
+    0x14,                       // remaining length
+    0x00,0x16,                  // packet Id
+    0x00, 0x03, 'a', '/', 'b',  // topic1
+    0x01,                       // qos1
+    0x00, 0x03, 'c', '/', 'd',  // topic2
+    0x02,                       // qos2
+    0x00, 0x03, 'e', '/', 'f',  // topic3
+    0x00                        // qos3
+  };
+  const uint32_t length = 22;
+  const espMqttClientTypes::SubscribeItem list[] = {
+    {"a/b", 1},
+    {"c/d", 2},
+    {"e/f", 0}
+  };
+  uint16_t packetId = 22;
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::MISC_ERROR;
+
+  Packet packet(error, packetId, list, 3);
+  packet.setDup();  // no effect
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::SUCCESS, error);
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8(PacketType.SUBSCRIBE, packet.packetType());
+  TEST_ASSERT_FALSE(packet.removable());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(check, packet.data(0), length);
+  TEST_ASSERT_EQUAL_UINT16(packetId, packet.packetId());
+}
+
+void test_encodeSubscribeListEmpty() {
+  uint16_t packetId = 22;
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::SUCCESS;
+
+  Packet packet(error, packetId, static_cast<const espMqttClientTypes::SubscribeItem*>(nullptr), 0);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::MALFORMED_PARAMETER, error);
+  TEST_ASSERT_EQUAL_UINT32(0, packet.size());
+}
+
 void test_encodeUnsubscribe() {
   const uint8_t check[] = {
     0b10100010,                 // header
@@ -688,6 +730,255 @@ void test_encodeChunkedPublish() {
   TEST_ASSERT_EQUAL_UINT8_ARRAY(payloadChunk, packet.data(index), available);
 }
 
+void test_encodeWrittenPublish() {
+  const uint8_t check[] = {
+    0b00110011,                 // header, dup, qos, retain
+    0x0B,
+    0x00,0x03,'t','o','p',      // topic
+    0x00,0x16,                  // packet Id
+    0x01,0x02,0x03,0x04         // payload
+  };
+  const uint32_t length = 13;
+
+  size_t calls = 0;
+  espMqttClientTypes::PayloadWriter writer = [&calls](uint8_t* data, size_t len) -> size_t {
+    ++calls;
+    for (size_t i = 0; i < len; ++i) data[i] = i + 1;
+    return len;
+  };
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::MISC_ERROR;
+
+  Packet packet(error, 22, "top", writer, 4, 1, true);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::SUCCESS, error);
+  TEST_ASSERT_EQUAL_UINT32(1, calls);
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(check, packet.data(0), length);
+  TEST_ASSERT_EQUAL_UINT16(22, packet.packetId());
+}
+
+void test_encodeWrittenPublishFail() {
+  espMqttClientTypes::PayloadWriter writer = [](uint8_t* data, size_t len) -> size_t {
+    (void) data;
+    return len - 1;
+  };
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::SUCCESS;
+
+  Packet packet(error, 22, "top", writer, 4, 1, true);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::MALFORMED_PARAMETER, error);
+}
+
+void test_encodeConnect5() {
+  const uint8_t check[] = {
+    0b00010000,                 // header
+    0x15,                       // remaining length
+    0x00,0x04,'M','Q','T','T',  // protocol
+    0b00000101,                 // protocol level
+    0b00000000,                 // connect flags
+    0x00,0x10,                  // keepalive (16)
+    0x05,                       // property length
+    0x11,0xFF,0xFF,0xFF,0xFF,   // session expiry interval
+    0x00,0x03,'c','l','i'       // client id
+  };
+  const uint32_t length = 23;
+
+  bool cleanSession = false;
+  const char* username = nullptr;
+  const char* password = nullptr;
+  const char* willTopic = nullptr;
+  bool willRemain = false;
+  uint8_t willQoS = 0;
+  const uint8_t* willPayload = nullptr;
+  uint16_t willPayloadLength = 0;
+  uint16_t keepalive = 16;
+  const char* clientId = "cli";
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::MISC_ERROR;
+
+  Packet packet(error,
+                cleanSession,
+                username,
+                password,
+                willTopic,
+                willRemain,
+                willQoS,
+                willPayload,
+                willPayloadLength,
+                keepalive,
+                clientId,
+                espMqttClientTypes::ProtocolVersion::V5);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::SUCCESS, error);
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8(PacketType.CONNECT, packet.packetType());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(check, packet.data(0), length);
+}
+
+void test_encodePublish5() {
+  const uint8_t check[] = {
+    0b00110010,                 // header, dup, qos, retain
+    0x1C,                       // remaining length
+    0x00,0x03,'t','o','p',      // topic
+    0x00,0x16,                  // packet Id
+    0x10,                       // property length
+    0x23,0x00,0x02,             // topic alias
+    0x02,0x00,0x00,0x00,0x3C,   // message expiry interval
+    0x26,0x00,0x02,'i','d',0x00,0x01,'7',  // user property
+    0x01,0x02,0x03,0x04         // payload
+  };
+  const uint32_t length = 30;
+
+  const char* topic = "top";
+  uint8_t qos = 1;
+  bool retain = false;
+  const uint8_t payload[] = {0x01, 0x02, 0x03, 0x04};
+  uint16_t payloadLength = 4;
+  uint16_t packetId = 22;
+  uint16_t topicAlias = 2;
+  const espMqttClientTypes::UserProperty userProperties[] = {{"id", "7"}};
+  espMqttClientTypes::PublishProperties properties = {60, nullptr, nullptr, 0, userProperties, 1};
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::MISC_ERROR;
+
+  Packet packet(error,
+                packetId,
+                topic,
+                payload,
+                payloadLength,
+                qos,
+                retain,
+                topicAlias,
+                &properties);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::SUCCESS, error);
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8(PacketType.PUBLISH, packet.packetType());
+  TEST_ASSERT_FALSE(packet.removable());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(check, packet.data(0), length);
+  TEST_ASSERT_EQUAL_UINT16(packetId, packet.packetId());
+  TEST_ASSERT_EQUAL_UINT16(0, packet.topicAlias());
+}
+
+void test_encodePublish5TopicAlias() {
+  const uint8_t check[] = {
+    0b00110010,                 // header, dup, qos, retain
+    0x0A,                       // remaining length
+    0x00,0x00,                  // empty topic
+    0x00,0x16,                  // packet Id
+    0x03,                       // property length
+    0x23,0x00,0x02,             // topic alias
+    0x01,0x02                   // payload
+  };
+  const uint32_t length = 12;
+
+  const uint8_t payload[] = {0x01, 0x02};
+  uint16_t packetId = 22;
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::MISC_ERROR;
+
+  Packet packet(error, packetId, "", payload, 2, 1, false, 2, nullptr);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::SUCCESS, error);
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(check, packet.data(0), length);
+  TEST_ASSERT_EQUAL_UINT16(2, packet.topicAlias());
+
+  const uint8_t checkExpanded[] = {
+    0b00111010,                 // header, dup, qos, retain
+    0x0A,                       // remaining length
+    0x00,0x03,'t','o','p',      // topic
+    0x00,0x16,                  // packet Id
+    0x00,                       // property length
+    0x01,0x02                   // payload
+  };
+
+  packet.setDup();
+  TEST_ASSERT_TRUE(packet.expandTopicAlias("top"));
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(checkExpanded, packet.data(0), length);
+  TEST_ASSERT_EQUAL_UINT16(0, packet.topicAlias());
+  TEST_ASSERT_EQUAL_UINT16(packetId, packet.packetId());
+}
+
+void test_encodeWrittenPublish5TopicAlias() {
+  const uint8_t check[] = {
+    0b00110010,                 // header, dup, qos, retain
+    0x0A,                       // remaining length
+    0x00,0x00,                  // empty topic
+    0x00,0x16,                  // packet Id
+    0x03,                       // property length
+    0x23,0x00,0x02,             // topic alias
+    0x01,0x02                   // payload
+  };
+  const uint32_t length = 12;
+
+  espMqttClientTypes::PayloadWriter writer = [](uint8_t* data, size_t len) -> size_t {
+    data[0] = 0x01;
+    data[1] = 0x02;
+    return len;
+  };
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::MISC_ERROR;
+
+  Packet packet(error, 22, "", writer, 2, 1, false, 2, nullptr);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::SUCCESS, error);
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(check, packet.data(0), length);
+  TEST_ASSERT_EQUAL_UINT16(2, packet.topicAlias());
+}
+
+void test_encodePublish5Fail() {
+  const uint8_t payload[] = {0x01, 0x02};
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::SUCCESS;
+
+  Packet packet(error, 22, "", payload, 2, 1, false, 0, nullptr);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::MALFORMED_PARAMETER, error);
+}
+
+void test_encodeSubscribe5() {
+  const uint8_t check[] = {
+    0b10000010,                 // header
+    0x09,                       // remaining length
+    0x00,0x16,                  // packet Id
+    0x00,                       // property length
+    0x00, 0x03, 'a', '/', 'b',  // topic
+    0x01                        // qos
+  };
+  const uint32_t length = 11;
+  const espMqttClientTypes::SubscribeItem list[] = {
+    {"a/b", 1}
+  };
+  uint16_t packetId = 22;
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::MISC_ERROR;
+
+  Packet packet(error, packetId, list, 1, espMqttClientTypes::ProtocolVersion::V5);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::SUCCESS, error);
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8(PacketType.SUBSCRIBE, packet.packetType());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(check, packet.data(0), length);
+}
+
+void test_encodeUnsubscribe5() {
+  const uint8_t check[] = {
+    0b10100010,                 // header
+    0x08,                       // remaining length
+    0x00,0x16,                  // packet Id
+    0x00,                       // property length
+    0x00, 0x03, 'a', '/', 'b',  // topic
+  };
+  const uint32_t length = 10;
+  const char* list[] = {"a/b"};
+  uint16_t packetId = 22;
+  espMqttClientTypes::Error error = espMqttClientTypes::Error::MISC_ERROR;
+
+  Packet packet(error, packetId, list, 1, espMqttClientTypes::ProtocolVersion::V5);
+
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientTypes::Error::SUCCESS, error);
+  TEST_ASSERT_EQUAL_UINT32(length, packet.size());
+  TEST_ASSERT_EQUAL_UINT8(PacketType.UNSUBSCRIBE, packet.packetType());
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(check, packet.data(0), length);
+}
+
 int main() {
   UNITY_BEGIN();
   RUN_TEST(test_encodeConnect0);
@@ -704,11 +995,22 @@ int main() {
   RUN_TEST(test_encodeSubscribe);
   RUN_TEST(test_encodeMultiSubscribe2);
   RUN_TEST(test_encodeMultiSubscribe3);
+  RUN_TEST(test_encodeSubscribeList);
+  RUN_TEST(test_encodeSubscribeListEmpty);
   RUN_TEST(test_encodeUnsubscribe);
   RUN_TEST(test_encodeMultiUnsubscribe2);
   RUN_TEST(test_encodeMultiUnsubscribe3);
   RUN_TEST(test_encodePingReq);
   RUN_TEST(test_encodeDisconnect);
   RUN_TEST(test_encodeChunkedPublish);
+  RUN_TEST(test_encodeWrittenPublish);
+  RUN_TEST(test_encodeWrittenPublishFail);
+  RUN_TEST(test_encodeConnect5);
+  RUN_TEST(test_encodePublish5);
+  RUN_TEST(test_encodePublish5TopicAlias);
+  RUN_TEST(test_encodeWrittenPublish5TopicAlias);
+  RUN_TEST(test_encodePublish5Fail);
+  RUN_TEST(test_encodeSubscribe5);
+  RUN_TEST(test_encodeUnsubscribe5);
   return UNITY_END();
 }
@@ -10,6 +10,7 @@ void setUp() {}
 void tearDown() {}
 
 Parser parser;
+Parser parser5;  // MQTT 5
 
 void test_Connack() {
   const uint8_t stream[] = {
@@ -259,6 +260,42 @@ void test_SubAck() {
   TEST_ASSERT_FALSE(parser.getPacket().dup());
 }
 
+void test_SubAckFull() {
+  // one return code per topic, as many as the payload buffer holds
+  uint8_t stream[4 + EMC_PAYLOAD_BUFFER_SIZE];
+  stream[0] = 0b10010000;
+  stream[1] = 2 + EMC_PAYLOAD_BUFFER_SIZE;
+  stream[2] = 0x00;
+  stream[3] = 0x0B;
+  for (size_t i = 0; i < EMC_PAYLOAD_BUFFER_SIZE; ++i) {
+    stream[4 + i] = i % 3;
+  }
+  const size_t length = sizeof(stream);
+
+  size_t bytesRead = 0;
+  ParserResult result = parser.parse(stream, length, &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(length, bytesRead);
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientInternals::PacketType.SUBACK, parser.getPacket().fixedHeader.packetType & 0xF0);
+  TEST_ASSERT_EQUAL_UINT16(11, parser.getPacket().variableHeader.fixed.packetId);
+  TEST_ASSERT_EQUAL_UINT32(EMC_PAYLOAD_BUFFER_SIZE, parser.getPacket().payload.total);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&stream[4], parser.getPacket().payload.data, EMC_PAYLOAD_BUFFER_SIZE);
+}
+
+void test_SubAckTooLong() {
+  uint8_t stream[4 + EMC_PAYLOAD_BUFFER_SIZE + 1] = {0};
+  stream[0] = 0b10010000;
+  stream[1] = 2 + EMC_PAYLOAD_BUFFER_SIZE + 1;
+  stream[3] = 0x0C;
+  const size_t length = sizeof(stream);
+
+  size_t bytesRead = 0;
+  ParserResult result = parser.parse(stream, length, &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::protocolError, result);
+}
+
 void test_UnsubAck() {
   const uint8_t stream[] = {
     0b10110000,
@@ -336,6 +373,211 @@ void test_longStream() {
   TEST_ASSERT_FALSE(parser.getPacket().dup());
 }
 
+void test_Connack5() {
+  const uint8_t stream[] = {
+    0b00100000,       // header
+    0x06,             // remaining length
+    0x00,             // session present
+    0x00,             // reason code
+    0x03,             // property length
+    0x22, 0x00, 0x0A  // topic alias maximum
+  };
+  const size_t length = 8;
+
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, length, &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(length, bytesRead);
+  TEST_ASSERT_EQUAL_UINT8(0, parser5.getPacket().variableHeader.fixed.connackVarHeader.sessionPresent);
+  TEST_ASSERT_EQUAL_UINT8(0, parser5.getPacket().variableHeader.fixed.connackVarHeader.returnCode);
+  TEST_ASSERT_EQUAL_UINT16(10, parser5.getPacket().properties.topicAliasMaximum);
+}
+
+void test_Connack5Refused() {
+  const uint8_t stream[] = {
+    0b00100000,  // header
+    0x03,        // remaining length
+    0x00,        // session present
+    0x87,        // reason code: not authorized
+    0x00         // property length
+  };
+  const size_t length = 5;
+
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, length, &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(length, bytesRead);
+  TEST_ASSERT_EQUAL_UINT8(0x87, parser5.getPacket().variableHeader.fixed.connackVarHeader.returnCode);
+  TEST_ASSERT_EQUAL_UINT16(0, parser5.getPacket().properties.topicAliasMaximum);
+}
+
+void test_Publish5() {
+  const uint8_t stream[] = {
+    0b00110010,                             // header
+    0x22,                                   // remaining length
+    0x00, 0x03, 'a', '/', 'b',              // topic
+    0x00, 0x0A,                             // packet id
+    0x18,                                   // property length
+    0x02, 0x00, 0x00, 0x00, 0x3C,           // message expiry interval
+    0x08, 0x00, 0x03, 'r', '/', 't',        // response topic
+    0x09, 0x00, 0x02, 0xAB, 0xCD,           // correlation data
+    0x26, 0x00, 0x02, 'i', 'd', 0x00, 0x01, '7',  // user property
+    0x01, 0x02                              // payload
+  };
+  const size_t length = 36;
+
+  // split in the middle of the properties
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, 20, &bytesRead);
+  TEST_ASSERT_EQUAL_INT32(ParserResult::awaitData, result);
+  TEST_ASSERT_EQUAL_UINT32(20, bytesRead);
+
+  result = parser5.parse(&stream[bytesRead], length - bytesRead, &bytesRead);
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(length, bytesRead);
+
+  const IncomingPacket& packet = parser5.getPacket();
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientInternals::PacketType.PUBLISH, packet.fixedHeader.packetType & 0xF0);
+  TEST_ASSERT_EQUAL_STRING("a/b", packet.variableHeader.topic);
+  TEST_ASSERT_EQUAL_UINT16(10, packet.variableHeader.fixed.packetId);
+  TEST_ASSERT_EQUAL_UINT32(2, packet.payload.length);
+  TEST_ASSERT_EQUAL_UINT32(2, packet.payload.total);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&stream[34], packet.payload.data, 2);
+  TEST_ASSERT_EQUAL_UINT32(60, packet.properties.messageExpiryInterval);
+  TEST_ASSERT_EQUAL_STRING("r/t", packet.properties.responseTopic);
+  TEST_ASSERT_EQUAL_UINT16(2, packet.properties.correlationDataLength);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&stream[24], packet.properties.correlationData, 2);
+  TEST_ASSERT_EQUAL_UINT32(1, packet.properties.userPropertyCount);
+  TEST_ASSERT_EQUAL_STRING("id", packet.properties.userProperties[0].key);
+  TEST_ASSERT_EQUAL_STRING("7", packet.properties.userProperties[0].value);
+  TEST_ASSERT_EQUAL_UINT8(1, packet.qos());
+}
+
+void test_Publish5InvalidProperty() {
+  const uint8_t stream[] = {
+    0b00110000,                 // header
+    0x08,                       // remaining length
+    0x00, 0x03, 'a', '/', 'b',  // topic
+    0x02,                       // property length
+    0x7F, 0x00                  // unknown property
+  };
+  const size_t length = 10;
+
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, length, &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::protocolError, result);
+}
+
+void test_PubAck5() {
+  const uint8_t stream[] = {
+    0b01000000,  // header
+    0x04,        // remaining length
+    0x00, 0x0A,  // packet id
+    0x10,        // reason code: no matching subscribers
+    0x00,        // property length
+    0b01000000,  // header
+    0x02,        // remaining length
+    0x00, 0x0B   // packet id, reason code omitted
+  };
+  const size_t length = 10;
+
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, length, &bytesRead);
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(6, bytesRead);
+  TEST_ASSERT_EQUAL_UINT16(10, parser5.getPacket().variableHeader.fixed.packetId);
+  TEST_ASSERT_EQUAL_UINT8(0x10, parser5.getPacket().variableHeader.reasonCode);
+
+  result = parser5.parse(&stream[bytesRead], length - bytesRead, &bytesRead);
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(length, bytesRead);
+  TEST_ASSERT_EQUAL_UINT16(11, parser5.getPacket().variableHeader.fixed.packetId);
+  TEST_ASSERT_EQUAL_UINT8(0x00, parser5.getPacket().variableHeader.reasonCode);
+}
+
+void test_SubAck5() {
+  const uint8_t stream[] = {
+    0b10010000,  // header
+    0x05,        // remaining length
+    0x00, 0x0A,  // packet id
+    0x00,        // property length
+    0x01, 0x87   // reason codes
+  };
+  const size_t length = 7;
+
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, length, &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(length, bytesRead);
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientInternals::PacketType.SUBACK, parser5.getPacket().fixedHeader.packetType & 0xF0);
+  TEST_ASSERT_EQUAL_UINT16(10, parser5.getPacket().variableHeader.fixed.packetId);
+  TEST_ASSERT_EQUAL_UINT32(2, parser5.getPacket().payload.total);
+  TEST_ASSERT_EQUAL_UINT8_ARRAY(&stream[5], parser5.getPacket().payload.data, 2);
+}
+
+void test_SubAck5Full() {
+  uint8_t stream[5 + EMC_PAYLOAD_BUFFER_SIZE] = {0};
+  stream[0] = 0b10010000;
+  stream[1] = 3 + EMC_PAYLOAD_BUFFER_SIZE;
+  stream[3] = 0x0D;  // packet id, property length 0, reason codes 0
+
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, sizeof(stream), &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(sizeof(stream), bytesRead);
+  TEST_ASSERT_EQUAL_UINT32(EMC_PAYLOAD_BUFFER_SIZE, parser5.getPacket().payload.total);
+}
+
+void test_UnsubAck5() {
+  const uint8_t stream[] = {
+    0b10110000,  // header
+    0x04,        // remaining length
+    0x00, 0x0A,  // packet id
+    0x00,        // property length
+    0x00         // reason code
+  };
+  const size_t length = 6;
+
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, length, &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(length, bytesRead);
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientInternals::PacketType.UNSUBACK, parser5.getPacket().fixedHeader.packetType & 0xF0);
+  TEST_ASSERT_EQUAL_UINT16(10, parser5.getPacket().variableHeader.fixed.packetId);
+}
+
+void test_Disconnect5() {
+  const uint8_t stream[] = {
+    0b11100000,  // header
+    0x01,        // remaining length
+    0x8E         // reason code: session taken over
+  };
+  const size_t length = 3;
+
+  parser5.setProtocolVersion(espMqttClientTypes::ProtocolVersion::V5);
+  size_t bytesRead = 0;
+  ParserResult result = parser5.parse(stream, length, &bytesRead);
+
+  TEST_ASSERT_EQUAL_INT32(ParserResult::packet, result);
+  TEST_ASSERT_EQUAL_UINT32(length, bytesRead);
+  TEST_ASSERT_EQUAL_UINT8(espMqttClientInternals::PacketType.DISCONNECT, parser5.getPacket().fixedHeader.packetType & 0xF0);
+  TEST_ASSERT_EQUAL_UINT8(0x8E, parser5.getPacket().variableHeader.reasonCode);
+}
+
 int main() {
   UNITY_BEGIN();
   RUN_TEST(test_Connack);
@@ -348,8 +590,19 @@ int main() {
   RUN_TEST(test_PubRel);
   RUN_TEST(test_PubComp);
   RUN_TEST(test_SubAck);
+  RUN_TEST(test_SubAckFull);
+  RUN_TEST(test_SubAckTooLong);
   RUN_TEST(test_UnsubAck);
   RUN_TEST(test_PingResp);
   RUN_TEST(test_longStream);
+  RUN_TEST(test_Connack5);
+  RUN_TEST(test_Connack5Refused);
+  RUN_TEST(test_Publish5);
+  RUN_TEST(test_Publish5InvalidProperty);
+  RUN_TEST(test_PubAck5);
+  RUN_TEST(test_SubAck5);
+  RUN_TEST(test_SubAck5Full);
+  RUN_TEST(test_UnsubAck5);
+  RUN_TEST(test_Disconnect5);
   return UNITY_END();
 }
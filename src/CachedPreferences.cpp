@@ -0,0 +1,456 @@
+#include "CachedPreferences.h"
+#include <cstring>
+
+bool CachedPreferences::getBool(const char* key, bool defaultValue)
+{
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+
+        CachedValue* cached = find(key, ValueType::Bool);
+        if(cached != nullptr)
+        {
+            return cached->exists ? cached->value != 0 : defaultValue;
+        }
+    }
+
+    return Preferences::getBool(key, defaultValue);
+}
+
+int32_t CachedPreferences::getInt(const char* key, int32_t defaultValue)
+{
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+
+        CachedValue* cached = find(key, ValueType::Int);
+        if(cached != nullptr)
+        {
+            return cached->exists ? (int32_t)cached->value : defaultValue;
+        }
+    }
+
+    return Preferences::getInt(key, defaultValue);
+}
+
+uint32_t CachedPreferences::getUInt(const char* key, uint32_t defaultValue)
+{
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+
+        CachedValue* cached = find(key, ValueType::UInt);
+        if(cached != nullptr)
+        {
+            return cached->exists ? cached->value : defaultValue;
+        }
+    }
+
+    return Preferences::getUInt(key, defaultValue);
+}
+
+String CachedPreferences::getString(const char* key, String defaultValue)
+{
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+
+        CachedValue* cached = find(key, ValueType::String);
+        if(cached != nullptr)
+        {
+            return cached->exists ? cached->str : defaultValue;
+        }
+    }
+
+    return Preferences::getString(key, defaultValue);
+}
+
+size_t CachedPreferences::putBool(const char* key, bool value)
+{
+    return putValue(key, ValueType::Bool, value ? 1 : 0);
+}
+
+size_t CachedPreferences::putInt(const char* key, int32_t value)
+{
+    return putValue(key, ValueType::Int, (uint32_t)value);
+}
+
+size_t CachedPreferences::putUInt(const char* key, uint32_t value)
+{
+    return putValue(key, ValueType::UInt, value);
+}
+
+size_t CachedPreferences::putString(const char* key, const char* value)
+{
+    bool written = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _cache.find(key);
+        if(it != _cache.end() && it->second.type == ValueType::String && it->second.exists && it->second.str == value)
+        {
+            return strlen(value);
+        }
+
+        CachedValue cached = { ValueType::String, true, 0, String(value) };
+
+        if(strlen(value) > CACHED_PREFERENCES_MAX_STRING_LENGTH)
+        {
+            unjournal(key);
+            _cache.erase(key);
+            written = write(key, cached);
+        }
+        else if(isWriteBehind(key))
+        {
+            _cache[key] = cached;
+            journal(key);
+            written = true;
+        }
+        else
+        {
+            unjournal(key);
+            written = write(key, cached);
+
+            if(written)
+            {
+                _cache[key] = cached;
+            }
+            else
+            {
+                _cache.erase(key);
+            }
+        }
+    }
+
+    if(!written)
+    {
+        return 0;
+    }
+
+    notify(key);
+    return strlen(value);
+}
+
+size_t CachedPreferences::putString(const char* key, String value)
+{
+    return putString(key, value.c_str());
+}
+
+size_t CachedPreferences::putBytes(const char* key, const void* value, size_t len)
+{
+    size_t written = 0;
+
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        unjournal(key);
+        _cache.erase(key);
+        written = Preferences::putBytes(key, value, len);
+    }
+
+    if(written > 0)
+    {
+        notify(key);
+    }
+
+    return written;
+}
+
+bool CachedPreferences::remove(const char* key)
+{
+    bool removed = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+        unjournal(key);
+        _cache.erase(key);
+        removed = Preferences::remove(key);
+    }
+
+    if(removed)
+    {
+        notify(key);
+    }
+
+    return removed;
+}
+
+bool CachedPreferences::clear()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    _journal.clear();
+    _journalTs = 0;
+    _cache.clear();
+    return Preferences::clear();
+}
+
+void CachedPreferences::addChangeListener(std::function<void(const char* key)> listener)
+{
+    _listeners.push_back(listener);
+}
+
+CachedPreferences::CachedValue* CachedPreferences::find(const char* key, const ValueType type)
+{
+    auto it = _cache.find(key);
+
+    if(it == _cache.end())
+    {
+        CachedValue cached;
+        if(!load(key, type, cached))
+        {
+            return nullptr;
+        }
+        it = _cache.emplace(key, cached).first;
+    }
+
+    return it->second.type == type ? &it->second : nullptr;
+}
+
+bool CachedPreferences::load(const char* key, const ValueType type, CachedValue& cached)
+{
+    PreferenceType storedType = getType(key);
+
+    cached.type = type;
+    cached.exists = storedType != PT_INVALID;
+    cached.value = 0;
+
+    if(!cached.exists)
+    {
+        return true;
+    }
+
+    // Keys stored with a different type than requested are left to Preferences, which returns the default value for them
+    switch(type)
+    {
+    case ValueType::Bool:
+        if(storedType != PT_U8)
+        {
+            return false;
+        }
+        cached.value = Preferences::getBool(key) ? 1 : 0;
+        return true;
+    case ValueType::Int:
+        if(storedType != PT_I32)
+        {
+            return false;
+        }
+        cached.value = (uint32_t)Preferences::getInt(key);
+        return true;
+    case ValueType::UInt:
+        if(storedType != PT_U32)
+        {
+            return false;
+        }
+        cached.value = Preferences::getUInt(key);
+        return true;
+    case ValueType::String:
+        if(storedType != PT_STR)
+        {
+            return false;
+        }
+        cached.str = Preferences::getString(key);
+        return cached.str.length() <= CACHED_PREFERENCES_MAX_STRING_LENGTH;
+    }
+
+    return false;
+}
+
+size_t CachedPreferences::putValue(const char* key, const ValueType type, const uint32_t value)
+{
+    size_t size = type == ValueType::Bool ? sizeof(uint8_t) : sizeof(uint32_t);
+    bool written = false;
+
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+
+        auto it = _cache.find(key);
+        if(it != _cache.end() && it->second.type == type && it->second.exists && it->second.value == value)
+        {
+            return size;
+        }
+
+        CachedValue cached = { type, true, value, String() };
+
+        if(isWriteBehind(key))
+        {
+            _cache[key] = cached;
+            journal(key);
+            written = true;
+        }
+        else
+        {
+            unjournal(key);
+            written = write(key, cached);
+
+            if(written)
+            {
+                _cache[key] = cached;
+            }
+            else
+            {
+                _cache.erase(key);
+            }
+        }
+    }
+
+    if(!written)
+    {
+        return 0;
+    }
+
+    notify(key);
+    return size;
+}
+
+bool CachedPreferences::write(const char* key, const CachedValue& cached)
+{
+    switch(cached.type)
+    {
+    case ValueType::Bool:
+        return Preferences::putBool(key, cached.value != 0) > 0;
+    case ValueType::Int:
+        return Preferences::putInt(key, (int32_t)cached.value) > 0;
+    case ValueType::UInt:
+        return Preferences::putUInt(key, cached.value) > 0;
+    case ValueType::String:
+        // Preferences reports the string length, so an empty string can't be told apart from a failed write
+        return Preferences::putString(key, cached.str) > 0 || cached.str.length() == 0;
+    }
+
+    return false;
+}
+
+void CachedPreferences::setWriteBehind(std::initializer_list<const char*> keys)
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    for(const char* key : keys)
+    {
+        _writeBehindKeys.insert(key);
+    }
+}
+
+void CachedPreferences::flush()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    flushJournal();
+}
+
+void CachedPreferences::flushIfDue()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    if(_journalTs != 0 && espMillis() - _journalTs >= CACHED_PREFERENCES_WRITE_BEHIND_INTERVAL)
+    {
+        flushJournal();
+    }
+}
+
+size_t CachedPreferences::pendingWrites()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _journal.size();
+}
+
+uint32_t CachedPreferences::flushCount()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _flushCount;
+}
+
+uint32_t CachedPreferences::coalescedWrites()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _coalescedWrites;
+}
+
+int64_t CachedPreferences::lastFlushDuration()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _lastFlushDuration;
+}
+
+int64_t CachedPreferences::maxFlushDuration()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _maxFlushDuration;
+}
+
+bool CachedPreferences::isWriteBehind(const char* key) const
+{
+    return _writeBehindKeys.find(key) != _writeBehindKeys.end();
+}
+
+void CachedPreferences::journal(const char* key)
+{
+    for(auto it = _journal.begin(); it != _journal.end(); ++it)
+    {
+        if(*it == key)
+        {
+            _journal.erase(it);
+            ++_coalescedWrites;
+            break;
+        }
+    }
+
+    _journal.push_back(key);
+
+    if(_journalTs == 0)
+    {
+        _journalTs = espMillis();
+    }
+}
+
+void CachedPreferences::unjournal(const char* key)
+{
+    for(auto it = _journal.begin(); it != _journal.end(); ++it)
+    {
+        if(*it == key)
+        {
+            _journal.erase(it);
+            break;
+        }
+    }
+
+    if(_journal.empty())
+    {
+        _journalTs = 0;
+    }
+}
+
+void CachedPreferences::flushJournal()
+{
+    if(_journal.empty())
+    {
+        return;
+    }
+
+    int64_t startTs = espMicros();
+    size_t flushed = 0;
+
+    while(flushed < _journal.size())
+    {
+        auto it = _cache.find(_journal[flushed]);
+
+        // Stop at the first failed write so the journal is never persisted out of order, the rest is retried on the next flush
+        if(it != _cache.end() && !write(_journal[flushed].c_str(), it->second))
+        {
+            break;
+        }
+        ++flushed;
+    }
+
+    _journal.erase(_journal.begin(), _journal.begin() + flushed);
+    _journalTs = _journal.empty() ? 0 : espMillis();
+
+    _lastFlushDuration = espMicros() - startTs;
+    if(_lastFlushDuration > _maxFlushDuration)
+    {
+        _maxFlushDuration = _lastFlushDuration;
+    }
+    ++_flushCount;
+}
+
+void CachedPreferences::notify(const char* key)
+{
+    for(const auto& listener : _listeners)
+    {
+        listener(key);
+    }
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <Preferences.h>
+#include <functional>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "EspMillis.h"
+
+// Longer strings (certificates, keys) are always read from NVS
+#define CACHED_PREFERENCES_MAX_STRING_LENGTH 256
+// How long writes to write-behind keys may stay in RAM before they are flushed to NVS
+#define CACHED_PREFERENCES_WRITE_BEHIND_INTERVAL 60000
+
+// Preferences with a RAM cache for bool, int, uint and string settings.
+// Each key is read from NVS once, later reads are served from the cache. Writes go through to NVS and update the cache,
+// writes that don't change the cached value are skipped. Change listeners are notified with the key after every write that changed a value.
+class CachedPreferences : public Preferences
+{
+public:
+    using Preferences::getString;
+
+    bool getBool(const char* key, bool defaultValue = false);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+    String getString(const char* key, String defaultValue = String());
+
+    size_t putBool(const char* key, bool value);
+    size_t putInt(const char* key, int32_t value);
+    size_t putUInt(const char* key, uint32_t value);
+    size_t putString(const char* key, const char* value);
+    size_t putString(const char* key, String value);
+    size_t putBytes(const char* key, const void* value, size_t len);
+
+    bool remove(const char* key);
+    bool clear();
+
+    // Listeners are called on the task that wrote the setting and must not block
+    void addChangeListener(std::function<void(const char* key)> listener);
+
+    // Writes to these keys only update the cache and are journaled. Repeated writes to a key are coalesced, the journal is written to NVS
+    // in order of the last write to each key by flush() / flushIfDue(). A crash or power loss loses at most the unflushed writes.
+    void setWriteBehind(std::initializer_list<const char*> keys);
+    void flush();
+    void flushIfDue();
+
+    size_t pendingWrites();
+    uint32_t flushCount();
+    uint32_t coalescedWrites();
+    int64_t lastFlushDuration(); // us
+    int64_t maxFlushDuration(); // us
+
+private:
+    enum class ValueType : uint8_t
+    {
+        Bool,
+        Int,
+        UInt,
+        String
+    };
+
+    struct CachedValue
+    {
+        ValueType type;
+        bool exists;
+        uint32_t value;
+        String str;
+    };
+
+    CachedValue* find(const char* key, const ValueType type);
+    bool load(const char* key, const ValueType type, CachedValue& cached);
+    size_t putValue(const char* key, const ValueType type, const uint32_t value);
+    bool write(const char* key, const CachedValue& cached);
+    bool isWriteBehind(const char* key) const;
+    void journal(const char* key);
+    void unjournal(const char* key);
+    void flushJournal();
+    void notify(const char* key);
+
+    std::map<std::string, CachedValue> _cache;
+    std::vector<std::function<void(const char* key)>> _listeners;
+    std::set<std::string> _writeBehindKeys;
+    std::vector<std::string> _journal;
+    int64_t _journalTs = 0;
+    uint32_t _flushCount = 0;
+    uint32_t _coalescedWrites = 0;
+    int64_t _lastFlushDuration = 0;
+    int64_t _maxFlushDuration = 0;
+    std::mutex _mutex;
+};
@@ -2,12 +2,22 @@
 
 void CharBuffer::initialize(char16_t buffer_size)
 {
-    _buffer = new char[buffer_size];
+    _bufferSize = buffer_size;
 }
 
 char *CharBuffer::get()
 {
+    if(_buffer == nullptr)
+    {
+        _buffer = new char[_bufferSize];
+    }
     return _buffer;
 }
 
-char* CharBuffer::_buffer;
+size_t CharBuffer::size()
+{
+    return _bufferSize;
+}
+
+size_t CharBuffer::_bufferSize = 0;
+thread_local char* CharBuffer::_buffer = nullptr;
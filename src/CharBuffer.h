@@ -1,11 +1,16 @@
 #pragma once
 
+#include <cstddef>
+
 class CharBuffer
 {
 public:
     static void initialize(char16_t buffer_size);
+    // Returns the publish buffer owned by the calling task, allocated on first use
     static char* get();
+    static size_t size();
 
 private:
-    static char* _buffer;
-};
\ No newline at end of file
+    static size_t _bufferSize;
+    static thread_local char* _buffer;
+};
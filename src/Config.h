@@ -120,9 +120,26 @@
 
 #ifndef NUKI_HUB_UPDATER
 #define MQTT_QOS_LEVEL 1
+#define MQTT_QOS_LEVEL_TELEMETRY 0
+#define MQTT_PUBLISH_CACHE_REFRESH_INTERVAL (15 * 60 * 1000)
+#define MQTT_MAX_INBOUND_PAYLOAD_SIZE 16384
+#define MQTT_INBOUND_BUFFER_KEEP_SIZE 2048
+#define MQTT_CONNECT_TIMEOUT 60000
+#define MQTT_RECONNECT_BACKOFF_MIN 1000
+#define MQTT_RECONNECT_BACKOFF_MAX 60000
+#define MQTT_REPLAY_BATCH_SIZE 10
+#define MQTT_WILDCARD_MIN_TOPICS 2
+#define MQTT_OUTBOX_CAPACITY 112
+// EMC_OUTBOX_POOL_ELEMENTS (platformio.ini) minus room for acknowledgements and pings
+#define MQTT_OUTBOX_CAPACITY_MAX 120
+#define HASS_DISCOVERY_ITEMS_PER_LOOP 4
+// Discovery waits while this many packets are in the MQTT outbox, leaves room for lock states and command results
+#define HASS_DISCOVERY_MAX_QUEUED 16
 #define GPIO_DEBOUNCE_TIME 200
 #define CHAR_BUFFER_SIZE 4096
 #define NUKI_TASK_SIZE 8192
+// Longest the nuki task sleeps without a deadline or wakeup, also the interval of bleScanner->update() while idle (was 20 ms before the task slept on deadlines)
+#define NUKI_TASK_MAX_WAIT 500
 #define MAX_AUTHLOG 5
 #define MAX_KEYPAD 10
 #define MAX_TIMECONTROL 10
@@ -1,7 +1,29 @@
 #pragma once
 #include <cstdint>
 
+#ifdef ESP_PLATFORM
+#include "esp_timer.h"
+
 inline int64_t espMillis()
 {
     return esp_timer_get_time() / 1000;
-}
\ No newline at end of file
+}
+
+inline int64_t espMicros()
+{
+    return esp_timer_get_time();
+}
+#else
+#include <chrono>
+
+inline int64_t espMicros()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline int64_t espMillis()
+{
+    return espMicros() / 1000;
+}
+#endif
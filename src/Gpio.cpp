@@ -11,7 +11,7 @@
 
 Gpio* Gpio::_inst = nullptr;
 
-Gpio::Gpio(Preferences* preferences)
+Gpio::Gpio(CachedPreferences* preferences)
     : _preferences(preferences)
 {
     _inst = this;
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <functional>
-#include <Preferences.h>
+#include "CachedPreferences.h"
 #include <vector>
 
 enum class PinRole
@@ -56,7 +56,7 @@ struct PinEntry
 class Gpio
 {
 public:
-    Gpio(Preferences* preferences);
+    Gpio(CachedPreferences* preferences);
     static void init();
 
     void addCallback(std::function<void(const GpioAction&, const int&)> callback);
@@ -134,5 +134,5 @@ private:
     std::vector<uint8_t> _triggerState;
     hw_timer_t* timer = nullptr;
 
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
 };
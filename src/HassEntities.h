@@ -0,0 +1,1003 @@
+#pragma once
+
+#include "HassEntity.h"
+#include "MqttTopics.h"
+
+// Home Assistant discovery entities published by HomeAssistantDiscovery. The tables live in flash, only the device id,
+// base topic and the few fields that are known at runtime are added when the config is written.
+
+// Nuki Hub
+constexpr HassEntity hassNukiHubEntities[] =
+{
+#ifndef CONFIG_IDF_TARGET_ESP32H2
+    {
+        "sensor", "wifi_signal_strength", "WIFI signal strength",
+        mqtt_topic_wifi_rssi, "signal_strength", "measurement", "diagnostic", nullptr,
+        R"("unit_of_meas":"dBm")"
+    },
+#endif
+    {
+        "binary_sensor", "mqtt_connected", "MQTT connected",
+        mqtt_topic_mqtt_connection_state, nullptr, nullptr, "diagnostic", nullptr,
+        R"("pl_on":"online",)"
+        R"("pl_off":"offline",)"
+        R"("ic":"mdi:lan-connect")"
+    },
+    {
+        "sensor", "network_device", "Network device",
+        mqtt_topic_network_device, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true)"
+    },
+    {
+        "switch", "webserver", "Nuki Hub webserver enabled",
+        mqtt_topic_webserver_state, nullptr, nullptr, "diagnostic", mqtt_topic_webserver_action,
+        R"("pl_on":"1",)"
+        R"("pl_off":"0",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    },
+    {
+        "sensor", "uptime", "Uptime",
+        mqtt_topic_uptime, "duration", nullptr, "diagnostic", nullptr,
+        R"("en":true,)"
+        R"("unit_of_meas":"min")"
+    },
+};
+
+constexpr HassEntity hassNukiHubMqttLog =
+{
+    "sensor", "mqtt_log", "MQTT Log",
+    mqtt_topic_log, nullptr, nullptr, "diagnostic", nullptr,
+    R"("en":true)"
+};
+
+// Nuki Hub info
+constexpr HassEntity hassNukiHubInfoEntities[] =
+{
+    {
+        "sensor", "nuki_hub_version", "Nuki Hub version",
+        mqtt_topic_info_nuki_hub_version, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true,)"
+        R"("ic":"mdi:counter")"
+    },
+    {
+        "sensor", "nuki_hub_build", "Nuki Hub build",
+        mqtt_topic_info_nuki_hub_build, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true,)"
+        R"("ic":"mdi:counter")"
+    },
+    {
+        "sensor", "nuki_hub_restart_reason", "Nuki Hub restart reason",
+        mqtt_topic_restart_reason_fw, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true)"
+    },
+    {
+        "sensor", "nuki_hub_restart_reason_esp", "Nuki Hub restart reason ESP",
+        mqtt_topic_restart_reason_esp, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true)"
+    },
+    {
+        "sensor", "nuki_hub_ip", "Nuki Hub IP",
+        mqtt_topic_info_nuki_hub_ip, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true,)"
+        R"("ic":"mdi:ip")"
+    },
+};
+
+// Nuki Hub update check, the latest version topic is added at runtime
+constexpr HassEntity hassNukiHubLatest =
+{
+    "sensor", "nuki_hub_latest", "NUKI Hub latest",
+    mqtt_topic_info_nuki_hub_latest, nullptr, nullptr, "diagnostic", nullptr,
+    R"("en":true,)"
+    R"("ic":"mdi:counter")"
+};
+
+constexpr HassEntity hassNukiHubUpdate =
+{
+    "update", "nuki_hub_update", "NUKI Hub firmware update",
+    mqtt_topic_info_nuki_hub_version, "firmware", nullptr, "diagnostic", nullptr,
+    R"("en":true,)"
+    R"("ent_pic":"https://raw.githubusercontent.com/technyon/nuki_hub/master/icon/favicon-32x32.png")"
+};
+
+constexpr HassEntity hassNukiHubUpdateFromMqtt =
+{
+    "update", "nuki_hub_update", "NUKI Hub firmware update",
+    mqtt_topic_info_nuki_hub_version, "firmware", nullptr, "diagnostic", mqtt_topic_update,
+    R"("en":true,)"
+    R"("pl_inst":"1",)"
+    R"("ent_pic":"https://raw.githubusercontent.com/technyon/nuki_hub/master/icon/favicon-32x32.png")"
+};
+
+// Lock and opener
+constexpr HassEntity hassDeviceEntities[] =
+{
+    {
+        "sensor", "firmware_version", "Firmware version",
+        mqtt_topic_info_firmware_version, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true,)"
+        R"("ic":"mdi:counter")"
+    },
+    {
+        "sensor", "hardware_version", "Hardware version",
+        mqtt_topic_info_hardware_version, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true,)"
+        R"("ic":"mdi:counter")"
+    },
+    {
+        "binary_sensor", "battery_low", "Battery low",
+        mqtt_topic_battery_basic_json, "battery", nullptr, "diagnostic", nullptr,
+        R"("pl_on":"1",)"
+        R"("pl_off":"0",)"
+        R"("val_tpl":"{{value_json.critical}}")"
+    },
+    {
+        "binary_sensor", "battery_charging", "Battery charging",
+        mqtt_topic_battery_basic_json, "battery", nullptr, "diagnostic", nullptr,
+        R"("pl_on":"1",)"
+        R"("pl_off":"0",)"
+        R"("val_tpl":"{{value_json.charging}}")"
+    },
+    {
+        "sensor", "battery_voltage", "Battery voltage",
+        mqtt_topic_battery_advanced_json, "voltage", "measurement", "diagnostic", nullptr,
+        R"("unit_of_meas":"V",)"
+        R"("val_tpl":"{{value_json.batteryVoltage}}")"
+    },
+    {
+        "sensor", "trigger", "Trigger",
+        mqtt_topic_lock_trigger, nullptr, nullptr, "diagnostic", nullptr,
+        R"("en":true)"
+    },
+    {
+        "button", "query_lockstate", "Query lock state",
+        nullptr, nullptr, nullptr, "diagnostic", mqtt_topic_query_lockstate,
+        R"("en":false,)"
+        R"("pl_prs":"1")"
+    },
+    {
+        "button", "query_config", "Query config",
+        nullptr, nullptr, nullptr, "diagnostic", mqtt_topic_query_config,
+        R"("en":false,)"
+        R"("pl_prs":"1")"
+    },
+    {
+        "button", "query_commandresult", "Query lock state command result",
+        nullptr, nullptr, nullptr, "diagnostic", mqtt_topic_query_lockstate_command_result,
+        R"("en":false,)"
+        R"("pl_prs":"1")"
+    },
+    {
+        "sensor", "bluetooth_signal_strength", "Bluetooth signal strength",
+        mqtt_topic_lock_rssi, "signal_strength", "measurement", "diagnostic", nullptr,
+        R"("unit_of_meas":"dBm")"
+    },
+};
+
+// The state topic is below the lock topic, it's added at runtime
+constexpr HassEntity hassHybridConnected =
+{
+    "binary_sensor", "hybrid_connected", "Hybrid connected",
+    nullptr, nullptr, nullptr, "diagnostic", nullptr,
+    R"("pl_on":"1",)"
+    R"("pl_off":"0",)"
+    R"("en":true)"
+};
+
+constexpr HassEntity hassDoorSensor =
+{
+    "binary_sensor", "door_sensor", "Door sensor",
+    mqtt_topic_lock_door_sensor_state, "door", nullptr, nullptr, nullptr,
+    R"("pl_on":"doorOpened",)"
+    R"("pl_off":"doorClosed",)"
+    R"("pl_not_avail":"unavailable")"
+};
+
+// Lock, indexed by the ACL preferences
+constexpr HassAclEntity hassLockActionEntities[] =
+{
+    { 2, {
+        "button", "unlatch", "Open",
+        nullptr, nullptr, nullptr, nullptr, mqtt_topic_lock_action,
+        R"("en":false,)"
+        R"("pl_prs":"unlatch")"
+    } },
+    { 3, {
+        "button", "lockngo", "Lock 'n' Go",
+        nullptr, nullptr, nullptr, nullptr, mqtt_topic_lock_action,
+        R"("en":false,)"
+        R"("pl_prs":"lockNgo")"
+    } },
+    { 4, {
+        "button", "lockngounlatch", "Lock 'n' Go with unlatch",
+        nullptr, nullptr, nullptr, nullptr, mqtt_topic_lock_action,
+        R"("en":false,)"
+        R"("pl_prs":"lockNgoUnlatch")"
+    } },
+};
+
+// Lock
+constexpr HassEntity hassLockEntities[] =
+{
+    {
+        "button", "query_battery", "Query battery",
+        nullptr, nullptr, nullptr, "diagnostic", mqtt_topic_query_battery,
+        R"("en":false,)"
+        R"("pl_prs":"1")"
+    },
+    {
+        "sensor", "battery_level", "Battery level",
+        mqtt_topic_battery_basic_json, "battery", "measurement", "diagnostic", nullptr,
+        R"("unit_of_meas":"%",)"
+        R"("val_tpl":"{{value_json.level}}")"
+    },
+};
+
+// Lock configuration, indexed by the basic lock config ACL preferences
+constexpr HassAclEntity hassLockBasicConfigEntities[] =
+{
+    { 6, {
+        "switch", "led_enabled", "LED enabled",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("ic":"mdi:led-variant-on",)"
+        R"("pl_on":"{ \"ledEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"ledEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.ledEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 5, {
+        "switch", "button_enabled", "Button enabled",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("ic":"mdi:radiobox-marked",)"
+        R"("pl_on":"{ \"buttonEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"buttonEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.buttonEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 13, {
+        "switch", "double_lock", "Double lock",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"singleLock\": \"0\"}",)"
+        R"("pl_off":"{ \"singleLock\": \"1\"}",)"
+        R"("val_tpl":"{{value_json.singleLock}}",)"
+        R"("stat_on":"0",)"
+        R"("stat_off":"1")"
+    } },
+    { 7, {
+        "number", "led_brightness", "LED brightness",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("ic":"mdi:brightness-6",)"
+        R"("cmd_tpl":"{ \"ledBrightness\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.ledBrightness}}",)"
+        R"("min":"0",)"
+        R"("max":"5")"
+    } },
+    { 3, {
+        "switch", "auto_unlatch", "Auto unlatch",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"autoUnlatch\": \"1\"}",)"
+        R"("pl_off":"{ \"autoUnlatch\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.autoUnlatch}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 4, {
+        "switch", "pairing_enabled", "Pairing enabled",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"pairingEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"pairingEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.pairingEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 8, {
+        "number", "timezone_offset", "Timezone offset",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("ic":"mdi:timer-cog-outline",)"
+        R"("cmd_tpl":"{ \"timeZoneOffset\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.timeZoneOffset}}",)"
+        R"("min":"0",)"
+        R"("max":"60")"
+    } },
+    { 9, {
+        "switch", "dst_mode", "DST mode European",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"dstMode\": \"1\"}",)"
+        R"("pl_off":"{ \"dstMode\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.dstMode}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 10, {
+        "select", "fob_action_1", "Fob action 1",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.fobAction1}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"fobAction1\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Unlock","Lock","Lock n Go","Intelligent"])"
+    } },
+    { 11, {
+        "select", "fob_action_2", "Fob action 2",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.fobAction2}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"fobAction2\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Unlock","Lock","Lock n Go","Intelligent"])"
+    } },
+    { 12, {
+        "select", "fob_action_3", "Fob action 3",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.fobAction3}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"fobAction3\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Unlock","Lock","Lock n Go","Intelligent"])"
+    } },
+    { 14, {
+        "select", "advertising_mode", "Advertising mode",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.advertisingMode}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"advertisingMode\": \"{{ value }}\" }",)"
+        R"("options":["Automatic","Normal","Slow","Slowest"])"
+    } },
+    { 15, {
+        "select", "timezone", "Timezone",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.timeZone}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"timeZone\": \"{{ value }}\" }",)"
+        R"("options":["Africa/Cairo","Africa/Lagos","Africa/Maputo","Africa/Nairobi","America/Anchorage","America/Argentina/Buenos_Aires",)"
+        R"("America/Chicago","America/Denver","America/Halifax","America/Los_Angeles","America/Manaus","America/Mexico_City",)"
+        R"("America/New_York","America/Phoenix","America/Regina","America/Santiago","America/Sao_Paulo","America/St_Johns",)"
+        R"("Asia/Bangkok","Asia/Dubai","Asia/Hong_Kong","Asia/Jerusalem","Asia/Karachi","Asia/Kathmandu",)"
+        R"("Asia/Kolkata","Asia/Riyadh","Asia/Seoul","Asia/Shanghai","Asia/Tehran","Asia/Tokyo",)"
+        R"("Asia/Yangon","Australia/Adelaide","Australia/Brisbane","Australia/Darwin","Australia/Hobart","Australia/Perth",)"
+        R"("Australia/Sydney","Europe/Berlin","Europe/Helsinki","Europe/Istanbul","Europe/London","Europe/Moscow",)"
+        R"("Pacific/Auckland","Pacific/Guam","Pacific/Honolulu","Pacific/Pago_Pago","None"])"
+    } },
+};
+
+// Lock configuration, indexed by the advanced lock config ACL preferences
+constexpr HassAclEntity hassLockAdvancedConfigEntities[] =
+{
+    { 19, {
+        "switch", "auto_lock", "Auto lock",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"autoLockEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"autoLockEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.autoLockEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 12, {
+        "switch", "auto_unlock", "Auto unlock",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"autoUnLockDisabled\": \"0\"}",)"
+        R"("pl_off":"{ \"autoUnLockDisabled\": \"1\"}",)"
+        R"("val_tpl":"{{value_json.autoUnLockDisabled}}",)"
+        R"("stat_on":"0",)"
+        R"("stat_off":"1")"
+    } },
+    { 0, {
+        "number", "unlocked_position_offset_degrees", "Unlocked position offset degrees",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"unlockedPositionOffsetDegrees\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.unlockedPositionOffsetDegrees}}",)"
+        R"("min":"-90",)"
+        R"("max":"180")"
+    } },
+    { 1, {
+        "number", "locked_position_offset_degrees", "Locked position offset degrees",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"lockedPositionOffsetDegrees\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.lockedPositionOffsetDegrees}}",)"
+        R"("min":"-180",)"
+        R"("max":"90")"
+    } },
+    { 2, {
+        "number", "single_locked_position_offset_degrees", "Single locked position offset degrees",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"singleLockedPositionOffsetDegrees\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.singleLockedPositionOffsetDegrees}}",)"
+        R"("min":"-180",)"
+        R"("max":"180")"
+    } },
+    { 3, {
+        "number", "unlocked_locked_transition_offset_degrees", "Unlocked to locked transition offset degrees",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"unlockedToLockedTransitionOffsetDegrees\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.unlockedToLockedTransitionOffsetDegrees}}",)"
+        R"("min":"-180",)"
+        R"("max":"180")"
+    } },
+    { 4, {
+        "number", "lockngo_timeout", "Lock n Go timeout",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"lockNgoTimeout\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.lockNgoTimeout}}",)"
+        R"("min":"5",)"
+        R"("max":"60")"
+    } },
+    { 5, {
+        "select", "single_button_press_action", "Single button press action",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.singleButtonPressAction}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"singleButtonPressAction\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Intelligent","Unlock","Lock","Unlatch","Lock n Go",)"
+        R"("Show Status"])"
+    } },
+    { 6, {
+        "select", "double_button_press_action", "Double button press action",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.doubleButtonPressAction}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"doubleButtonPressAction\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Intelligent","Unlock","Lock","Unlatch","Lock n Go",)"
+        R"("Show Status"])"
+    } },
+    { 7, {
+        "switch", "detached_cylinder", "Detached cylinder",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"detachedCylinder\": \"1\"}",)"
+        R"("pl_off":"{ \"detachedCylinder\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.detachedCylinder}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 10, {
+        "number", "unlatch_duration", "Unlatch duration",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"unlatchDuration\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.unlatchDuration}}",)"
+        R"("min":"1",)"
+        R"("max":"30")"
+    } },
+    { 11, {
+        "number", "auto_lock_timeout", "Auto lock timeout",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"autoLockTimeOut\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.autoLockTimeOut}}",)"
+        R"("min":"30",)"
+        R"("max":"1800")"
+    } },
+    { 13, {
+        "switch", "nightmode_enabled", "Nightmode enabled",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"nightModeEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"nightModeEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.nightModeEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 14, {
+        "text", "nightmode_start_time", "Nightmode start time",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pattern":"([0-1][0-9]|2[0-3]):[0-5][0-9]",)"
+        R"("cmd_tpl":"{ \"nightModeStartTime\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.nightModeStartTime}}",)"
+        R"("min":"5",)"
+        R"("max":"5")"
+    } },
+    { 15, {
+        "text", "nightmode_end_time", "Nightmode end time",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pattern":"([0-1][0-9]|2[0-3]):[0-5][0-9]",)"
+        R"("cmd_tpl":"{ \"nightModeEndTime\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.nightModeEndTime}}",)"
+        R"("min":"5",)"
+        R"("max":"5")"
+    } },
+    { 16, {
+        "switch", "nightmode_auto_lock", "Nightmode auto lock",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"nightModeAutoLockEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"nightModeAutoLockEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.nightModeAutoLockEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 17, {
+        "switch", "nightmode_auto_unlock", "Nightmode auto unlock",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"nightModeAutoUnlockDisabled\": \"0\"}",)"
+        R"("pl_off":"{ \"nightModeAutoUnlockDisabled\": \"1\"}",)"
+        R"("val_tpl":"{{value_json.nightModeAutoUnlockDisabled}}",)"
+        R"("stat_on":"0",)"
+        R"("stat_off":"1")"
+    } },
+    { 18, {
+        "switch", "nightmode_immediate_lock_start", "Nightmode immediate lock on start",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"nightModeImmediateLockOnStart\": \"1\"}",)"
+        R"("pl_off":"{ \"nightModeImmediateLockOnStart\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.nightModeImmediateLockOnStart}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 20, {
+        "switch", "immediate_auto_lock_enabled", "Immediate auto lock enabled",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"immediateAutoLockEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"immediateAutoLockEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.immediateAutoLockEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 21, {
+        "switch", "auto_update_enabled", "Auto update enabled",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"autoUpdateEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"autoUpdateEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.autoUpdateEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 23, {
+        "select", "motor_speed", "Motor speed",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.motorSpeed}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"motorSpeed\": \"{{ value }}\" }",)"
+        R"("options":["Standard","Insane","Gentle"])"
+    } },
+    { 24, {
+        "switch", "enable_slow_speed_during_nightmode", "Enable slow speed during nightmode",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"enableSlowSpeedDuringNightMode\": \"1\"}",)"
+        R"("pl_off":"{ \"enableSlowSpeedDuringNightMode\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.enableSlowSpeedDuringNightMode}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 22, {
+        "button", "reboot_nuki", "Reboot Nuki",
+        nullptr, nullptr, nullptr, "diagnostic", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"rebootNuki\": \"1\"}",)"
+        R"("pl_off":"{ \"rebootNuki\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.rebootNuki}}")"
+    } },
+};
+
+// Not supported by Smart Lock Ultra and 5th generation locks, published depending on the ACL preferences
+constexpr HassEntity hassLockBatteryType =
+{
+    "select", "battery_type", "Battery type",
+    mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+    R"("val_tpl":"{{value_json.batteryType}}",)"
+    R"("en":true,)"
+    R"("cmd_tpl":"{ \"batteryType\": \"{{ value }}\" }",)"
+    R"("options":["Alkali","Accumulators","Lithium"])"
+};
+
+constexpr HassEntity hassLockAutomaticBatteryTypeDetection =
+{
+    "switch", "automatic_battery_type_detection", "Automatic battery type detection",
+    mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+    R"("en":true,)"
+    R"("pl_on":"{ \"automaticBatteryTypeDetection\": \"1\"}",)"
+    R"("pl_off":"{ \"automaticBatteryTypeDetection\": \"0\"}",)"
+    R"("val_tpl":"{{value_json.automaticBatteryTypeDetection}}",)"
+    R"("stat_on":"1",)"
+    R"("stat_off":"0")"
+};
+
+// Opener, indexed by the ACL preferences
+constexpr HassAclEntity hassOpenerActionEntities[] =
+{
+    { 11, {
+        "button", "unlatch", "Open",
+        nullptr, nullptr, nullptr, nullptr, mqtt_topic_lock_action,
+        R"("en":false,)"
+        R"("pl_prs":"electricStrikeActuation")"
+    } },
+};
+
+// Opener
+constexpr HassEntity hassOpenerEntities[] =
+{
+    {
+        "binary_sensor", "continuous_mode", "Continuous mode",
+        mqtt_topic_lock_continuous_mode, "lock", nullptr, nullptr, nullptr,
+        R"("pl_on":"on",)"
+        R"("pl_off":"off")"
+    },
+    {
+        "binary_sensor", "ring_detect", "Ring detect",
+        mqtt_topic_lock_binary_ring, "sound", nullptr, nullptr, nullptr,
+        R"("pl_on":"ring",)"
+        R"("pl_off":"standby")"
+    },
+    {
+        "event", "ring", "Ring",
+        mqtt_topic_lock_ring, "doorbell", nullptr, nullptr, nullptr,
+        R"("val_tpl":"{ \"event_type\": \"{{ value }}\" }",)"
+        R"("event_types":["ring","ringlocked","standby"])",
+        "_ring_event"
+    },
+};
+
+constexpr HassEntity hassOpenerContinuousModeSwitch =
+{
+    "switch", "continuous_mode", "Continuous mode",
+    mqtt_topic_lock_continuous_mode, nullptr, nullptr, nullptr, mqtt_topic_lock_action,
+    R"("en":true,)"
+    R"("stat_on":"on",)"
+    R"("stat_off":"off",)"
+    R"("pl_on":"activateCM",)"
+    R"("pl_off":"deactivateCM")"
+};
+
+// Opener configuration, indexed by the basic opener config ACL preferences
+constexpr HassAclEntity hassOpenerBasicConfigEntities[] =
+{
+    { 5, {
+        "switch", "led_enabled", "LED enabled",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("ic":"mdi:led-variant-on",)"
+        R"("pl_on":"{ \"ledFlashEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"ledFlashEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.ledFlashEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 4, {
+        "switch", "button_enabled", "Button enabled",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("ic":"mdi:radiobox-marked",)"
+        R"("pl_on":"{ \"buttonEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"buttonEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.buttonEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 3, {
+        "switch", "pairing_enabled", "Pairing enabled",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"pairingEnabled\": \"1\"}",)"
+        R"("pl_off":"{ \"pairingEnabled\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.pairingEnabled}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 6, {
+        "number", "timezone_offset", "Timezone offset",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("ic":"mdi:timer-cog-outline",)"
+        R"("cmd_tpl":"{ \"timeZoneOffset\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.timeZoneOffset}}",)"
+        R"("min":"0",)"
+        R"("max":"60")"
+    } },
+    { 7, {
+        "switch", "dst_mode", "DST mode European",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"dstMode\": \"1\"}",)"
+        R"("pl_off":"{ \"dstMode\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.dstMode}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 8, {
+        "select", "fob_action_1", "Fob action 1",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.fobAction1}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"fobAction1\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Toggle RTO","Activate RTO","Deactivate RTO","Open","Ring"])"
+    } },
+    { 9, {
+        "select", "fob_action_2", "Fob action 2",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.fobAction2}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"fobAction2\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Toggle RTO","Activate RTO","Deactivate RTO","Open","Ring"])"
+    } },
+    { 10, {
+        "select", "fob_action_3", "Fob action 3",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.fobAction3}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"fobAction3\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Toggle RTO","Activate RTO","Deactivate RTO","Open","Ring"])"
+    } },
+    { 12, {
+        "select", "advertising_mode", "Advertising mode",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.advertisingMode}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"advertisingMode\": \"{{ value }}\" }",)"
+        R"("options":["Automatic","Normal","Slow","Slowest"])"
+    } },
+    { 13, {
+        "select", "timezone", "Timezone",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.timeZone}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"timeZone\": \"{{ value }}\" }",)"
+        R"("options":["Africa/Cairo","Africa/Lagos","Africa/Maputo","Africa/Nairobi","America/Anchorage","America/Argentina/Buenos_Aires",)"
+        R"("America/Chicago","America/Denver","America/Halifax","America/Los_Angeles","America/Manaus","America/Mexico_City",)"
+        R"("America/New_York","America/Phoenix","America/Regina","America/Santiago","America/Sao_Paulo","America/St_Johns",)"
+        R"("Asia/Bangkok","Asia/Dubai","Asia/Hong_Kong","Asia/Jerusalem","Asia/Karachi","Asia/Kathmandu",)"
+        R"("Asia/Kolkata","Asia/Riyadh","Asia/Seoul","Asia/Shanghai","Asia/Tehran","Asia/Tokyo",)"
+        R"("Asia/Yangon","Australia/Adelaide","Australia/Brisbane","Australia/Darwin","Australia/Hobart","Australia/Perth",)"
+        R"("Australia/Sydney","Europe/Berlin","Europe/Helsinki","Europe/Istanbul","Europe/London","Europe/Moscow",)"
+        R"("Pacific/Auckland","Pacific/Guam","Pacific/Honolulu","Pacific/Pago_Pago","None"])"
+    } },
+    { 11, {
+        "select", "operating_mode", "Operating mode",
+        mqtt_topic_config_basic_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.operatingMode}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"operatingMode\": \"{{ value }}\" }",)"
+        R"("options":["Generic door opener","Analogue intercom","Digital intercom","Siedle","TCS","Bticino",)"
+        R"("Siedle HTS","STR","Ritto","Fermax","Comelit","Urmet BiBus",)"
+        R"("Urmet 2Voice","Golmar","SKS","Spare"])"
+    } },
+};
+
+// Opener configuration, indexed by the advanced opener config ACL preferences
+constexpr HassAclEntity hassOpenerAdvancedConfigEntities[] =
+{
+    { 15, {
+        "number", "sound_level", "Sound level",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("ic":"mdi:volume-source",)"
+        R"("cmd_tpl":"{ \"soundLevel\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.soundLevel}}",)"
+        R"("min":"0",)"
+        R"("max":"255",)"
+        R"("mode":"slider",)"
+        R"("step":"25.5")"
+    } },
+    { 1, {
+        "switch", "bus_mode_switch", "BUS mode switch analogue",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"busModeSwitch\": \"1\"}",)"
+        R"("pl_off":"{ \"busModeSwitch\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.busModeSwitch}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 2, {
+        "number", "short_circuit_duration", "Short circuit duration",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"shortCircuitDuration\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.shortCircuitDuration}}",)"
+        R"("min":"0")"
+    } },
+    { 3, {
+        "number", "electric_strike_delay", "Electric strike delay",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"electricStrikeDelay\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.electricStrikeDelay}}",)"
+        R"("min":"0",)"
+        R"("max":"30000",)"
+        R"("step":"3000")"
+    } },
+    { 4, {
+        "switch", "random_electric_strike_delay", "Random electric strike delay",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"randomElectricStrikeDelay\": \"1\"}",)"
+        R"("pl_off":"{ \"randomElectricStrikeDelay\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.randomElectricStrikeDelay}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 5, {
+        "number", "electric_strike_duration", "Electric strike duration",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"electricStrikeDuration\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.electricStrikeDuration}}",)"
+        R"("min":"1000",)"
+        R"("max":"30000",)"
+        R"("step":"3000")"
+    } },
+    { 6, {
+        "switch", "disable_rto_after_ring", "Disable RTO after ring",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"disableRtoAfterRing\": \"1\"}",)"
+        R"("pl_off":"{ \"disableRtoAfterRing\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.disableRtoAfterRing}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 7, {
+        "number", "rto_timeout", "RTO timeout",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"rtoTimeout\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.rtoTimeout}}",)"
+        R"("min":"5",)"
+        R"("max":"60")"
+    } },
+    { 8, {
+        "select", "doorbell_suppression", "Doorbell suppression",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.doorbellSuppression}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"doorbellSuppression\": \"{{ value }}\" }",)"
+        R"("options":["Off","CM","RTO","CM & RTO","Ring","CM & Ring",)"
+        R"("RTO & Ring","CM & RTO & Ring"])"
+    } },
+    { 9, {
+        "number", "doorbell_suppression_duration", "Doorbell suppression duration",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"doorbellSuppressionDuration\": \"{{ value }}\" }",)"
+        R"("val_tpl":"{{value_json.doorbellSuppressionDuration}}",)"
+        R"("min":"500",)"
+        R"("max":"10000",)"
+        R"("step":"1000")"
+    } },
+    { 10, {
+        "select", "sound_ring", "Sound ring",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.soundRing}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"soundRing\": \"{{ value }}\" }",)"
+        R"("options":["No Sound","Sound 1","Sound 2","Sound 3"])"
+    } },
+    { 11, {
+        "select", "sound_open", "Sound open",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.soundOpen}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"soundOpen\": \"{{ value }}\" }",)"
+        R"("options":["No Sound","Sound 1","Sound 2","Sound 3"])"
+    } },
+    { 12, {
+        "select", "sound_rto", "Sound RTO",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.soundRto}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"soundRto\": \"{{ value }}\" }",)"
+        R"("options":["No Sound","Sound 1","Sound 2","Sound 3"])"
+    } },
+    { 13, {
+        "select", "sound_cm", "Sound CM",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.soundCm}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"soundCm\": \"{{ value }}\" }",)"
+        R"("options":["No Sound","Sound 1","Sound 2","Sound 3"])"
+    } },
+    { 14, {
+        "switch", "sound_confirmation", "Sound confirmation",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"soundConfirmation\": \"1\"}",)"
+        R"("pl_off":"{ \"soundConfirmation\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.soundConfirmation}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 16, {
+        "select", "single_button_press_action", "Single button press action",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.singleButtonPressAction}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"singleButtonPressAction\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Toggle RTO","Activate RTO","Deactivate RTO","Toggle CM","Activate CM",)"
+        R"("Deactivate CM","Open"])"
+    } },
+    { 17, {
+        "select", "double_button_press_action", "Double button press action",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.doubleButtonPressAction}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"doubleButtonPressAction\": \"{{ value }}\" }",)"
+        R"("options":["No Action","Toggle RTO","Activate RTO","Deactivate RTO","Toggle CM","Activate CM",)"
+        R"("Deactivate CM","Open"])"
+    } },
+    { 18, {
+        "select", "battery_type", "Battery type",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("val_tpl":"{{value_json.batteryType}}",)"
+        R"("en":true,)"
+        R"("cmd_tpl":"{ \"batteryType\": \"{{ value }}\" }",)"
+        R"("options":["Alkali","Accumulators","Lithium"])"
+    } },
+    { 19, {
+        "switch", "automatic_battery_type_detection", "Automatic battery type detection",
+        mqtt_topic_config_advanced_json, nullptr, nullptr, "config", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_on":"{ \"automaticBatteryTypeDetection\": \"1\"}",)"
+        R"("pl_off":"{ \"automaticBatteryTypeDetection\": \"0\"}",)"
+        R"("val_tpl":"{{value_json.automaticBatteryTypeDetection}}",)"
+        R"("stat_on":"1",)"
+        R"("stat_off":"0")"
+    } },
+    { 20, {
+        "button", "reboot_nuki", "Reboot Nuki",
+        nullptr, nullptr, nullptr, "diagnostic", mqtt_topic_config_action,
+        R"("en":true,)"
+        R"("pl_prs":"{ \"rebootNuki\": \"1\"}")"
+    } },
+};
+
+// Authorization log
+constexpr HassEntity hassLastActionAuthorization =
+{
+    "sensor", "last_action_authorization", "Last action authorization",
+    mqtt_topic_lock_log, nullptr, nullptr, "diagnostic", nullptr,
+    R"("ic":"mdi:format-list-bulleted",)"
+    R"("val_tpl":"{{ (value_json|selectattr('type', 'eq', 'LockAction')|selectattr('action', 'in', ['Lock', 'Unlock', 'Unlatch'])|first|default).authorizationName|default }}")"
+};
+
+constexpr HassEntity hassRollingLog =
+{
+    "sensor", "rolling_log", "Rolling authorization log",
+    mqtt_topic_lock_log_rolling, nullptr, nullptr, "diagnostic", nullptr,
+    R"("ic":"mdi:format-list-bulleted",)"
+    R"("val_tpl":"{{value_json.index}}")"
+};
+
+// Keypad
+constexpr HassEntity hassKeypadEntities[] =
+{
+    {
+        "binary_sensor", "keypad_battery_low", "Keypad battery low",
+        mqtt_topic_battery_basic_json, "battery", nullptr, "diagnostic", nullptr,
+        R"("pl_on":"1",)"
+        R"("pl_off":"0",)"
+        R"("val_tpl":"{{value_json.keypadCritical}}")"
+    },
+    {
+        "button", "query_keypad", "Query keypad",
+        nullptr, nullptr, nullptr, "diagnostic", mqtt_topic_query_keypad,
+        R"("en":false,)"
+        R"("pl_prs":"1")"
+    },
+    {
+        "sensor", "keypad_status", "Keypad status",
+        mqtt_topic_lock_log, nullptr, nullptr, "diagnostic", nullptr,
+        R"("ic":"mdi:drag-vertical",)"
+        R"("val_tpl":"{{ (value_json|selectattr('type', 'eq', 'KeypadAction')|first|default).completionStatus|default }}")",
+        "_keypad_stats"
+    },
+};
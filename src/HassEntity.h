@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+// Member that is only known at runtime, "true" and "false" are published as booleans
+struct HassEntityField
+{
+    const char* key;
+    const char* value;
+};
+
+// Static part of a Home Assistant discovery config, see HassEntities.h.
+// Topics are relative to the device base topic ("~"), nullptr or "" leaves the member out.
+struct HassEntity
+{
+    const char* component;
+    const char* objectId;
+    const char* displayName;
+    const char* stateTopic;
+    const char* deviceClass;
+    const char* stateClass;
+    const char* entityCategory;
+    const char* commandTopic;
+    // Remaining members, already serialized, e.g. R"("en":true,"ic":"mdi:counter")"
+    const char* fields;
+    // Appended to the device id to form the unique id, nullptr for "_" + objectId
+    const char* uniqueIdSuffix;
+};
+
+// Entity that is published if the index of the ACL preferences is set and removed otherwise
+struct HassAclEntity
+{
+    uint8_t aclIndex;
+    HassEntity entity;
+};
@@ -0,0 +1,204 @@
+#include "HassJsonWriter.h"
+
+HassJsonWriter::HassJsonWriter(uint8_t* buffer, size_t size)
+    : _buffer(buffer),
+      _size(size)
+{
+}
+
+HassJsonWriter::HassJsonWriter(MqttPublishCache::ValueHasher& hasher)
+    : _buffer(nullptr),
+      _size(0),
+      _hasher(&hasher)
+{
+}
+
+void HassJsonWriter::beginObject()
+{
+    separator();
+    put('{');
+    _first = true;
+}
+
+void HassJsonWriter::beginObject(const char* key)
+{
+    this->key({ key });
+    put('{');
+    _first = true;
+}
+
+void HassJsonWriter::endObject()
+{
+    put('}');
+    _first = false;
+}
+
+void HassJsonWriter::beginArray(const char* key)
+{
+    this->key({ key });
+    put('[');
+    _first = true;
+}
+
+void HassJsonWriter::endArray()
+{
+    put(']');
+    _first = false;
+}
+
+void HassJsonWriter::member(const char* key, std::initializer_list<const char*> parts)
+{
+    this->key({ key });
+    string(parts);
+    _first = false;
+}
+
+void HassJsonWriter::member(const char* key, const char* value)
+{
+    member(key, { value });
+}
+
+void HassJsonWriter::member(const char* key, bool value)
+{
+    this->key({ key });
+    put(value ? "true" : "false");
+    _first = false;
+}
+
+void HassJsonWriter::optionalMember(const char* key, const char* value, const char* prefix)
+{
+    if(value != nullptr && value[0] != 0x00)
+    {
+        member(key, { prefix, value });
+    }
+}
+
+void HassJsonWriter::element(const char* value, const char* prefix)
+{
+    separator();
+    string({ prefix, value });
+    _first = false;
+}
+
+void HassJsonWriter::rawMembers(const char* members)
+{
+    if(members != nullptr && members[0] != 0x00)
+    {
+        separator();
+        put(members);
+        _first = false;
+    }
+}
+
+size_t HassJsonWriter::length() const
+{
+    return _length;
+}
+
+void HassJsonWriter::key(std::initializer_list<const char*> parts)
+{
+    separator();
+    string(parts);
+    put(':');
+    _first = true;
+}
+
+size_t HassJsonWriter::write(uint8_t c)
+{
+    put((char)c);
+    _first = false;
+    return 1;
+}
+
+size_t HassJsonWriter::write(const uint8_t* data, size_t length)
+{
+    for(size_t i = 0; i < length; i++)
+    {
+        put((char)data[i]);
+    }
+    _first = false;
+    return length;
+}
+
+void HassJsonWriter::separator()
+{
+    if(!_first)
+    {
+        put(',');
+    }
+}
+
+void HassJsonWriter::string(std::initializer_list<const char*> parts)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    put('"');
+    for(const char* part : parts)
+    {
+        if(part == nullptr)
+        {
+            continue;
+        }
+        for(const char* c = part; *c != 0x00; ++c)
+        {
+            switch(*c)
+            {
+                case '"':
+                    put("\\\"");
+                    break;
+                case '\\':
+                    put("\\\\");
+                    break;
+                case '\b':
+                    put("\\b");
+                    break;
+                case '\f':
+                    put("\\f");
+                    break;
+                case '\n':
+                    put("\\n");
+                    break;
+                case '\r':
+                    put("\\r");
+                    break;
+                case '\t':
+                    put("\\t");
+                    break;
+                default:
+                    if((uint8_t)*c < 0x20)
+                    {
+                        put("\\u00");
+                        put(hex[(uint8_t)*c >> 4]);
+                        put(hex[*c & 0x0F]);
+                    }
+                    else
+                    {
+                        put(*c);
+                    }
+                    break;
+            }
+        }
+    }
+    put('"');
+}
+
+void HassJsonWriter::put(char c)
+{
+    if(_length < _size)
+    {
+        _buffer[_length] = c;
+    }
+    if(_hasher != nullptr)
+    {
+        _hasher->write((uint8_t)c);
+    }
+    ++_length;
+}
+
+void HassJsonWriter::put(const char* str)
+{
+    while(*str != 0x00)
+    {
+        put(*str++);
+    }
+}
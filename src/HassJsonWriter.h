@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <initializer_list>
+#include "MqttPublishCache.h"
+
+// Streams a Home Assistant discovery config as JSON without building a document first.
+// Constructed without a buffer it only counts, so the same code measures the payload and then writes it into the MQTT packet.
+class HassJsonWriter
+{
+public:
+    explicit HassJsonWriter(uint8_t* buffer = nullptr, size_t size = 0);
+    // Only hashes the JSON, used to find out if a discovery config changed since it was last published
+    explicit HassJsonWriter(MqttPublishCache::ValueHasher& hasher);
+
+    void beginObject();
+    void beginObject(const char* key);
+    void endObject();
+    void beginArray(const char* key);
+    void endArray();
+
+    // String member, the non-null parts are concatenated
+    void member(const char* key, std::initializer_list<const char*> parts);
+    void member(const char* key, const char* value);
+    void member(const char* key, bool value);
+    // String member that is skipped if value is nullptr or empty
+    void optionalMember(const char* key, const char* value, const char* prefix = nullptr);
+    void element(const char* value, const char* prefix = nullptr);
+    // Members that are already serialized, e.g. "en":true,"ic":"mdi:counter"
+    void rawMembers(const char* members);
+    // Key of the next value, the non-null parts are concatenated. Followed by beginObject() or serializeJson(json, writer).
+    void key(std::initializer_list<const char*> parts);
+
+    // Writer interface for ArduinoJson's serializeJson()
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* data, size_t length);
+
+    // Number of bytes of the complete JSON, even if it didn't fit into the buffer
+    size_t length() const;
+
+private:
+    void separator();
+    void string(std::initializer_list<const char*> parts);
+    void put(char c);
+    void put(const char* str);
+
+    uint8_t* _buffer;
+    size_t _size;
+    MqttPublishCache::ValueHasher* _hasher = nullptr;
+    size_t _length = 0;
+    bool _first = true;
+};
@@ -1,14 +1,36 @@
 #pragma once
-#include <Preferences.h>
+#include <initializer_list>
+#include <mutex>
+#include "CachedPreferences.h"
 #include <ArduinoJson.h>
 #include "networkDevices/NetworkDevice.h"
+#include "MqttQosPolicy.h"
+#include "HassEntity.h"
+
+class HassJsonWriter;
+
+struct HassDiscoveryProgress
+{
+    bool running;
+    // Discovery items (configs or removals) published by the current or last job
+    size_t published;
+    // Items of the job as counted by the last pass, 0 before the first pass
+    size_t total;
+    // Duration of the last completed job, or time since the running job started
+    int64_t duration;
+};
 
 class HomeAssistantDiscovery
 {
 public:
-    explicit HomeAssistantDiscovery(NetworkDevice* device, Preferences* preferences, char* buffer, size_t bufferSize);
+    explicit HomeAssistantDiscovery(NetworkDevice* device, CachedPreferences* preferences);
     void setupHASS(int type, uint32_t nukiId, char* nukiName, const char* firmwareVersion, const char* hardwareVersion, bool hasDoorSensor, bool hasKeypad);
     void disableHASS();
+    // Publishes the discovery of all devices again, even if it didn't change
+    void refresh();
+    // Publishes the next batch of the scheduled discovery jobs, called from the network task while MQTT is connected
+    void update();
+    HassDiscoveryProgress progress();
     void removeHassTopic(const String& mqttDeviceType, const String& mqttDeviceName, const String& uidString);
     void publishHassTopic(const String& mqttDeviceType,
                           const String& mqttDeviceName,
@@ -26,38 +48,90 @@ public:
                           std::vector<std::pair<char*, char*>> additionalEntries = {}
                           );    
 private:
+    struct DiscoveryJob
+    {
+        // 0 = Nuki Hub, 1 = lock, 2 = opener, -1 = none
+        int type = -1;
+        bool pending = false;
+        uint32_t nukiId = 0;
+        char name[33] = {0};
+        char firmwareVersion[20] = {0};
+        char hardwareVersion[20] = {0};
+        bool hasDoorSensor = false;
+        bool hasKeypad = false;
+        // Publish even if the hash matches the one of the last completed job
+        bool force = false;
+        uint32_t hash = 0;
+        // Items that are already published, a pass skips them
+        size_t nextItem = 0;
+        int64_t startTs = 0;
+    };
+
+    void runDiscoveryJob(const DiscoveryJob& job);
+    uint32_t discoveryHash(const DiscoveryJob& job);
+    const char* discoveryHashKey(int type);
+    bool beginDiscoveryItem();
+    void endDiscoveryItem(uint16_t packetId);
+    // Copies the job state for progress(), _jobMutex must be held
+    void snapshotProgress();
+
     void publishHASSConfig(char *deviceType, const char *baseTopic, char *name, char *uidString, const char *softwareVersion, const char *hardwareVersion, const bool& hasDoorSensor, const bool& hasKeypad, const bool& publishAuthData, char *lockAction, char *unlockAction, char *openAction);
+    void publishHASSDeviceDiscovery(char *deviceType, const char *baseTopic, char *name, char *uidString, const char *softwareVersion, const char *hardwareVersion, const bool& hasDoorSensor, const bool& hasKeypad, const bool& publishAuthData, char *lockAction, char *unlockAction, char *openAction);
+    void createHassDevice(JsonObject dev, const char* deviceType, const char* name, const char* uidString, const char *softwareVersion, const char *hardwareVersion);
     void publishHASSDeviceConfig(char* deviceType, const char* baseTopic, char* name, char* uidString, const char *softwareVersion, const char *hardwareVersion, const char* availabilityTopic, const bool& hasKeypad, char* lockAction, char* unlockAction, char* openAction);
     void publishHASSNukiHubConfig();
+    uint16_t publishHASSNukiHubResetConfig();
 
-    void publishHASSConfigAdditionalLockEntities(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigDoorSensor(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigAdditionalOpenerEntities(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigAccessLog(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigKeypad(char* deviceType, const char* baseTopic, char* name, char* uidString);
+    void publishHASSConfigAdditionalLockEntities(const char* baseTopic, char* uidString);
+    void publishHASSConfigDoorSensor(const char* baseTopic, char* uidString);
+    void publishHASSConfigAdditionalOpenerEntities(const char* baseTopic, char* uidString);
+    void publishHASSConfigAccessLog(const char* baseTopic, char* uidString);
+    void publishHASSConfigKeypad(const char* baseTopic, char* uidString);
     void publishHASSConfigWifiRssi(char* deviceType, const char* baseTopic, char* name, char* uidString);
+    uint16_t publishJson(const char* path, JsonVariantConst json);
 
+    void publishHassEntity(const HassEntity& entity, const char* uidString, const char* baseTopic, std::initializer_list<HassEntityField> fields = {});
+    void removeHassEntity(const HassEntity& entity, const char* uidString);
+    void removeHassComponent(const char* mqttDeviceType, const char* mqttDeviceName, const char* uidString);
+    void publishHassJson(const char* mqttDeviceType, const char* mqttDeviceName, const char* uidString, JsonDocument& json);
+
+    template<size_t N>
+    void publishHassEntities(const HassEntity (&entities)[N], const char* uidString, const char* baseTopic)
+    {
+        for(const HassEntity& entity : entities)
+        {
+            publishHassEntity(entity, uidString, baseTopic);
+        }
+    }
+
+    template<size_t N>
+    void publishHassEntities(const HassAclEntity (&entities)[N], const uint32_t* aclPrefs, const char* uidString, const char* baseTopic)
+    {
+        for(const HassAclEntity& aclEntity : entities)
+        {
+            if((int)aclPrefs[aclEntity.aclIndex] == 1)
+            {
+                publishHassEntity(aclEntity.entity, uidString, baseTopic);
+            }
+            else
+            {
+                removeHassEntity(aclEntity.entity, uidString);
+            }
+        }
+    }
+
+    uint16_t publishHassConfig(const HassEntity& entity, const char* uidString, const char* baseTopic, const char* topicPrefix, const HassEntityField* fields, size_t fieldCount);
+    void writeHassConfig(HassJsonWriter& writer, const HassEntity& entity, const char* uidString, const char* baseTopic, const char* topicPrefix, const HassEntityField* fields, size_t fieldCount, bool deviceComponent);
 
     void removeHASSConfig(char* uidString);
     void removeHASSConfigTopic(char* deviceType, char* name, char* uidString);
+    uint16_t removeHassConfigPath(const char* mqttDeviceType, const char* mqttDeviceName, const char* uidString);
 
-    String createHassTopicPath(const String& mqttDeviceType, const String& mqttDeviceName, const String& uidString);
-    JsonDocument createHassJson(const String& uidString,
-                                const String& uidStringPostfix,
-                                const String& displayName,
-                                const String& name,
-                                const String& baseTopic,
-                                const String& stateTopic,
-                                const String& deviceType,
-                                const String& deviceClass,
-                                const String& stateClass = "",
-                                const String& entityCat = "",
-                                const String& commandTopic = "",
-                                std::vector<std::pair<char*, char*>> additionalEntries = {}
-                                );
+    void createHassTopicPath(char* path, size_t size, const char* mqttDeviceType, const char* mqttDeviceName, const char* uidString);
+    void createHassDevicePath(char* path, size_t size, const char* uidString);
 
     NetworkDevice* _device = nullptr;
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
     
     String _discoveryTopic;
     String _baseTopic;
@@ -68,7 +142,27 @@ private:
     bool _offEnabled = false;
     bool _checkUpdates = false;
     bool _updateFromMQTT = false;
-    
-    char* _buffer;
-    const size_t _bufferSize;
+    uint8_t _qos = 1;
+    // Device based discovery publishes all entities of a lock or opener in one config
+    bool _deviceDiscovery = false;
+    // Set while the components of a device config are written, entities are written into it instead of being published
+    HassJsonWriter* _deviceWriter = nullptr;
+    // Set while the hash of a job is computed, configs are written into it instead of being published
+    HassJsonWriter* _hashWriter = nullptr;
+
+    // setupHASS() is called from the nuki task, it only hands the job over to the network task
+    std::mutex _jobMutex;
+    DiscoveryJob _jobRequests[3];
+    DiscoveryJob _job;
+    bool _jobCancelled = false;
+    // Set while a pass of _job runs
+    bool _jobPassRunning = false;
+    bool _jobPassBlocked = false;
+    size_t _jobPassItem = 0;
+    size_t _jobPassPublished = 0;
+    size_t _jobTotal = 0;
+    int64_t _jobDuration = 0;
+    // progress() is called from the web server, it only reads this copy of the job state
+    HassDiscoveryProgress _progress = { false, 0, 0, 0 };
+    int64_t _progressStartTs = 0;
 };
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "MqttDispatcher.h"
+#include <cstdlib>
+#include <cstring>
+
+bool MqttDispatcher::add(const char* path, MqttTopicHandler handler)
+{
+    uint32_t h = hash(path);
+
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    if(find(path, h) >= 0 || _entries.size() >= MQTT_DISPATCHER_EMPTY_SLOT - 1)
+    {
+        return false;
+    }
+
+    size_t len = strlen(path);
+    char* interned = (char*)malloc(len + 1);
+    if(interned == nullptr)
+    {
+        return false;
+    }
+    memcpy(interned, path, len + 1);
+
+    _entries.push_back({ interned, h, 0, handler });
+
+    // Keep the load factor at or below 50% so probe sequences stay short
+    if(_slots.empty() || _entries.size() * 2 > _slots.size())
+    {
+        grow();
+    }
+    else
+    {
+        insertSlot(_entries.size() - 1);
+    }
+
+    return true;
+}
+
+bool MqttDispatcher::dispatch(const char* topic, const char* data, const unsigned int length)
+{
+    uint32_t h = hash(topic);
+    MqttTopicHandler handler;
+
+    {
+        const std::lock_guard<std::mutex> lock(_mutex);
+
+        int index = find(topic, h);
+        if(index < 0)
+        {
+            ++_unhandled;
+            return false;
+        }
+
+        Entry& entry = _entries[index];
+        ++entry.messageCount;
+        ++_handled;
+        handler = entry.handler;
+    }
+
+    // Handlers run without the lock, they may take long (BLE commands) or subscribe to further topics
+    handler(topic, data, length);
+    return true;
+}
+
+bool MqttDispatcher::accepts(const char* topic)
+{
+    uint32_t h = hash(topic);
+
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    if(find(topic, h) < 0)
+    {
+        ++_unhandled;
+        return false;
+    }
+
+    return true;
+}
+
+uint32_t MqttDispatcher::messageCount(const char* path)
+{
+    uint32_t h = hash(path);
+
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    int index = find(path, h);
+    return index < 0 ? 0 : _entries[index].messageCount;
+}
+
+uint32_t MqttDispatcher::handledCount()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _handled;
+}
+
+uint32_t MqttDispatcher::unhandledCount()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _unhandled;
+}
+
+size_t MqttDispatcher::size()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+}
+
+int MqttDispatcher::find(const char* path, const uint32_t h)
+{
+    if(_slots.empty())
+    {
+        return -1;
+    }
+
+    size_t mask = _slots.size() - 1;
+    for(size_t i = h & mask; ; i = (i + 1) & mask)
+    {
+        uint16_t entryIndex = _slots[i];
+        if(entryIndex == MQTT_DISPATCHER_EMPTY_SLOT)
+        {
+            return -1;
+        }
+
+        const Entry& entry = _entries[entryIndex];
+        if(entry.hash == h && strcmp(entry.path, path) == 0)
+        {
+            return entryIndex;
+        }
+    }
+}
+
+void MqttDispatcher::insertSlot(const uint16_t entryIndex)
+{
+    size_t mask = _slots.size() - 1;
+    size_t i = _entries[entryIndex].hash & mask;
+
+    while(_slots[i] != MQTT_DISPATCHER_EMPTY_SLOT)
+    {
+        i = (i + 1) & mask;
+    }
+
+    _slots[i] = entryIndex;
+}
+
+void MqttDispatcher::grow()
+{
+    size_t slotCount = _slots.empty() ? MQTT_DISPATCHER_INITIAL_SLOTS : _slots.size() * 2;
+    _slots.assign(slotCount, MQTT_DISPATCHER_EMPTY_SLOT);
+
+    for(size_t i = 0; i < _entries.size(); i++)
+    {
+        insertSlot(i);
+    }
+}
+
+uint32_t MqttDispatcher::hash(const char* path)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+
+    for(const char* c = path; *c != 0; c++)
+    {
+        h ^= (uint8_t)*c;
+        h *= 16777619u;
+    }
+
+    return h;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#define MQTT_DISPATCHER_INITIAL_SLOTS 64
+#define MQTT_DISPATCHER_EMPTY_SLOT 0xffff
+
+typedef std::function<void(const char* topic, const char* data, const unsigned int length)> MqttTopicHandler;
+
+// Routes incoming MQTT messages to the handler registered for their full topic path.
+// Paths are interned once at registration and looked up through an open addressing table, so dispatching a message costs one hash and (usually) one strcmp.
+class MqttDispatcher
+{
+public:
+    // Returns false if the path already has a handler
+    bool add(const char* path, MqttTopicHandler handler);
+    // Returns false if no handler is registered for topic
+    bool dispatch(const char* topic, const char* data, const unsigned int length);
+    // Checks for a handler before a message is buffered, messages without one are counted as unhandled
+    bool accepts(const char* topic);
+
+    uint32_t messageCount(const char* path);
+    uint32_t handledCount();
+    uint32_t unhandledCount();
+    size_t size();
+
+private:
+    struct Entry
+    {
+        char* path;
+        uint32_t hash;
+        uint32_t messageCount;
+        MqttTopicHandler handler;
+    };
+
+    static uint32_t hash(const char* path);
+    int find(const char* path, const uint32_t h);
+    void insertSlot(const uint16_t entryIndex);
+    void grow();
+
+    std::vector<Entry> _entries;
+    std::vector<uint16_t> _slots;
+    uint32_t _handled = 0;
+    uint32_t _unhandled = 0;
+    std::mutex _mutex;
+};
@@ -0,0 +1,134 @@
+#include "MqttPublishCache.h"
+#include <cstring>
+
+MqttPublishCache::MqttPublishCache(const int64_t refreshInterval)
+    : _refreshInterval(refreshInterval)
+{
+}
+
+uint32_t MqttPublishCache::pathHash(const char* path)
+{
+    size_t length = 0;
+    return hash(path, length);
+}
+
+bool MqttPublishCache::update(const uint32_t pathHash, const char* value, const int64_t ts)
+{
+    ValueHasher hasher;
+
+    if(value != nullptr)
+    {
+        hasher.write((const uint8_t*)value, strlen(value));
+    }
+
+    return update(pathHash, hasher, ts);
+}
+
+bool MqttPublishCache::update(const uint32_t pathHash, const ValueHasher& value, const int64_t ts)
+{
+    uint32_t valueHash = value.hash();
+    size_t valueLength = value.length();
+
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    if(_excluded.count(pathHash) > 0)
+    {
+        return true;
+    }
+
+    auto it = _entries.find(pathHash);
+
+    if(it != _entries.end() &&
+            it->second.valueHash == valueHash &&
+            it->second.valueLength == valueLength &&
+            ts - it->second.publishedTs < _refreshInterval)
+    {
+        _hits++;
+        return false;
+    }
+
+    _entries[pathHash] = { valueHash, (uint32_t)valueLength, ts };
+    _misses++;
+    return true;
+}
+
+void MqttPublishCache::invalidate(const uint32_t pathHash)
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    _entries.erase(pathHash);
+}
+
+void MqttPublishCache::exclude(const char* path)
+{
+    size_t length = 0;
+    uint32_t pathHash = hash(path, length);
+
+    const std::lock_guard<std::mutex> lock(_mutex);
+    _excluded.insert(pathHash);
+    _entries.erase(pathHash);
+}
+
+void MqttPublishCache::clear()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    _entries.clear();
+}
+
+uint32_t MqttPublishCache::hits() const
+{
+    return _hits;
+}
+
+uint32_t MqttPublishCache::misses() const
+{
+    return _misses;
+}
+
+uint32_t MqttPublishCache::hash(const char* str, size_t& length)
+{
+    // FNV-1a
+    uint32_t h = 2166136261u;
+    length = 0;
+
+    if(str == nullptr)
+    {
+        return h;
+    }
+
+    while(str[length] != 0)
+    {
+        h ^= (uint8_t)str[length];
+        h *= 16777619u;
+        length++;
+    }
+
+    return h;
+}
+
+size_t MqttPublishCache::ValueHasher::write(uint8_t c)
+{
+    // FNV-1a, same as hash()
+    _hash ^= c;
+    _hash *= 16777619u;
+    _length++;
+    return 1;
+}
+
+size_t MqttPublishCache::ValueHasher::write(const uint8_t* data, size_t length)
+{
+    for(size_t i = 0; i < length; i++)
+    {
+        write(data[i]);
+    }
+    return length;
+}
+
+uint32_t MqttPublishCache::ValueHasher::hash() const
+{
+    return _hash;
+}
+
+size_t MqttPublishCache::ValueHasher::length() const
+{
+    return _length;
+}
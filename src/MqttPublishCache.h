@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+// Remembers a hash of the last value published to each retained topic, so unchanged values don't have to be sent again.
+class MqttPublishCache
+{
+public:
+    // Hashes a value while it's being written, e.g. by serializeJson(), so it doesn't have to be buffered
+    class ValueHasher
+    {
+    public:
+        size_t write(uint8_t c);
+        size_t write(const uint8_t* data, size_t length);
+
+        uint32_t hash() const;
+        size_t length() const;
+
+    private:
+        uint32_t _hash = 2166136261u;
+        size_t _length = 0;
+    };
+
+    explicit MqttPublishCache(const int64_t refreshInterval);
+
+    // Key of a path in the cache, paths from MqttTopicRegistry come with it precomputed
+    static uint32_t pathHash(const char* path);
+
+    // Returns true if value has to be published to path, i.e. it differs from the cached value or the refresh interval elapsed
+    bool update(const uint32_t pathHash, const char* value, const int64_t ts);
+    bool update(const uint32_t pathHash, const ValueHasher& value, const int64_t ts);
+    void invalidate(const uint32_t pathHash);
+    // Paths that are also written by other clients (e.g. command topics) are never cached
+    void exclude(const char* path);
+    void clear();
+
+    uint32_t hits() const;
+    uint32_t misses() const;
+
+private:
+    struct Entry
+    {
+        uint32_t valueHash;
+        uint32_t valueLength;
+        int64_t publishedTs;
+    };
+
+    static uint32_t hash(const char* str, size_t& length);
+
+    const int64_t _refreshInterval;
+    std::unordered_map<uint32_t, Entry> _entries;
+    std::unordered_set<uint32_t> _excluded;
+    std::mutex _mutex;
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+};
@@ -0,0 +1,65 @@
+#include "MqttQosPolicy.h"
+#include <cstring>
+#include "CachedPreferences.h"
+#include "PreferencesKeys.h"
+#include "MqttTopics.h"
+#include "Config.h"
+
+void MqttQosPolicy::load(CachedPreferences* preferences)
+{
+    const char* keys[] = { preference_mqtt_qos_state, preference_mqtt_qos_telemetry, preference_mqtt_qos_command };
+    const uint8_t defaults[] = { MQTT_QOS_LEVEL, MQTT_QOS_LEVEL_TELEMETRY, MQTT_QOS_LEVEL };
+
+    for(size_t i = 0; i < sizeof(_qos); i++)
+    {
+        int qos = preferences->getInt(keys[i], defaults[i]);
+        _qos[i] = (qos >= 0 && qos <= 2) ? qos : defaults[i];
+    }
+}
+
+uint8_t MqttQosPolicy::qos(const MqttTopicClass topicClass) const
+{
+    return _qos[(uint8_t)topicClass];
+}
+
+uint8_t MqttQosPolicy::qos(const char* topic) const
+{
+    return qos(classify(topic));
+}
+
+MqttTopicClass MqttQosPolicy::classify(const char* topic)
+{
+    static const char* const telemetryTopics[] =
+    {
+        mqtt_topic_wifi_rssi, mqtt_topic_uptime, mqtt_topic_freeheap, mqtt_topic_log, mqtt_topic_publish_cache_hits,
+        mqtt_topic_publish_cache_misses, mqtt_topic_mqtt_messages_handled, mqtt_topic_mqtt_messages_unhandled,
+        mqtt_topic_mqtt_ready_duration, mqtt_topic_mqtt_queue_size, mqtt_topic_mqtt_queue_high_water_mark,
+        mqtt_topic_mqtt_publishes_dropped, mqtt_topic_nvs_flushes, mqtt_topic_nvs_coalesced_writes,
+        mqtt_topic_nvs_flush_duration, mqtt_topic_nvs_flush_duration_max
+    };
+
+    static const char* const commandResultTopics[] =
+    {
+        mqtt_topic_lock_action_command_result, mqtt_topic_config_action_command_result, mqtt_topic_query_lockstate_command_result,
+        mqtt_topic_keypad_command_result, mqtt_topic_keypad_json_command_result, mqtt_topic_timecontrol_command_result,
+        mqtt_topic_auth_command_result
+    };
+
+    for(const char* telemetryTopic : telemetryTopics)
+    {
+        if(strcmp(topic, telemetryTopic) == 0)
+        {
+            return MqttTopicClass::Telemetry;
+        }
+    }
+
+    for(const char* commandResultTopic : commandResultTopics)
+    {
+        if(strcmp(topic, commandResultTopic) == 0)
+        {
+            return MqttTopicClass::Command;
+        }
+    }
+
+    return MqttTopicClass::State;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+class CachedPreferences;
+
+enum class MqttTopicClass : uint8_t
+{
+    State = 0,      // retained states, configuration and discovery
+    Telemetry = 1,  // frequently published diagnostics, a lost value is replaced by the next one
+    Command = 2     // command topics and the results published for them
+};
+
+// Decides the QoS level of publishes and subscriptions by the class of their topic, the level per class is configurable
+class MqttQosPolicy
+{
+public:
+    void load(CachedPreferences* preferences);
+
+    uint8_t qos(const MqttTopicClass topicClass) const;
+    // topic without prefix, e.g. mqtt_topic_uptime
+    uint8_t qos(const char* topic) const;
+
+    static MqttTopicClass classify(const char* topic);
+
+private:
+    uint8_t _qos[3] = { 1, 0, 1 };
+};
@@ -0,0 +1,102 @@
+#include "MqttTopicRegistry.h"
+#include "MqttPublishCache.h"
+#include <cstdlib>
+#include <cstring>
+
+uint16_t MqttTopicRegistry::intern(const char* prefix, const char* topic, bool (*isCacheable)(const char* topic), bool (*isLastValue)(const char* topic), MqttTopicClass (*classify)(const char* topic))
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return internLocked(prefix, topic, isCacheable, isLastValue, classify);
+}
+
+bool MqttTopicRegistry::lookup(const char* prefix, const char* topic, bool (*isCacheable)(const char* topic), bool (*isLastValue)(const char* topic), MqttTopicClass (*classify)(const char* topic), Topic& result)
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    uint16_t id = internLocked(prefix, topic, isCacheable, isLastValue, classify);
+    if(id == MQTT_TOPIC_ID_INVALID)
+    {
+        return false;
+    }
+
+    result = _entries[id].topic;
+    return true;
+}
+
+bool MqttTopicRegistry::get(const uint16_t id, Topic& result)
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+
+    if(id >= _entries.size())
+    {
+        return false;
+    }
+
+    result = _entries[id].topic;
+    return true;
+}
+
+uint16_t MqttTopicRegistry::internLocked(const char* prefix, const char* topic, bool (*isCacheable)(const char* topic), bool (*isLastValue)(const char* topic), MqttTopicClass (*classify)(const char* topic))
+{
+    uint32_t h = hash(prefix, topic);
+
+    auto range = _index.equal_range(h);
+    for(auto it = range.first; it != range.second; ++it)
+    {
+        const Entry& entry = _entries[it->second];
+        if(strncmp(entry.topic.path, prefix, entry.prefixLength) == 0 &&
+                prefix[entry.prefixLength] == 0 &&
+                strcmp(entry.topic.path + entry.topicOffset, topic) == 0)
+        {
+            return it->second;
+        }
+    }
+
+    if(_entries.size() >= MQTT_TOPIC_ID_INVALID)
+    {
+        return MQTT_TOPIC_ID_INVALID;
+    }
+
+    // Same layout as NukiNetwork::buildMqttPath(), a separator is added if the topic doesn't start with one
+    size_t prefixLength = strlen(prefix);
+    size_t topicOffset = topic[0] == '/' ? prefixLength : prefixLength + 1;
+    size_t topicLength = strlen(topic);
+    char* path = (char*)malloc(topicOffset + topicLength + 1);
+    if(path == nullptr)
+    {
+        return MQTT_TOPIC_ID_INVALID;
+    }
+    memcpy(path, prefix, prefixLength);
+    path[prefixLength] = '/';
+    memcpy(path + topicOffset, topic, topicLength + 1);
+
+    uint16_t id = _entries.size();
+    _entries.push_back({ { path, MqttPublishCache::pathHash(path), isCacheable(topic), isLastValue(topic), classify(topic) }, prefixLength, topicOffset });
+    _index.emplace(h, id);
+    return id;
+}
+
+size_t MqttTopicRegistry::size()
+{
+    const std::lock_guard<std::mutex> lock(_mutex);
+    return _entries.size();
+}
+
+uint32_t MqttTopicRegistry::hash(const char* prefix, const char* topic)
+{
+    // FNV-1a over prefix and topic, equal to the hash of the concatenated path
+    uint32_t h = 2166136261u;
+
+    for(const char* c = prefix; *c != 0; c++)
+    {
+        h ^= (uint8_t)*c;
+        h *= 16777619u;
+    }
+    for(const char* c = topic; *c != 0; c++)
+    {
+        h ^= (uint8_t)*c;
+        h *= 16777619u;
+    }
+
+    return h;
+}
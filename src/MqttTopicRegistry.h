@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "MqttQosPolicy.h"
+
+#define MQTT_TOPIC_ID_INVALID 0xffff
+
+// Interns "prefix + topic" paths once and hands out small ids, so publishing doesn't need to rebuild the full path every time
+class MqttTopicRegistry
+{
+public:
+    struct Topic
+    {
+        const char* path;
+        // MqttPublishCache key of path, so the cache doesn't have to hash the path again
+        uint32_t pathHash;
+        bool cacheable;
+        // Published in PublishMode::LAST_VALUE, an unsent queued value may be replaced by a newer one
+        bool lastValue;
+        MqttTopicClass topicClass;
+    };
+
+    // isCacheable, isLastValue and classify are only evaluated when the topic is interned for the first time
+    uint16_t intern(const char* prefix, const char* topic, bool (*isCacheable)(const char* topic), bool (*isLastValue)(const char* topic), MqttTopicClass (*classify)(const char* topic));
+    // intern() and get() with a single lookup, for publishers that don't keep the id
+    bool lookup(const char* prefix, const char* topic, bool (*isCacheable)(const char* topic), bool (*isLastValue)(const char* topic), MqttTopicClass (*classify)(const char* topic), Topic& result);
+    bool get(const uint16_t id, Topic& result);
+    size_t size();
+
+private:
+    struct Entry
+    {
+        Topic topic;
+        size_t prefixLength;
+        size_t topicOffset;
+    };
+
+    uint16_t internLocked(const char* prefix, const char* topic, bool (*isCacheable)(const char* topic), bool (*isLastValue)(const char* topic), MqttTopicClass (*classify)(const char* topic));
+    static uint32_t hash(const char* prefix, const char* topic);
+
+    std::vector<Entry> _entries;
+    std::unordered_multimap<uint32_t, uint16_t> _index;
+    std::mutex _mutex;
+};
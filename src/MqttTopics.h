@@ -104,10 +104,24 @@
 #define mqtt_topic_update (char*)(char*)"/maintenance/update"
 #define mqtt_topic_webserver_state (char*)"/maintenance/webserver/state"
 #define mqtt_topic_webserver_action (char*)"/maintenance/webserver/enable"
+#define mqtt_topic_hass_refresh (char*)"/maintenance/hassRefresh"
 #define mqtt_topic_uptime (char*)"/maintenance/uptime"
 #define mqtt_topic_wifi_rssi (char*)"/maintenance/wifiRssi"
 #define mqtt_topic_log (char*)"/maintenance/log"
 #define mqtt_topic_freeheap (char*)"/maintenance/freeHeap"
+#define mqtt_topic_publish_cache_hits (char*)"/maintenance/publishCacheHits"
+#define mqtt_topic_publish_cache_misses (char*)"/maintenance/publishCacheMisses"
+#define mqtt_topic_mqtt_messages_handled (char*)"/maintenance/mqttMessagesHandled"
+#define mqtt_topic_mqtt_messages_unhandled (char*)"/maintenance/mqttMessagesUnhandled"
+#define mqtt_topic_mqtt_ready_duration (char*)"/maintenance/mqttReadyDuration"
+#define mqtt_topic_mqtt_queue_size (char*)"/maintenance/mqttQueueSize"
+#define mqtt_topic_mqtt_queue_high_water_mark (char*)"/maintenance/mqttQueueHighWaterMark"
+#define mqtt_topic_mqtt_publishes_dropped (char*)"/maintenance/mqttPublishesDropped"
+#define mqtt_topic_nuki_commands_dropped (char*)"/maintenance/nukiCommandsDropped"
+#define mqtt_topic_nvs_flushes (char*)"/maintenance/nvsFlushes"
+#define mqtt_topic_nvs_coalesced_writes (char*)"/maintenance/nvsCoalescedWrites"
+#define mqtt_topic_nvs_flush_duration (char*)"/maintenance/nvsFlushDuration"
+#define mqtt_topic_nvs_flush_duration_max (char*)"/maintenance/nvsFlushDurationMax"
 #define mqtt_topic_restart_reason_fw (char*)"/maintenance/restartReasonNukiHub"
 #define mqtt_topic_restart_reason_esp (char*)"/maintenance/restartReasonNukiEsp"
 #define mqtt_topic_mqtt_connection_state (char*)"/maintenance/mqttConnectionState"
@@ -139,7 +153,7 @@ private:
         mqtt_topic_timecontrol_json, mqtt_topic_timecontrol_action, mqtt_topic_timecontrol_command_result, mqtt_topic_auth, mqtt_topic_auth_entries, 
         mqtt_topic_auth_json, mqtt_topic_auth_action, mqtt_topic_auth_command_result, mqtt_topic_info_hardware_version, mqtt_topic_info_firmware_version, 
         mqtt_topic_info_nuki_hub_version, mqtt_topic_info_nuki_hub_build, mqtt_topic_info_nuki_hub_latest, mqtt_topic_info_nuki_hub_ip, mqtt_topic_reset, 
-        mqtt_topic_update, mqtt_topic_webserver_state, mqtt_topic_webserver_action, mqtt_topic_uptime, mqtt_topic_wifi_rssi, mqtt_topic_log, mqtt_topic_freeheap, 
+        mqtt_topic_update, mqtt_topic_webserver_state, mqtt_topic_webserver_action, mqtt_topic_hass_refresh, mqtt_topic_uptime, mqtt_topic_wifi_rssi, mqtt_topic_log, mqtt_topic_freeheap, mqtt_topic_publish_cache_hits, mqtt_topic_publish_cache_misses, mqtt_topic_mqtt_messages_handled, mqtt_topic_mqtt_messages_unhandled, mqtt_topic_mqtt_ready_duration, mqtt_topic_mqtt_queue_size, mqtt_topic_mqtt_queue_high_water_mark, mqtt_topic_mqtt_publishes_dropped, mqtt_topic_nuki_commands_dropped, mqtt_topic_nvs_flushes, mqtt_topic_nvs_coalesced_writes, mqtt_topic_nvs_flush_duration, mqtt_topic_nvs_flush_duration_max, 
         mqtt_topic_restart_reason_fw, mqtt_topic_restart_reason_esp, mqtt_topic_mqtt_connection_state, mqtt_topic_network_device, mqtt_topic_hybrid_state
     };
 public:
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstring>
+#include <ArduinoJson.h>
+
+// Collects the results of a JSON array of keypad / time control / authorization commands.
+// While a batch is active the per-entry results are recorded instead of published, and entry lists retrieved from the device
+// are reused until the next entry changes them. Only used on the nuki task.
+class NukiCommandBatch
+{
+public:
+    void begin()
+    {
+        _results.clear();
+        _results.to<JsonArray>();
+        _active = true;
+        _entriesRetrieved = false;
+        _index = 0;
+        _succeeded = 0;
+        _failed = 0;
+    }
+
+    bool active() const
+    {
+        return _active;
+    }
+
+    void beginEntry(const char* action)
+    {
+        _action = action != nullptr ? action : "";
+    }
+
+    void endEntry()
+    {
+        ++_index;
+    }
+
+    void addResult(const char* result)
+    {
+        JsonObject entry = _results.add<JsonObject>();
+        entry["index"] = _index;
+        entry["action"] = _action;
+        entry["result"] = result;
+
+        if(strcmp(result, "success") == 0)
+        {
+            ++_succeeded;
+        }
+        else
+        {
+            ++_failed;
+        }
+    }
+
+    // Whether the entry list was already retrieved from the device during this batch
+    bool entriesRetrieved() const
+    {
+        return _active && _entriesRetrieved;
+    }
+
+    void setEntriesRetrieved()
+    {
+        _entriesRetrieved = _active;
+    }
+
+    // Called after a command was sent to the device, the retrieved list may no longer match it
+    void invalidateEntries()
+    {
+        _entriesRetrieved = false;
+    }
+
+    // Ends the batch and serializes the aggregated result. If the full list doesn't fit into the buffer, only failed entries are listed.
+    void end(char* buffer, const size_t size)
+    {
+        _active = false;
+
+        JsonDocument json;
+        json["total"] = _index;
+        json["succeeded"] = _succeeded;
+        json["failed"] = _failed;
+        json["results"] = _results.as<JsonArray>();
+
+        if(measureJson(json) >= size)
+        {
+            JsonArray failed = json["results"].to<JsonArray>();
+            for(JsonObject entry : _results.as<JsonArray>())
+            {
+                if(strcmp(entry["result"] | "", "success") != 0)
+                {
+                    failed.add(entry);
+                }
+            }
+        }
+
+        serializeJson(json, buffer, size);
+        _results.clear();
+    }
+
+private:
+    JsonDocument _results;
+    const char* _action = "";
+    bool _active = false;
+    bool _entriesRetrieved = false;
+    uint32_t _index = 0;
+    uint32_t _succeeded = 0;
+    uint32_t _failed = 0;
+};
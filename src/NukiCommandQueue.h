@@ -0,0 +1,150 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "EspMillis.h"
+
+#define NUKI_COMMAND_QUEUE_SIZE 16
+
+enum class NukiCommandType : uint8_t
+{
+    LockAction,
+    ConfigUpdate,
+    Keypad,
+    KeypadJson,
+    TimeControl,
+    Auth
+};
+
+struct NukiCommand
+{
+    NukiCommandType type;
+    uint8_t lockAction;
+    int64_t enqueuedTs;
+    char* payload; // heap copy owned by the queue entry, released by the consumer via freePayload()
+
+    void freePayload()
+    {
+        free(payload);
+        payload = nullptr;
+    }
+};
+
+// Bounded lock-free multi-producer / single-consumer queue (sequence numbered slots).
+// Producers are the network task, the httpd task and the GPIO timer ISR, the only consumer is the nuki task.
+class NukiCommandQueue
+{
+public:
+    NukiCommandQueue()
+    {
+        for(size_t i = 0; i < NUKI_COMMAND_QUEUE_SIZE; i++)
+        {
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool pushLockAction(const uint8_t lockAction)
+    {
+        NukiCommand command = { NukiCommandType::LockAction, lockAction, espMillis(), nullptr };
+        return push(command);
+    }
+
+    // Copies value, must not be called from an ISR
+    bool pushPayload(const NukiCommandType type, const char* value)
+    {
+        if(value == nullptr)
+        {
+            return false;
+        }
+
+        size_t len = strlen(value);
+        char* payload = (char*)malloc(len + 1);
+        if(payload == nullptr)
+        {
+            return false;
+        }
+        memcpy(payload, value, len + 1);
+
+        NukiCommand command = { type, 0xff, espMillis(), payload };
+        if(!push(command))
+        {
+            free(payload);
+            return false;
+        }
+        return true;
+    }
+
+    bool pop(NukiCommand& command)
+    {
+        Slot& slot = _slots[_tail & (NUKI_COMMAND_QUEUE_SIZE - 1)];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+
+        if((intptr_t)seq - (intptr_t)(_tail + 1) < 0)
+        {
+            return false;
+        }
+
+        command = slot.command;
+        slot.sequence.store(_tail + NUKI_COMMAND_QUEUE_SIZE, std::memory_order_release);
+        ++_tail;
+        return true;
+    }
+
+    bool empty() const
+    {
+        const Slot& slot = _slots[_tail & (NUKI_COMMAND_QUEUE_SIZE - 1)];
+        return (intptr_t)slot.sequence.load(std::memory_order_acquire) - (intptr_t)(_tail + 1) < 0;
+    }
+
+    uint32_t droppedCount() const
+    {
+        return _dropped.load(std::memory_order_relaxed);
+    }
+
+private:
+    static_assert((NUKI_COMMAND_QUEUE_SIZE & (NUKI_COMMAND_QUEUE_SIZE - 1)) == 0, "NUKI_COMMAND_QUEUE_SIZE must be a power of two");
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        NukiCommand command;
+    };
+
+    bool push(const NukiCommand& command)
+    {
+        size_t pos = _head.load(std::memory_order_relaxed);
+
+        while(true)
+        {
+            Slot& slot = _slots[pos & (NUKI_COMMAND_QUEUE_SIZE - 1)];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+            if(diff == 0)
+            {
+                if(_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.command = command;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0)
+            {
+                _dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    Slot _slots[NUKI_COMMAND_QUEUE_SIZE];
+    std::atomic<size_t> _head{0};
+    size_t _tail = 0;
+    std::atomic<uint32_t> _dropped{0};
+};
@@ -4,7 +4,7 @@
 #include "NukiDeviceId.h"
 #include "PreferencesKeys.h"
 
-NukiDeviceId::NukiDeviceId(Preferences* preferences, const std::string& preferencesId)
+NukiDeviceId::NukiDeviceId(CachedPreferences* preferences, const std::string& preferencesId)
     : _preferences(preferences),
       _preferencesId(preferencesId)
 {
@@ -1,12 +1,12 @@
 #pragma once
 
 #include <cstdint>
-#include <Preferences.h>
+#include "CachedPreferences.h"
 
 class NukiDeviceId
 {
 public:
-    NukiDeviceId(Preferences* preferences, const std::string& preferencesId);
+    NukiDeviceId(CachedPreferences* preferences, const std::string& preferencesId);
 
     uint32_t get();
 
@@ -16,7 +16,7 @@ public:
 private:
     uint32_t getRandomId();
 
-    Preferences* _preferences;
+    CachedPreferences* _preferences;
     const std::string _preferencesId;
     uint32_t _deviceId = 0;
 };
\ No newline at end of file
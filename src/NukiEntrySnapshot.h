@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+
+// Snapshot of the keypad codes / time control entries / authorizations published last, keyed by their id with a hash of the entry content.
+// Per-entry topics are indexed by list position, so an entry also counts as changed when it moved to another index.
+class NukiEntrySnapshot
+{
+public:
+    // Starts comparing a new list. The signature covers everything else that affects the published topics (publish settings, MQTT connection),
+    // when it differs from the previous one the snapshot is discarded and all entries are published again.
+    void begin(const uint32_t signature)
+    {
+        if(signature != _signature)
+        {
+            _signature = signature;
+            _valid = false;
+        }
+
+        _current.clear();
+        _changedCount = 0;
+    }
+
+    void add(const uint32_t id, const uint32_t index, const void* entry, const size_t size)
+    {
+        Item item = { hash(entry, size), index };
+        _current[id] = item;
+
+        if(changed(id))
+        {
+            ++_changedCount;
+        }
+    }
+
+    // Whether the entry with id was added, changed or moved since the last list
+    bool changed(const uint32_t id) const
+    {
+        if(!_valid)
+        {
+            return true;
+        }
+
+        auto current = _current.find(id);
+        auto previous = _entries.find(id);
+
+        return current == _current.end() || previous == _entries.end() ||
+               current->second.hash != previous->second.hash || current->second.index != previous->second.index;
+    }
+
+    // Whether anything was added, changed or removed since the last list
+    bool changed() const
+    {
+        return !_valid || _changedCount > 0 || _current.size() != _entries.size();
+    }
+
+    bool valid() const
+    {
+        return _valid;
+    }
+
+    // Number of entries in the last list, fallback if there is no valid snapshot yet
+    size_t previousCount(const size_t fallback) const
+    {
+        return _valid ? _entries.size() : fallback;
+    }
+
+    // Makes the current list the snapshot to compare the next one against
+    void end()
+    {
+        _entries.swap(_current);
+        _current.clear();
+        _valid = true;
+    }
+
+private:
+    struct Item
+    {
+        uint32_t hash;
+        uint32_t index;
+    };
+
+    static uint32_t hash(const void* data, const size_t size)
+    {
+        // FNV-1a
+        uint32_t h = 2166136261u;
+        const uint8_t* bytes = (const uint8_t*)data;
+
+        for(size_t i = 0; i < size; i++)
+        {
+            h ^= bytes[i];
+            h *= 16777619u;
+        }
+
+        return h;
+    }
+
+    std::map<uint32_t, Item> _entries;
+    std::map<uint32_t, Item> _current;
+    uint32_t _signature = 0;
+    uint32_t _changedCount = 0;
+    bool _valid = false;
+};
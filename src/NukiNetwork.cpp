@@ -11,6 +11,11 @@
 #endif
 #include "networkDevices/EthernetDevice.h"
 #include "hal/wdt_hal.h"
+#ifndef NUKI_HUB_UPDATER
+#include "NukiTaskWakeup.h"
+#include "esp_random.h"
+#include <algorithm>
+#endif
 
 NukiNetwork* NukiNetwork::_inst = nullptr;
 
@@ -21,13 +26,12 @@ extern const uint8_t x509_crt_imported_bundle_bin_start[] asm("_binary_x509_crt_
 extern const uint8_t x509_crt_imported_bundle_bin_end[]   asm("_binary_x509_crt_bundle_end");
 
 #ifndef NUKI_HUB_UPDATER
-NukiNetwork::NukiNetwork(Preferences *preferences, Gpio* gpio, const String& maintenancePathPrefix, char* buffer, size_t bufferSize)
+NukiNetwork::NukiNetwork(CachedPreferences *preferences, Gpio* gpio, const String& maintenancePathPrefix)
     : _preferences(preferences),
       _gpio(gpio),
-      _buffer(buffer),
-      _bufferSize(bufferSize)
+      _publishCache(MQTT_PUBLISH_CACHE_REFRESH_INTERVAL)
 #else
-NukiNetwork::NukiNetwork(Preferences *preferences)
+NukiNetwork::NukiNetwork(CachedPreferences *preferences)
     : _preferences(preferences)
 #endif
 {
@@ -42,6 +46,10 @@ NukiNetwork::NukiNetwork(Preferences *preferences)
         _maintenancePathPrefix[i] = maintenancePathPrefix.charAt(i);
     }
 
+    _rssiTopicId = topicId(_maintenancePathPrefix, mqtt_topic_wifi_rssi);
+    _uptimeTopicId = topicId(_maintenancePathPrefix, mqtt_topic_uptime);
+    _freeHeapTopicId = topicId(_maintenancePathPrefix, mqtt_topic_freeheap);
+
     _lockPath = _preferences->getString(preference_mqtt_lock_path);
     String connectionStateTopic = _lockPath + mqtt_topic_mqtt_connection_state;
 
@@ -137,7 +145,7 @@ void NukiNetwork::setupDevice()
         onMqttDisconnect(reason);
     });
 
-    _hadiscovery = new HomeAssistantDiscovery(_device, _preferences, _buffer, _bufferSize);
+    _hadiscovery = new HomeAssistantDiscovery(_device, _preferences);
 #endif
 
 }
@@ -307,7 +315,11 @@ void NukiNetwork::initialize()
 
         _device->mqttSetClientId(_hostnameArr);
         _device->mqttSetCleanSession(false);
+        // MQTT 5 lets the client replace the long topics of frequent publishes by topic aliases
+        _mqttV5 = _preferences->getBool(preference_mqtt_v5, false);
+        _device->mqttSetProtocolVersion(_mqttV5 ? espMqttClientTypes::ProtocolVersion::V5 : espMqttClientTypes::ProtocolVersion::V3_1_1);
         _device->mqttSetKeepAlive(60);
+        _device->mqttSetQueueCapacity(_preferences->getInt(preference_mqtt_outbox_capacity, MQTT_OUTBOX_CAPACITY));
 
         char gpioPath[250];
         bool rebGpio = rebuildGpio();
@@ -339,7 +351,13 @@ void NukiNetwork::initialize()
                     publishString(_lockPath.c_str(), gpioPath, "0", false);
                 }
                 buildMqttPath(gpioPath, {mqtt_topic_gpio_prefix, (mqtt_topic_gpio_pin + std::to_string(pinEntry.pin)).c_str(), mqtt_topic_gpio_state});
-                subscribe(_lockPath.c_str(), gpioPath);
+                {
+                    const int pin = pinEntry.pin;
+                    subscribe(_lockPath.c_str(), gpioPath, [this, pin](const char* topic, const char* data, const unsigned int length)
+                    {
+                        onGpioReceived(pin, data);
+                    });
+                }
                 break;
             default:
                 break;
@@ -347,9 +365,37 @@ void NukiNetwork::initialize()
         }
 
         readSettings();
+
+        _preferences->addChangeListener([this](const char* key)
+        {
+            if(isSettingsKey(key))
+            {
+                _settingsChanged = true;
+            }
+        });
     }
 }
 
+bool NukiNetwork::isSettingsKey(const char* key)
+{
+    // Keys read by readSettings(), other writes (runtime state, HA discovery hashes) don't need a reload
+    static const char* const settingsKeys[] =
+    {
+        preference_disable_network_not_connected, preference_restart_on_disconnect, preference_check_updates,
+        preference_rssi_publish_interval, preference_retain_gpio, preference_mqtt_wildcard_subscriptions, preference_mqtt_qos_state,
+        preference_mqtt_qos_telemetry, preference_mqtt_qos_command, preference_network_timeout, preference_publish_debug_info
+    };
+
+    for(const char* settingsKey : settingsKeys)
+    {
+        if(strcmp(key, settingsKey) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 void NukiNetwork::readSettings()
 {
     _disableNetworkIfNotConnected = _preferences->getBool(preference_disable_network_not_connected, false);
@@ -357,6 +403,8 @@ void NukiNetwork::readSettings()
     _checkUpdates = _preferences->getBool(preference_check_updates, false);
     _rssiPublishInterval = _preferences->getInt(preference_rssi_publish_interval, 0) * 1000;
     _retainGpio = _preferences->getBool(preference_retain_gpio, false);
+    _wildcardSubscriptions = _preferences->getBool(preference_mqtt_wildcard_subscriptions, false);
+    _qosPolicy.load(_preferences);
 
     if(_rssiPublishInterval == 0)
     {
@@ -380,6 +428,12 @@ bool NukiNetwork::update()
     wdt_hal_write_protect_disable(&rtc_wdt_ctx);
     wdt_hal_feed(&rtc_wdt_ctx);
     wdt_hal_write_protect_enable(&rtc_wdt_ctx);
+
+    if(_settingsChanged.exchange(false))
+    {
+        readSettings();
+    }
+
     int64_t ts = espMillis();
     _device->update();
 
@@ -417,29 +471,7 @@ bool NukiNetwork::update()
         _firstDisconnected = true;
     }
 
-    if(!_device->mqttConnected() && _device->isConnected())
-    {
-        bool success = reconnect();
-        if(!success)
-        {
-            delay(2000);
-            _mqttConnectCounter++;
-            return false;
-        }
-
-        _mqttConnectCounter = 0;
-        if(forceEnableWebServer && !_webEnabled)
-        {
-            forceEnableWebServer = false;
-            delay(200);
-            restartEsp(RestartReason::ReconfigureWebServer);
-        }
-        else if(!_webEnabled)
-        {
-            forceEnableWebServer = false;
-        }
-        delay(2000);
-    }
+    updateMqttConnection();
 
     if(!_device->mqttConnected() || !_device->isConnected())
     {
@@ -453,12 +485,17 @@ bool NukiNetwork::update()
             delay(200);
             restartEsp(RestartReason::NetworkTimeoutWatchdog);
         }
-        delay(2000);
         return false;
     }
 
     _lastConnectedTs = ts;
 
+    // Discovery starts after the session is restored and is spread over several loops
+    if(_mqttConnectPhase == MqttConnectPhase::Connected)
+    {
+        _hadiscovery->update();
+    }
+
     if(_device->signalStrength() != 127 && _rssiPublishInterval > 0 && ts - _lastRssiTs > _rssiPublishInterval)
     {
         _lastRssiTs = ts;
@@ -466,8 +503,9 @@ bool NukiNetwork::update()
 
         if(rssi != _lastRssi)
         {
-            publishInt(_maintenancePathPrefix, mqtt_topic_wifi_rssi, _device->signalStrength(), true);
+            publishInt(_rssiTopicId, rssi, true);
             _lastRssi = rssi;
+            notifyStatusChanged();
         }
     }
 
@@ -476,7 +514,7 @@ bool NukiNetwork::update()
         int64_t curUptime = ts / 1000 / 60;
         if(curUptime > _publishedUpTime)
         {
-            publishULong(_maintenancePathPrefix, mqtt_topic_uptime, curUptime, true);
+            publishULong(_uptimeTopicId, curUptime, true);
             _publishedUpTime = curUptime;
         }
         //publishString(_maintenancePathPrefix, mqtt_topic_mqtt_connection_state, "online", true);
@@ -490,9 +528,24 @@ bool NukiNetwork::update()
         }
         if(_publishDebugInfo)
         {
-            publishUInt(_maintenancePathPrefix, mqtt_topic_freeheap, esp_get_free_heap_size(), true);
+            publishUInt(_freeHeapTopicId, esp_get_free_heap_size(), true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_publish_cache_hits, _publishCache.hits(), true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_publish_cache_misses, _publishCache.misses(), true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_mqtt_messages_handled, _dispatcher.handledCount(), true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_mqtt_messages_unhandled, _dispatcher.unhandledCount(), true);
+            publishULong(_maintenancePathPrefix, mqtt_topic_mqtt_ready_duration, _mqttReadyDuration, true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_mqtt_queue_size, _device->mqttQueueSize(), true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_mqtt_queue_high_water_mark, _device->mqttQueueHighWaterMark(), true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_mqtt_publishes_dropped, _mqttPublishesDropped, true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_nuki_commands_dropped, nukiCommandsDropped(), true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_nvs_flushes, _preferences->flushCount(), true);
+            publishUInt(_maintenancePathPrefix, mqtt_topic_nvs_coalesced_writes, _preferences->coalescedWrites(), true);
+            publishULong(_maintenancePathPrefix, mqtt_topic_nvs_flush_duration, _preferences->lastFlushDuration(), true);
+            publishULong(_maintenancePathPrefix, mqtt_topic_nvs_flush_duration_max, _preferences->maxFlushDuration(), true);
         }
         _lastMaintenanceTs = ts;
+        // Free heap on the status page
+        notifyStatusChanged();
     }
 
     if(_checkUpdates)
@@ -593,6 +646,7 @@ void NukiNetwork::onMqttConnect(const bool &sessionPresent)
 void NukiNetwork::onMqttDisconnect(const espMqttClientTypes::DisconnectReason &reason)
 {
     _connectReplyReceived = false;
+    _connectFailed = true;
     Log->print("MQTT disconnected. Reason: ");
     switch(reason)
     {
@@ -620,185 +674,360 @@ void NukiNetwork::onMqttDisconnect(const espMqttClientTypes::DisconnectReason &r
     case espMqttClientTypes::DisconnectReason::TCP_DISCONNECTED:
         Log->println(("TCP_DISCONNECTED"));
         break;
+    case espMqttClientTypes::DisconnectReason::MQTT_SERVER_DISCONNECT:
+        Log->println(("MQTT_SERVER_DISCONNECT"));
+        break;
     default:
         Log->println(("Unknown"));
         break;
     }
 }
 
-bool NukiNetwork::reconnect()
+void NukiNetwork::updateMqttConnection()
 {
-    _mqttConnectionState = 0;
-
-    while (!_device->mqttConnected() && espMillis() > _nextReconnect)
+    switch(_mqttConnectPhase)
     {
-        if(strcmp(_mqttBrokerAddr, "") == 0)
+    case MqttConnectPhase::Idle:
+        if(_device->isConnected() && !_device->mqttConnected() && espMillis() > _nextReconnect)
+        {
+            startMqttConnect();
+        }
+        break;
+    case MqttConnectPhase::Connecting:
+        if(_connectReplyReceived && _device->mqttConnected())
+        {
+            onMqttConnected();
+        }
+        else if(_connectFailed || espMillis() > _mqttConnectTimeoutTs)
         {
-            Log->println(("MQTT Broker not configured, aborting connection attempt."));
-            _nextReconnect = espMillis() + 5000;
-            
-            if(_device->isConnected())
+            Log->println(("MQTT connect failed"));
+            if(!_connectFailed)
             {
-                _lastConnectedTs = espMillis();
+                _device->mqttDisconnect(true);
             }
-            return false;
+            _mqttConnectCounter++;
+            scheduleReconnect();
         }
+        break;
+    case MqttConnectPhase::Replaying:
+        if(!_device->mqttConnected())
+        {
+            scheduleReconnect();
+        }
+        else if(replayMqttSession())
+        {
+            publishString(_maintenancePathPrefix, mqtt_topic_mqtt_connection_state, "online", true);
+            publishString(_maintenancePathPrefix, mqtt_topic_info_nuki_hub_ip, _device->localIP().c_str(), true);
 
-        Log->println(("Attempting MQTT connection"));
-
-        _connectReplyReceived = false;
+            _mqttReadyDuration = espMillis() - _mqttReplayStartTs;
+            Log->printf("MQTT ready %lld ms after connecting, %lld ms after CONNACK\n", (long long)(espMillis() - _mqttConnectStartTs), (long long)_mqttReadyDuration);
 
-        if(strlen(_mqttUser) == 0)
-        {
-            Log->println(("MQTT: Connecting without credentials"));
+            _mqttReconnectAttempts = 0;
+            _mqttConnectPhase = MqttConnectPhase::Connected;
+            setMqttConnectionState(2);
+            for(const auto& callback : _reconnectedCallbacks)
+            {
+                callback();
+            }
         }
-        else
+        break;
+    case MqttConnectPhase::Connected:
+        if(!_device->mqttConnected())
         {
-            Log->print(("MQTT: Connecting with user: "));
-            Log->println(_mqttUser);
-            _device->mqttSetCredentials(_mqttUser, _mqttPass);
+            scheduleReconnect();
         }
+        break;
+    }
+}
+
+void NukiNetwork::startMqttConnect()
+{
+    if(strcmp(_mqttBrokerAddr, "") == 0)
+    {
+        Log->println(("MQTT Broker not configured, aborting connection attempt."));
+        _nextReconnect = espMillis() + 5000;
+        _lastConnectedTs = espMillis();
+        return;
+    }
+
+    Log->println(("Attempting MQTT connection"));
+
+    _connectReplyReceived = false;
+    _connectFailed = false;
+
+    if(strlen(_mqttUser) == 0)
+    {
+        Log->println(("MQTT: Connecting without credentials"));
+    }
+    else
+    {
+        Log->print(("MQTT: Connecting with user: "));
+        Log->println(_mqttUser);
+        _device->mqttSetCredentials(_mqttUser, _mqttPass);
+    }
 
-        _device->mqttSetWill(_mqttConnectionStateTopic, 1, true, _lastWillPayload);
-        _device->mqttSetServer(_mqttBrokerAddr, _mqttPort);
-        _device->mqttConnect();
+    _device->mqttSetWill(_mqttConnectionStateTopic, 1, true, _lastWillPayload);
+    _device->mqttSetServer(_mqttBrokerAddr, _mqttPort);
 
-        int64_t timeout = espMillis() + 60000;
+    if(!_device->mqttConnect())
+    {
+        Log->println(("MQTT connect failed"));
+        _mqttConnectCounter++;
+        scheduleReconnect();
+        return;
+    }
+
+    _mqttConnectStartTs = espMillis();
+    _mqttConnectTimeoutTs = _mqttConnectStartTs + MQTT_CONNECT_TIMEOUT;
+    _mqttConnectPhase = MqttConnectPhase::Connecting;
+}
+
+void NukiNetwork::onMqttConnected()
+{
+    Log->println(("MQTT connected"));
+    _publishCache.clear();
+    _mqttConnectedTs = millis();
+    _mqttReplayStartTs = espMillis();
+    setMqttConnectionState(1);
+    _mqttConnectCounter = 0;
+    _device->mqttOnMessage(onMqttDataReceivedCallback);
+
+    // Subscriptions are renewed after every connect
+    _replaySubscribedTopic = 0;
+
+    if(_firstConnect)
+    {
+        _firstConnect = false;
 
-        while(!_connectReplyReceived && espMillis() < timeout)
+        if(_preferences->getBool(preference_reset_mqtt_topics, false))
         {
-            delay(50);
-            _device->update();
-            if(_keepAliveCallback != nullptr)
+            char mqttLockPath[181] = {0};
+            char mqttOpenerPath[181] = {0};
+            char mqttOldOpenerPath[181] = {0};
+            char mqttOldOpenerPath2[181] = {0};
+            String mqttPath = _preferences->getString(preference_mqtt_lock_path, "");
+            mqttPath.concat("/lock");
+
+            size_t len = mqttPath.length();
+            for(int i=0; i < len; i++)
             {
-                _keepAliveCallback();
+                mqttLockPath[i] = mqttPath.charAt(i);
             }
-        }
 
-        if (_device->mqttConnected())
-        {
-            Log->println(("MQTT connected"));
-            _mqttConnectedTs = millis();
-            _mqttConnectionState = 1;
-            delay(100);
-            _device->mqttOnMessage(onMqttDataReceivedCallback);
+            mqttPath = _preferences->getString(preference_mqtt_lock_path, "");
+            mqttPath.concat("/opener");
 
-            if(_firstConnect)
+            len = mqttPath.length();
+            for(int i=0; i < len; i++)
             {
-                _firstConnect = false;
+                mqttOpenerPath[i] = mqttPath.charAt(i);
+            }
+
+            mqttPath = _preferences->getString(preference_mqtt_opener_path, "");
 
-                if(_preferences->getBool(preference_reset_mqtt_topics, false))
+            len = mqttPath.length();
+            for(int i=0; i < len; i++)
+            {
+                mqttOldOpenerPath[i] = mqttPath.charAt(i);
+            }
+
+            mqttPath = _preferences->getString(preference_mqtt_opener_path, "");
+            mqttPath.concat("/lock");
+
+            len = mqttPath.length();
+            for(int i=0; i < len; i++)
+            {
+                mqttOldOpenerPath2[i] = mqttPath.charAt(i);
+            }
+
+            MqttTopics mqttTopics;
+
+            const std::vector<char*> mqttTopicsKeys = mqttTopics.getMqttTopics();
+
+            for(const auto& topic : mqttTopicsKeys)
+            {
+                removeTopic(_maintenancePathPrefix, topic);
+                removeTopic(mqttLockPath, topic);
+                removeTopic(mqttOpenerPath, topic);
+                if (len > 5)
                 {
-                    char mqttLockPath[181] = {0};
-                    char mqttOpenerPath[181] = {0};
-                    char mqttOldOpenerPath[181] = {0};
-                    char mqttOldOpenerPath2[181] = {0};
-                    String mqttPath = _preferences->getString(preference_mqtt_lock_path, "");
-                    mqttPath.concat("/lock");
-
-                    size_t len = mqttPath.length();
-                    for(int i=0; i < len; i++)
-                    {
-                        mqttLockPath[i] = mqttPath.charAt(i);
-                    }
+                    removeTopic(mqttOldOpenerPath, topic);
+                    removeTopic(mqttOldOpenerPath2, topic);
+                }
+            }
 
-                    mqttPath = _preferences->getString(preference_mqtt_lock_path, "");
-                    mqttPath.concat("/opener");
+            _preferences->putBool(preference_reset_mqtt_topics, false);
+        }
 
-                    len = mqttPath.length();
-                    for(int i=0; i < len; i++)
-                    {
-                        mqttOpenerPath[i] = mqttPath.charAt(i);
-                    }
+        publishString(_maintenancePathPrefix, mqtt_topic_network_device, _device->deviceName().c_str(), true);
 
-                    mqttPath = _preferences->getString(preference_mqtt_opener_path, "");
+        if(_preferences->getBool(preference_mqtt_hass_enabled, false))
+        {
+            setupHASS(0, 0, {0}, {0}, {0}, false, false);
 
-                    len = mqttPath.length();
-                    for(int i=0; i < len; i++)
-                    {
-                        mqttOldOpenerPath[i] = mqttPath.charAt(i);
-                    }
+            initTopic(_maintenancePathPrefix, mqtt_topic_hass_refresh, "0");
+            subscribe(_maintenancePathPrefix, mqtt_topic_hass_refresh, [this](const char* topic, const char* data, const unsigned int length)
+            {
+                onHassRefreshReceived(data);
+            });
+        }
 
-                    mqttPath = _preferences->getString(preference_mqtt_opener_path, "");
-                    mqttPath.concat("/lock");
+        initTopic(_maintenancePathPrefix, mqtt_topic_reset, "0");
+        subscribe(_maintenancePathPrefix, mqtt_topic_reset, [this](const char* topic, const char* data, const unsigned int length)
+        {
+            onResetReceived(data);
+        });
+        initTopic(_maintenancePathPrefix, mqtt_topic_freeheap, "");
+        initTopic(_maintenancePathPrefix, mqtt_topic_log, "");
+        initTopic(_maintenancePathPrefix, mqtt_topic_wifi_rssi, "");
 
-                    len = mqttPath.length();
-                    for(int i=0; i < len; i++)
-                    {
-                        mqttOldOpenerPath2[i] = mqttPath.charAt(i);
-                    }
+        if(_preferences->getBool(preference_update_from_mqtt, false))
+        {
+            initTopic(_maintenancePathPrefix, mqtt_topic_update, "0");
+            subscribe(_maintenancePathPrefix, mqtt_topic_update, [this](const char* topic, const char* data, const unsigned int length)
+            {
+                onUpdateReceived(data);
+            });
+        }
 
-                    MqttTopics mqttTopics;
+        initTopic(_maintenancePathPrefix, mqtt_topic_webserver_action, "--");
+        subscribe(_maintenancePathPrefix, mqtt_topic_webserver_action, [this](const char* topic, const char* data, const unsigned int length)
+        {
+            onWebserverActionReceived(data);
+        });
+        initTopic(_maintenancePathPrefix, mqtt_topic_webserver_state, (_preferences->getBool(preference_webserver_enabled, true) || forceEnableWebServer ? "1" : "0"));
+    }
 
-                    const std::vector<char*> mqttTopicsKeys = mqttTopics.getMqttTopics();
+    // Init topics are published once after boot. If the session drops before all of them were sent, they are all published again
+    // on the next connect, publishes queued in the dropped session may not have reached the broker.
+    _replayInitTopic = _initTopicsReplayed ? _initTopics.end() : _initTopics.begin();
 
-                    for(const auto& topic : mqttTopicsKeys)
-                    {
-                        removeTopic(_maintenancePathPrefix, topic);
-                        removeTopic(mqttLockPath, topic);
-                        removeTopic(mqttOpenerPath, topic);
-                        if (len > 5)
-                        {
-                            removeTopic(mqttOldOpenerPath, topic);
-                            removeTopic(mqttOldOpenerPath2, topic);
-                        }
-                    }
+    if(_wildcardSubscriptions)
+    {
+        buildSubscriptionFilters();
+    }
 
-                    _preferences->putBool(preference_reset_mqtt_topics, false);
-                }
+    _mqttConnectPhase = MqttConnectPhase::Replaying;
 
-                publishString(_maintenancePathPrefix, mqtt_topic_network_device, _device->deviceName().c_str(), true);
+    if(forceEnableWebServer && !_webEnabled)
+    {
+        forceEnableWebServer = false;
+        delay(200);
+        restartEsp(RestartReason::ReconfigureWebServer);
+    }
+    else if(!_webEnabled)
+    {
+        forceEnableWebServer = false;
+    }
+}
 
-                if(_preferences->getBool(preference_mqtt_hass_enabled, false))
-                {
-                    setupHASS(0, 0, {0}, {0}, {0}, false, false);
-                }
+bool NukiNetwork::replayMqttSession()
+{
+    size_t count = 0;
 
-                initTopic(_maintenancePathPrefix, mqtt_topic_reset, "0");
-                subscribe(_maintenancePathPrefix, mqtt_topic_reset);
-                initTopic(_maintenancePathPrefix, mqtt_topic_freeheap, "");
-                initTopic(_maintenancePathPrefix, mqtt_topic_log, "");
-                initTopic(_maintenancePathPrefix, mqtt_topic_wifi_rssi, "");
+    while(_replayInitTopic != _initTopics.end() && count < MQTT_REPLAY_BATCH_SIZE)
+    {
+        publish(_replayInitTopic->first.c_str(), MqttPublishCache::pathHash(_replayInitTopic->first.c_str()), _replayInitTopic->second.c_str(), true, true, false, _qosPolicy.qos(MqttTopicClass::Command));
+        ++_replayInitTopic;
+        ++count;
+    }
 
-                if(_preferences->getBool(preference_update_from_mqtt, false))
-                {
-                    initTopic(_maintenancePathPrefix, mqtt_topic_update, "0");
-                    subscribe(_maintenancePathPrefix, mqtt_topic_update);
-                }
+    if(_replayInitTopic != _initTopics.end())
+    {
+        return false;
+    }
 
-                initTopic(_maintenancePathPrefix, mqtt_topic_webserver_action, "--");
-                subscribe(_maintenancePathPrefix, mqtt_topic_webserver_action);
-                initTopic(_maintenancePathPrefix, mqtt_topic_webserver_state, (_preferences->getBool(preference_webserver_enabled, true) || forceEnableWebServer ? "1" : "0"));
+    _initTopicsReplayed = true;
 
-                for(const auto& it : _initTopics)
-                {
-                    publish(it.first.c_str(), it.second.c_str(), true);
-                }
-            }
+    const std::vector<String>& topics = _wildcardSubscriptions ? _subscriptionFilters : _subscribedTopics;
 
-            for(const String& topic : _subscribedTopics)
-            {
-                subscribe(topic.c_str(), MQTT_QOS_LEVEL);
-            }
+    if(_replaySubscribedTopic < topics.size())
+    {
+        // One SUBSCRIBE per call with as many topics as fit into a TX buffer and a SUBACK
+        espMqttClientTypes::SubscribeItem items[EMC_PAYLOAD_BUFFER_SIZE];
+        size_t itemCount = 0;
+        // Fixed header, packet id and the property length of MQTT 5
+        size_t packetSize = 5 + 2 + (_mqttV5 ? 1 : 0);
 
-            publishString(_maintenancePathPrefix, mqtt_topic_mqtt_connection_state, "online", true);
-            publishString(_maintenancePathPrefix, mqtt_topic_info_nuki_hub_ip, _device->localIP().c_str(), true);
+        while(_replaySubscribedTopic + itemCount < topics.size() && itemCount < EMC_PAYLOAD_BUFFER_SIZE)
+        {
+            const String& topic = topics[_replaySubscribedTopic + itemCount];
+            size_t topicSize = 2 + topic.length() + 1;
 
-            _mqttConnectionState = 2;
-            for(const auto& callback : _reconnectedCallbacks)
+            if(itemCount > 0 && packetSize + topicSize > EMC_TX_BUFFER_SIZE)
             {
-                callback();
+                break;
             }
+
+            items[itemCount] = { topic.c_str(), _qosPolicy.qos(MqttTopicClass::Command) };
+            packetSize += topicSize;
+            ++itemCount;
         }
-        else
+
+        if(subscribe(items, itemCount) == 0)
         {
-            Log->print(("MQTT connect failed"));
-            _mqttConnectionState = 0;
-            _nextReconnect = espMillis() + 5000;
-            //_device->mqttDisconnect(true);
+            return false;
         }
+
+        _replaySubscribedTopic += itemCount;
+    }
+
+    return _replaySubscribedTopic >= topics.size();
+}
+
+void NukiNetwork::buildSubscriptionFilters()
+{
+    // Topics that share their parent level with other subscribed topics are collapsed into one <parent>/+ filter
+    std::map<String, size_t> parentCounts;
+
+    for(const String& topic : _subscribedTopics)
+    {
+        ++parentCounts[topic.substring(0, topic.lastIndexOf('/'))];
+    }
+
+    _subscriptionFilters.clear();
+
+    for(const String& topic : _subscribedTopics)
+    {
+        String parent = topic.substring(0, topic.lastIndexOf('/'));
+        size_t& count = parentCounts[parent];
+
+        if(count < MQTT_WILDCARD_MIN_TOPICS)
+        {
+            _subscriptionFilters.push_back(topic);
+        }
+        else if(count != SIZE_MAX)
+        {
+            _subscriptionFilters.push_back(parent + "/+");
+            count = SIZE_MAX;
+        }
+    }
+
+    Log->printf("MQTT wildcard subscriptions: %u filters for %u topics\n", (unsigned int)_subscriptionFilters.size(), (unsigned int)_subscribedTopics.size());
+}
+
+void NukiNetwork::scheduleReconnect()
+{
+    // Exponential backoff with jitter, so hubs don't reconnect in lockstep after a broker restart
+    uint32_t backoff = MQTT_RECONNECT_BACKOFF_MAX;
+    if(_mqttReconnectAttempts < 16)
+    {
+        backoff = std::min<uint32_t>(MQTT_RECONNECT_BACKOFF_MIN << _mqttReconnectAttempts, MQTT_RECONNECT_BACKOFF_MAX);
+        ++_mqttReconnectAttempts;
+    }
+
+    _nextReconnect = espMillis() + backoff / 2 + esp_random() % (backoff / 2 + 1);
+    setMqttConnectionState(0);
+    _mqttConnectPhase = MqttConnectPhase::Idle;
+}
+
+void NukiNetwork::setMqttConnectionState(int state)
+{
+    if(_mqttConnectionState != state)
+    {
+        _mqttConnectionState = state;
+        notifyStatusChanged();
     }
-    return _mqttConnectionState > 0;
 }
 
 void NukiNetwork::subscribe(const char* prefix, const char *path)
@@ -806,6 +1035,23 @@ void NukiNetwork::subscribe(const char* prefix, const char *path)
     char prefixedPath[500];
     buildMqttPath(prefixedPath, { prefix, path });
     _subscribedTopics.push_back(prefixedPath);
+    _publishCache.exclude(prefixedPath);
+}
+
+void NukiNetwork::subscribe(const char* prefix, const char* path, MqttTopicHandler handler)
+{
+    char prefixedPath[500];
+    buildMqttPath(prefixedPath, { prefix, path });
+
+    if(!_dispatcher.add(prefixedPath, handler))
+    {
+        Log->print(("MQTT handler already registered: "));
+        Log->println(prefixedPath);
+        return;
+    }
+
+    _subscribedTopics.push_back(prefixedPath);
+    _publishCache.exclude(prefixedPath);
 }
 
 void NukiNetwork::initTopic(const char *prefix, const char *path, const char *value)
@@ -817,32 +1063,6 @@ void NukiNetwork::initTopic(const char *prefix, const char *path, const char *va
     _initTopics[pathStr] = valueStr;
 }
 
-void NukiNetwork::buildMqttPath(const char *path, char *outPath)
-{
-    int offset = 0;
-    char inPath[181] = {0};
-
-    memcpy(inPath, _nukiHubPath, sizeof(_nukiHubPath));
-
-    for(const char& c : inPath)
-    {
-        if(c == 0x00)
-        {
-            break;
-        }
-        outPath[offset] = c;
-        ++offset;
-    }
-    int i=0;
-    while(outPath[i] != 0x00)
-    {
-        outPath[offset] = path[i];
-        ++i;
-        ++offset;
-    }
-    outPath[i+1] = 0x00;
-}
-
 void NukiNetwork::buildMqttPath(char* outPath, std::initializer_list<const char*> paths)
 {
     int offset = 0;
@@ -869,54 +1089,111 @@ void NukiNetwork::buildMqttPath(char* outPath, std::initializer_list<const char*
     outPath[offset] = 0x00;
 }
 
-void NukiNetwork::registerMqttReceiver(MqttReceiver* receiver)
+void NukiNetwork::onMqttDataReceivedCallback(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total)
 {
-    _mqttReceivers.push_back(receiver);
+    _inst->onMqttDataReceived(properties, topic, payload, len, index, total);
 }
 
-void NukiNetwork::onMqttDataReceivedCallback(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total)
+void NukiNetwork::onMqttDataReceived(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t& len, size_t& index, size_t& total)
 {
-    uint8_t value[800] = {0};
+    if(_mqttConnectedTs == -1 || (millis() - _mqttConnectedTs < 2000))
+    {
+        return;
+    }
 
-    size_t l = min(len, sizeof(value)-1);
+    if(index == 0)
+    {
+        _payloadLength = 0;
 
-    for(int i=0; i<l; i++)
+        // Wildcard subscriptions also deliver topics nobody handles (including our own state topics), drop those before buffering
+        if(!_dispatcher.accepts(topic))
+        {
+            return;
+        }
+
+        if(total > MQTT_MAX_INBOUND_PAYLOAD_SIZE || !reservePayloadBuffer(total + 1))
+        {
+            Log->printf("Unable to buffer MQTT payload of %u bytes, ignoring message on topic %s\n", (unsigned int)total, topic);
+            return;
+        }
+    }
+
+    // Fragments of a message that was ignored (or started before the connect grace period ended)
+    if(index != _payloadLength || index + len > total || total >= _payloadBufferSize)
     {
-        value[i] = payload[i];
+        return;
     }
 
-    _inst->onMqttDataReceived(properties, topic, value, len, index, total);
-}
+    // Fragments are delivered in order, the receivers always get the complete, null terminated payload
+    if(len > 0)
+    {
+        memcpy(_payloadBuffer + index, payload, len);
+        _payloadLength += len;
+    }
 
-void NukiNetwork::onMqttDataReceived(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t& len, size_t& index, size_t& total)
-{
-    if(_mqttConnectedTs == -1 || (millis() - _mqttConnectedTs < 2000))
+    if(_payloadLength < total)
     {
         return;
     }
 
-    parseGpioTopics(properties, topic, payload, len, index, total);
+    _payloadBuffer[total] = 0;
+    _payloadLength = 0;
 
-    onMqttDataReceived(topic, (byte*)payload, index);
+    _dispatcher.dispatch(topic, _payloadBuffer, total);
 
-    for(auto receiver : _mqttReceivers)
+    if(_payloadBufferSize > MQTT_INBOUND_BUFFER_KEEP_SIZE)
     {
-        receiver->onMqttDataReceived(topic, (byte*)payload, index);
+        free(_payloadBuffer);
+        _payloadBuffer = nullptr;
+        _payloadBufferSize = 0;
     }
+
+    // Commands and queries may have scheduled work for the nuki task
+    wakeNukiTask();
 }
 
-void NukiNetwork::onMqttDataReceived(const char* topic, byte* payload, const unsigned int length)
+bool NukiNetwork::reservePayloadBuffer(const size_t size)
 {
-    char* data = (char*)payload;
+    if(size <= _payloadBufferSize)
+    {
+        return true;
+    }
+
+    char* buffer = (char*)realloc(_payloadBuffer, size);
+    if(buffer == nullptr)
+    {
+        return false;
+    }
+
+    _payloadBuffer = buffer;
+    _payloadBufferSize = size;
+    return true;
+}
 
-    if(comparePrefixedPath(topic, mqtt_topic_reset) && strcmp(data, "1") == 0 && !mqttRecentlyConnected())
+void NukiNetwork::onResetReceived(const char* data)
+{
+    if(strcmp(data, "1") == 0 && !mqttRecentlyConnected())
     {
         Log->println(("Restart requested via MQTT."));
         clearWifiFallback();
         delay(200);
         restartEsp(RestartReason::RequestedViaMqtt);
     }
-    else if(comparePrefixedPath(topic, mqtt_topic_update) && strcmp(data, "1") == 0 && _preferences->getBool(preference_update_from_mqtt, false) && !mqttRecentlyConnected())
+}
+
+void NukiNetwork::onHassRefreshReceived(const char* data)
+{
+    if(strcmp(data, "1") == 0 && !mqttRecentlyConnected())
+    {
+        Log->println(("HASS discovery refresh requested via MQTT."));
+        _hadiscovery->refresh();
+        publishString(_maintenancePathPrefix, mqtt_topic_hass_refresh, "0", true);
+    }
+}
+
+void NukiNetwork::onUpdateReceived(const char* data)
+{
+    if(strcmp(data, "1") == 0 && _preferences->getBool(preference_update_from_mqtt, false) && !mqttRecentlyConnected())
     {
         Log->println(("Update requested via MQTT."));
 
@@ -1021,65 +1298,50 @@ void NukiNetwork::onMqttDataReceived(const char* topic, byte* payload, const uns
             Log->println(("Failed to retrieve OTA manifest, OTA update aborted."));
         }
     }
-    else if(comparePrefixedPath(topic, mqtt_topic_webserver_action) && !mqttRecentlyConnected())
+}
+
+void NukiNetwork::onWebserverActionReceived(const char* data)
+{
+    if(mqttRecentlyConnected() ||
+            strcmp(data, "") == 0 ||
+            strcmp(data, "--") == 0)
     {
-        if(strcmp(data, "") == 0 ||
-                strcmp(data, "--") == 0)
-        {
-            return;
-        }
+        return;
+    }
 
-        if(strcmp(data, "1") == 0)
+    if(strcmp(data, "1") == 0)
+    {
+        if(_preferences->getBool(preference_webserver_enabled, true) || forceEnableWebServer)
         {
-            if(_preferences->getBool(preference_webserver_enabled, true) || forceEnableWebServer)
-            {
-                return;
-            }
-            Log->println(("Webserver enabled, restarting."));
-            _preferences->putBool(preference_webserver_enabled, true);            
+            return;
         }
-        else if (strcmp(data, "0") == 0)
+        Log->println(("Webserver enabled, restarting."));
+        _preferences->putBool(preference_webserver_enabled, true);            
+    }
+    else if (strcmp(data, "0") == 0)
+    {
+        if(!_preferences->getBool(preference_webserver_enabled, true) && !forceEnableWebServer)
         {
-            if(!_preferences->getBool(preference_webserver_enabled, true) && !forceEnableWebServer)
-            {
-                return;
-            }
-            Log->println(("Webserver disabled, restarting."));
-            _preferences->putBool(preference_webserver_enabled, false);
+            return;
         }
-        clearWifiFallback();
-        delay(200);
-        restartEsp(RestartReason::ReconfigureWebServer);
+        Log->println(("Webserver disabled, restarting."));
+        _preferences->putBool(preference_webserver_enabled, false);
     }
+    clearWifiFallback();
+    delay(200);
+    restartEsp(RestartReason::ReconfigureWebServer);
 }
 
-void NukiNetwork::parseGpioTopics(const espMqttClientTypes::MessageProperties &properties, const char *topic, const uint8_t *payload, size_t& len, size_t& index, size_t& total)
+void NukiNetwork::onGpioReceived(const int pin, const char* data)
 {
-    char gpioPath[250];
-    buildMqttPath(gpioPath, {_lockPath.c_str(), mqtt_topic_gpio_prefix, mqtt_topic_gpio_pin});
-//    /nuki_t/gpio/pin_17/state
-    size_t gpioLen = strlen(gpioPath);
-    if(strncmp(gpioPath, topic, gpioLen) == 0)
+    if(_gpio->getPinRole(pin) == PinRole::GeneralOutput)
     {
-        char pinStr[3] = {0};
-        pinStr[0] = topic[gpioLen];
-        if(topic[gpioLen+1] != '/')
-        {
-            pinStr[1] = topic[gpioLen+1];
-        }
-
-        int pin = std::atoi(pinStr);
-
-        if(_gpio->getPinRole(pin) == PinRole::GeneralOutput)
-        {
-            const uint8_t pinState = strcmp((const char*)payload, "1") == 0 ? HIGH : LOW;
-            Log->print(("GPIO "));
-            Log->print(pin);
-            Log->print((" (Output) --> "));
-            Log->println(pinState);
-            digitalWrite(pin, pinState);
-        }
-
+        const uint8_t pinState = strcmp(data, "1") == 0 ? HIGH : LOW;
+        Log->print(("GPIO "));
+        Log->print(pin);
+        Log->print((" (Output) --> "));
+        Log->println(pinState);
+        digitalWrite(pin, pinState);
     }
 }
 
@@ -1099,6 +1361,31 @@ int NukiNetwork::mqttConnectionState()
     return _mqttConnectionState;
 }
 
+int8_t NukiNetwork::signalStrength()
+{
+    return _device->signalStrength();
+}
+
+size_t NukiNetwork::mqttQueueSize()
+{
+    return _device->mqttQueueSize();
+}
+
+size_t NukiNetwork::mqttQueueHighWaterMark()
+{
+    return _device->mqttQueueHighWaterMark();
+}
+
+uint32_t NukiNetwork::mqttPublishesDropped()
+{
+    return _mqttPublishesDropped;
+}
+
+HassDiscoveryProgress NukiNetwork::hassDiscoveryProgress()
+{
+    return _hadiscovery->progress();
+}
+
 bool NukiNetwork::mqttRecentlyConnected()
 {
     return _mqttConnectedTs != -1 && (millis() - _mqttConnectedTs < 6000);
@@ -1160,14 +1447,193 @@ void NukiNetwork::publishString(const char* prefix, const char *topic, const cha
 
 void NukiNetwork::publish(const char* prefix, const char *topic, const char *value, bool retain)
 {
-    char path[200] = {0};
-    buildMqttPath(path, { prefix, topic });
-    _device->mqttPublish(path, MQTT_QOS_LEVEL, retain, value);
+    MqttTopicRegistry::Topic registeredTopic;
+
+    if(!_topicRegistry.lookup(prefix, topic, isCacheableTopic, isLastValueTopic, MqttQosPolicy::classify, registeredTopic))
+    {
+        Log->print("MQTT topic registry full, dropping publish to ");
+        Log->println(topic);
+        return;
+    }
+
+    publish(registeredTopic, value, retain);
+}
+
+void NukiNetwork::publishJson(const char* prefix, const char *topic, JsonVariantConst json, bool retain)
+{
+    MqttTopicRegistry::Topic registeredTopic;
+
+    if(!_topicRegistry.lookup(prefix, topic, isCacheableTopic, isLastValueTopic, MqttQosPolicy::classify, registeredTopic))
+    {
+        Log->print("MQTT topic registry full, dropping publish to ");
+        Log->println(topic);
+        return;
+    }
+
+    publishJson(registeredTopic.path, registeredTopic.pathHash, json, retain, retain && registeredTopic.cacheable, retain && registeredTopic.lastValue, _qosPolicy.qos(registeredTopic.topicClass));
+}
+
+void NukiNetwork::publish(const uint16_t topicId, const char *value, bool retain)
+{
+    MqttTopicRegistry::Topic registeredTopic;
+
+    if(!_topicRegistry.get(topicId, registeredTopic))
+    {
+        Log->print("Invalid MQTT topic id: ");
+        Log->println(topicId);
+        return;
+    }
+
+    publish(registeredTopic, value, retain);
+}
+
+void NukiNetwork::publishInt(const uint16_t topicId, const int value, bool retain)
+{
+    char str[30];
+    itoa(value, str, 10);
+    publish(topicId, str, retain);
+}
+
+void NukiNetwork::publishUInt(const uint16_t topicId, const unsigned int value, bool retain)
+{
+    char str[30];
+    utoa(value, str, 10);
+    publish(topicId, str, retain);
+}
+
+void NukiNetwork::publishULong(const uint16_t topicId, const unsigned long value, bool retain)
+{
+    char str[30];
+    ultoa(value, str, 10);
+    publish(topicId, str, retain);
+}
+
+uint16_t NukiNetwork::topicId(const char* prefix, const char *topic)
+{
+    return _topicRegistry.intern(prefix, topic, isCacheableTopic, isLastValueTopic, MqttQosPolicy::classify);
+}
+
+void NukiNetwork::publish(const MqttTopicRegistry::Topic& registeredTopic, const char *value, bool retain)
+{
+    publish(registeredTopic.path, registeredTopic.pathHash, value, retain, retain && registeredTopic.cacheable, retain && registeredTopic.lastValue, _qosPolicy.qos(registeredTopic.topicClass));
 }
 
 void NukiNetwork::publish(const char* path, const char *value, bool retain)
 {
-    _device->mqttPublish(path, MQTT_QOS_LEVEL, retain, value);
+    publish(path, MqttPublishCache::pathHash(path), value, retain, retain, false, _qosPolicy.qos(MqttTopicClass::State));
+}
+
+void NukiNetwork::publish(const char* path, const uint32_t pathHash, const char *value, bool retain, bool useCache, bool lastValue, uint8_t qos)
+{
+    if(useCache && !_publishCache.update(pathHash, value, espMillis()))
+    {
+        return;
+    }
+
+    espMqttClientTypes::PublishMode mode = lastValue ? espMqttClientTypes::PublishMode::LAST_VALUE : espMqttClientTypes::PublishMode::QUEUE_ALL;
+
+    onPublishResult(pathHash, retain, _device->mqttPublish(path, qos, retain, value, mode));
+}
+
+void NukiNetwork::publishJson(const char* path, const uint32_t pathHash, JsonVariantConst json, bool retain, bool useCache, bool lastValue, uint8_t qos)
+{
+    size_t length = 0;
+
+    if(useCache)
+    {
+        MqttPublishCache::ValueHasher hasher;
+        serializeJson(json, hasher);
+
+        if(!_publishCache.update(pathHash, hasher, espMillis()))
+        {
+            return;
+        }
+        length = hasher.length();
+    }
+    else
+    {
+        length = measureJson(json);
+    }
+
+    espMqttClientTypes::PublishMode mode = lastValue ? espMqttClientTypes::PublishMode::LAST_VALUE : espMqttClientTypes::PublishMode::QUEUE_ALL;
+
+    uint16_t packetId = _device->mqttPublish(path, qos, retain, [&json](uint8_t* data, size_t size)
+    {
+        return serializeJson(json, data, size);
+    }, length, mode);
+
+    onPublishResult(pathHash, retain, packetId);
+}
+
+void NukiNetwork::onPublishResult(const uint32_t pathHash, bool retain, uint16_t packetId)
+{
+    if(packetId == 0)
+    {
+        // not queued, either the connection dropped or the outbox is full because the broker can't keep up
+        if(retain)
+        {
+            _publishCache.invalidate(pathHash);
+        }
+        if(_device->mqttConnected())
+        {
+            if(!_mqttPublishBackpressure)
+            {
+                Log->print("MQTT outbox full, dropping publishes (");
+                Log->print(_device->mqttQueueSize());
+                Log->println(" packets queued)");
+                _mqttPublishBackpressure = true;
+            }
+            ++_mqttPublishesDropped;
+        }
+    }
+    else if(_mqttPublishBackpressure)
+    {
+        Log->println("MQTT outbox accepting publishes again");
+        _mqttPublishBackpressure = false;
+    }
+}
+
+bool NukiNetwork::isCacheableTopic(const char *topic)
+{
+    // Results are published on every command, even if the result didn't change
+    static const char* const uncachedTopics[] =
+    {
+        mqtt_topic_lock_action_command_result, mqtt_topic_config_action_command_result, mqtt_topic_query_lockstate_command_result,
+        mqtt_topic_keypad_command_result, mqtt_topic_keypad_json_command_result, mqtt_topic_timecontrol_command_result,
+        mqtt_topic_auth_command_result, mqtt_topic_lock_retry
+    };
+
+    for(const char* uncachedTopic : uncachedTopics)
+    {
+        if(strcmp(topic, uncachedTopic) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NukiNetwork::isLastValueTopic(const char *topic)
+{
+    // Retained states where only the latest value matters, an unsent older value is replaced by a newer one.
+    // Event topics like the rolling log publish every value and must never be replaced.
+    static const char* const lastValueTopics[] =
+    {
+        mqtt_topic_lock_state, mqtt_topic_lock_ha_state, mqtt_topic_lock_binary_state, mqtt_topic_lock_json,
+        mqtt_topic_battery_level, mqtt_topic_battery_critical, mqtt_topic_battery_charging, mqtt_topic_battery_voltage,
+        mqtt_topic_battery_drain, mqtt_topic_battery_max_turn_current, mqtt_topic_battery_lock_distance,
+        mqtt_topic_battery_keypad_critical, mqtt_topic_battery_doorsensor_critical, mqtt_topic_battery_basic_json,
+        mqtt_topic_battery_advanced_json
+    };
+
+    for(const char* lastValueTopic : lastValueTopics)
+    {
+        if(strcmp(topic, lastValueTopic) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 void NukiNetwork::removeTopic(const String& mqttPath, const String& mqttTopic)
@@ -1415,19 +1881,52 @@ uint16_t NukiNetwork::subscribe(const char *topic, uint8_t qos)
     return _device->mqttSubscribe(topic, qos);
 }
 
-bool NukiNetwork::comparePrefixedPath(const char *fullPath, const char *subPath)
+uint16_t NukiNetwork::subscribe(const espMqttClientTypes::SubscribeItem* items, const size_t count)
 {
-    char prefixedPath[500];
-    buildMqttPath(subPath, prefixedPath);
-
-    return strcmp(fullPath, prefixedPath) == 0;
+    for(size_t i = 0; i < count; i++)
+    {
+        Log->print("Subscribing to MQTT topic: ");
+        Log->println(items[i].topic);
+    }
+    return _device->mqttSubscribe(items, count);
 }
 
+
 void NukiNetwork::addReconnectedCallback(std::function<void()> reconnectedCallback)
 {
     _reconnectedCallbacks.push_back(reconnectedCallback);
 }
 
+void NukiNetwork::addStatusChangedCallback(std::function<void()> statusChangedCallback)
+{
+    _statusChangedCallbacks.push_back(statusChangedCallback);
+}
+
+void NukiNetwork::notifyStatusChanged()
+{
+    for(const auto& callback : _statusChangedCallbacks)
+    {
+        callback();
+    }
+}
+
+void NukiNetwork::addNukiCommandsDroppedCounter(std::function<uint32_t()> counter)
+{
+    _nukiCommandsDroppedCounters.push_back(counter);
+}
+
+uint32_t NukiNetwork::nukiCommandsDropped()
+{
+    uint32_t dropped = 0;
+
+    for(const auto& counter : _nukiCommandsDroppedCounters)
+    {
+        dropped += counter();
+    }
+
+    return dropped;
+}
+
 void NukiNetwork::disableMqtt()
 {
     _device->mqttDisable();
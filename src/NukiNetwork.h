@@ -1,8 +1,9 @@
 #pragma once
 
-#include <Preferences.h>
+#include "CachedPreferences.h"
 #include <vector>
 #include <map>
+#include <atomic>
 #include "networkDevices/NetworkDevice.h"
 #include "networkDevices/IPConfiguration.h"
 #include "enums/NetworkDeviceType.h"
@@ -10,12 +11,15 @@
 #include "EspMillis.h"
 
 #ifndef NUKI_HUB_UPDATER
-#include "MqttReceiver.h"
 #include "MqttTopics.h"
 #include "Gpio.h"
 #include <ArduinoJson.h>
 #include "NukiConstants.h"
 #include "HomeAssistantDiscovery.h"
+#include "MqttPublishCache.h"
+#include "MqttTopicRegistry.h"
+#include "MqttDispatcher.h"
+#include "MqttQosPolicy.h"
 #endif
 
 class NukiNetwork
@@ -40,16 +44,16 @@ public:
     NetworkDevice* device();
 
     #ifdef NUKI_HUB_UPDATER
-    explicit NukiNetwork(Preferences* preferences);
+    explicit NukiNetwork(CachedPreferences* preferences);
     #else
-    explicit NukiNetwork(Preferences* preferences, Gpio* gpio, const String& maintenancePathPrefix, char* buffer, size_t bufferSize);
+    explicit NukiNetwork(CachedPreferences* preferences, Gpio* gpio, const String& maintenancePathPrefix);
 
-    void registerMqttReceiver(MqttReceiver* receiver);
     void disableAutoRestarts(); // disable on OTA start
     void disableMqtt();
     String localIP();
 
     void subscribe(const char* prefix, const char* path);
+    void subscribe(const char* prefix, const char* path, MqttTopicHandler handler);
     void initTopic(const char* prefix, const char* path, const char* value);
     void publishFloat(const char* prefix, const char* topic, const float value, bool retain, const uint8_t precision = 2);
     void publishInt(const char* prefix, const char* topic, const int value, bool retain);
@@ -58,8 +62,16 @@ public:
     void publishLongLong(const char* prefix, const char* topic, int64_t value, bool retain);
     void publishBool(const char* prefix, const char* topic, const bool value, bool retain);
     void publishString(const char* prefix, const char* topic, const char* value, bool retain);
+    // Serializes json straight into the MQTT packet, the payload isn't limited by the publish buffer size
+    void publishJson(const char* prefix, const char* topic, JsonVariantConst json, bool retain);
     void publish(const char* prefix, const char *topic, const char *value, bool retain);
     void publish(const char* path, const char *value, bool retain);
+    // Publishers of frequently updated topics keep the id from topicId() and skip the path lookup
+    void publish(const uint16_t topicId, const char *value, bool retain);
+    void publishInt(const uint16_t topicId, const int value, bool retain);
+    void publishUInt(const uint16_t topicId, const unsigned int value, bool retain);
+    void publishULong(const uint16_t topicId, const unsigned long value, bool retain);
+    uint16_t topicId(const char* prefix, const char* topic);
     void removeTopic(const String& mqttPath, const String& mqttTopic);
     void batteryTypeToString(const Nuki::BatteryType battype, char* str);
     void advertisingModeToString(const Nuki::AdvertisingMode advmode, char* str);
@@ -85,20 +97,30 @@ public:
     void removeHassTopic(const String& mqttDeviceType, const String& mqttDeviceName, const String& uidString);
 
     int mqttConnectionState(); // 0 = not connected; 1 = connected; 2 = connected and mqtt processed
+    int8_t signalStrength();
+    size_t mqttQueueSize();
+    size_t mqttQueueHighWaterMark();
+    uint32_t mqttPublishesDropped();
+    HassDiscoveryProgress hassDiscoveryProgress();
     bool mqttRecentlyConnected();
     bool pathEquals(const char* prefix, const char* path, const char* referencePath);
     uint16_t subscribe(const char* topic, uint8_t qos);
     void addReconnectedCallback(std::function<void()> reconnectedCallback);
+    // Called when a value shown on the web status page changed (MQTT state, lock or opener state, RSSI, free heap)
+    void addStatusChangedCallback(std::function<void()> statusChangedCallback);
+    // Counters of dropped lock / opener commands, their sum is published as maintenance/nukiCommandsDropped
+    void addNukiCommandsDroppedCounter(std::function<uint32_t()> counter);
+    uint32_t nukiCommandsDropped();
+    void notifyStatusChanged();
     #endif
 private:
     void setupDevice();
-    bool reconnect();
 
     static NukiNetwork* _inst;
 
     const char* _latestVersion;
 
-    Preferences* _preferences;
+    CachedPreferences* _preferences;
     IPConfiguration* _ipConfiguration = nullptr;
     String _hostname;
     char _hostnameArr[101] = {0};
@@ -106,6 +128,8 @@ private:
     NetworkDevice* _device = nullptr;
     std::function<void()> _keepAliveCallback = nullptr;
     std::vector<std::function<void()>> _reconnectedCallbacks;
+    std::vector<std::function<void()>> _statusChangedCallbacks;
+    std::vector<std::function<uint32_t()>> _nukiCommandsDroppedCounters;
 
     NetworkDeviceType _networkDeviceType  = (NetworkDeviceType)-1;
     bool _firstBootAfterDeviceChange = false;
@@ -114,14 +138,31 @@ private:
     #ifndef NUKI_HUB_UPDATER
     static void onMqttDataReceivedCallback(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total);
     void onMqttDataReceived(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t& len, size_t& index, size_t& total);
-    void onMqttDataReceived(const char* topic, byte* payload, const unsigned int length);
+    void onResetReceived(const char* data);
+    void onUpdateReceived(const char* data);
+    void onHassRefreshReceived(const char* data);
+    void onWebserverActionReceived(const char* data);
+    void onGpioReceived(const int pin, const char* data);
     void onMqttConnect(const bool& sessionPresent);
     void onMqttDisconnect(const espMqttClientTypes::DisconnectReason& reason);
-    void parseGpioTopics(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t& len, size_t& index, size_t& total);
+    void updateMqttConnection();
+    void startMqttConnect();
+    void onMqttConnected();
+    bool replayMqttSession();
+    void buildSubscriptionFilters();
+    uint16_t subscribe(const espMqttClientTypes::SubscribeItem* items, const size_t count);
+    void scheduleReconnect();
+    void setMqttConnectionState(int state);
+    bool reservePayloadBuffer(const size_t size);
     void gpioActionCallback(const GpioAction& action, const int& pin);
-    bool comparePrefixedPath(const char* fullPath, const char* subPath);
-    void buildMqttPath(const char *path, char *outPath);
     void buildMqttPath(char* outPath, std::initializer_list<const char*> paths);
+    void publish(const MqttTopicRegistry::Topic& registeredTopic, const char *value, bool retain);
+    void publish(const char* path, const uint32_t pathHash, const char *value, bool retain, bool useCache, bool lastValue, uint8_t qos);
+    void publishJson(const char* path, const uint32_t pathHash, JsonVariantConst json, bool retain, bool useCache, bool lastValue, uint8_t qos);
+    void onPublishResult(const uint32_t pathHash, bool retain, uint16_t packetId);
+    static bool isCacheableTopic(const char* topic);
+    static bool isSettingsKey(const char* key);
+    static bool isLastValueTopic(const char* topic);
 
     const char* _lastWillPayload = "offline";
     char _mqttConnectionStateTopic[211] = {0};
@@ -131,11 +172,32 @@ private:
 
     Gpio* _gpio;
 
+    enum class MqttConnectPhase
+    {
+        Idle,
+        Connecting,
+        Replaying,
+        Connected
+    };
+
+    MqttConnectPhase _mqttConnectPhase = MqttConnectPhase::Idle;
     int _mqttConnectionState = 0;
     int _mqttConnectCounter = 0;
     int _mqttPort = 1883;
     long _mqttConnectedTs = -1;
     bool _connectReplyReceived = false;
+    bool _connectFailed = false;
+    int64_t _mqttConnectStartTs = 0;
+    int64_t _mqttConnectTimeoutTs = 0;
+    int64_t _mqttReplayStartTs = 0;
+    int64_t _mqttReadyDuration = 0;
+    uint32_t _mqttPublishesDropped = 0;
+    bool _mqttPublishBackpressure = false;
+    uint32_t _mqttReconnectAttempts = 0;
+    std::map<String, String>::iterator _replayInitTopic;
+    bool _initTopicsReplayed = false;
+    size_t _replaySubscribedTopic = 0;
+    std::atomic<bool> _settingsChanged{false};
     bool _firstDisconnected = true;
 
     int64_t _publishedUpTime = 0;
@@ -145,7 +207,6 @@ private:
     char _mqttPass[31] = {0};
     char _maintenancePathPrefix[181] = {0};
     int _networkTimeout = 0;
-    std::vector<MqttReceiver*> _mqttReceivers;
     bool _restartOnDisconnect = false;
     bool _disableNetworkIfNotConnected = false;
     bool _checkUpdates = false;
@@ -154,6 +215,9 @@ private:
     bool _logIp = true;
     bool _retainGpio = false;
     std::vector<String> _subscribedTopics;
+    std::vector<String> _subscriptionFilters;
+    bool _wildcardSubscriptions = false;
+    bool _mqttV5 = false;
     std::map<String, String> _initTopics;
     int64_t _lastConnectedTs = 0;
     int64_t _lastMaintenanceTs = 0;
@@ -163,9 +227,17 @@ private:
     int _rssiPublishInterval = 0;
     std::map<uint8_t, int64_t> _gpioTs;
 
-    char* _buffer;
-    const size_t _bufferSize;
+    MqttPublishCache _publishCache;
+    MqttTopicRegistry _topicRegistry;
+    MqttDispatcher _dispatcher;
+    MqttQosPolicy _qosPolicy;
+    char* _payloadBuffer = nullptr;
+    size_t _payloadBufferSize = 0;
+    size_t _payloadLength = 0;
 
     int8_t _lastRssi = 127;
+    uint16_t _rssiTopicId = MQTT_TOPIC_ID_INVALID;
+    uint16_t _uptimeTopicId = MQTT_TOPIC_ID_INVALID;
+    uint16_t _freeHeapTopicId = MQTT_TOPIC_ID_INVALID;
     #endif
 };
\ No newline at end of file
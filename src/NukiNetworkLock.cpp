@@ -12,20 +12,16 @@ extern bool forceEnableWebServer;
 extern const uint8_t x509_crt_imported_bundle_bin_start[] asm("_binary_x509_crt_bundle_start");
 extern const uint8_t x509_crt_imported_bundle_bin_end[]   asm("_binary_x509_crt_bundle_end");
 
-NukiNetworkLock::NukiNetworkLock(NukiNetwork* network, NukiOfficial* nukiOfficial, Preferences* preferences, char* buffer, size_t bufferSize)
+NukiNetworkLock::NukiNetworkLock(NukiNetwork* network, NukiOfficial* nukiOfficial, CachedPreferences* preferences)
     : _network(network),
       _nukiOfficial(nukiOfficial),
-      _preferences(preferences),
-      _buffer(buffer),
-      _bufferSize(bufferSize)
+      _preferences(preferences)
 {
     _nukiPublisher = new NukiPublisher(network, _mqttPath);
     _nukiOfficial->setPublisher(_nukiPublisher);
 
     memset(_authName, 0, sizeof(_authName));
     _authName[0] = '\0';
-
-    _network->registerMqttReceiver(this);
 }
 
 NukiNetworkLock::~NukiNetworkLock()
@@ -43,23 +39,48 @@ void NukiNetworkLock::initialize()
         _mqttPath[i] = mqttPath.charAt(i);
     }
 
+    _lockStateTopicId = _network->topicId(_mqttPath, mqtt_topic_lock_state);
+    _haStateTopicId = _network->topicId(_mqttPath, mqtt_topic_lock_ha_state);
+    _binaryStateTopicId = _network->topicId(_mqttPath, mqtt_topic_lock_binary_state);
+
     _haEnabled = _preferences->getString(preference_mqtt_hass_discovery, "") != "";
     _disableNonJSON = _preferences->getBool(preference_disable_non_json, false);
     _hybridRebootOnDisconnect = _preferences->getBool(preference_hybrid_reboot_on_disconnect, false);
     _isUltra = _preferences->getBool(preference_lock_gemini_enabled, false);
 
+    _network->addReconnectedCallback([this]()
+    {
+        // Invalidates the entry snapshots, keypad, time control and authorization lists are published in full after a reconnect
+        ++_mqttReconnects;
+    });
+
     _network->initTopic(_mqttPath, mqtt_topic_lock_action, "--");
-    _network->subscribe(_mqttPath, mqtt_topic_lock_action);
+    subscribe(mqtt_topic_lock_action, [this](const char* data)
+    {
+        onLockActionReceived(data);
+    });
     _network->initTopic(_mqttPath, mqtt_topic_config_action, "--");
-    _network->subscribe(_mqttPath, mqtt_topic_config_action);
+    subscribe(mqtt_topic_config_action, [this](const char* data)
+    {
+        onJsonCommandReceived(mqtt_topic_config_action, _configUpdateReceivedCallback, data);
+    });
 
     _network->initTopic(_mqttPath, mqtt_topic_query_keypad, "0");
     _network->initTopic(_mqttPath, mqtt_topic_query_config, "0");
     _network->initTopic(_mqttPath, mqtt_topic_query_lockstate, "0");
     _network->initTopic(_mqttPath, mqtt_topic_query_battery, "0");
-    _network->subscribe(_mqttPath, mqtt_topic_query_config);
-    _network->subscribe(_mqttPath, mqtt_topic_query_lockstate);
-    _network->subscribe(_mqttPath, mqtt_topic_query_battery);
+    subscribe(mqtt_topic_query_config, [this](const char* data)
+    {
+        onQueryReceived(mqtt_topic_query_config, QUERY_COMMAND_CONFIG, data);
+    });
+    subscribe(mqtt_topic_query_lockstate, [this](const char* data)
+    {
+        onQueryReceived(mqtt_topic_query_lockstate, QUERY_COMMAND_LOCKSTATE, data);
+    });
+    subscribe(mqtt_topic_query_battery, [this](const char* data)
+    {
+        onQueryReceived(mqtt_topic_query_battery, QUERY_COMMAND_BATTERY, data);
+    });
 
     _network->initTopic(_mqttPath, mqtt_topic_auth_action, "--");
     _network->initTopic(_mqttPath, mqtt_topic_timecontrol_action, "--");
@@ -121,25 +142,52 @@ void NukiNetworkLock::initialize()
             _network->initTopic(_mqttPath, mqtt_topic_keypad_command_name, "--");
             _network->initTopic(_mqttPath, mqtt_topic_keypad_command_code, "000000");
             _network->initTopic(_mqttPath, mqtt_topic_keypad_command_enabled, "1");
-            _network->subscribe(_mqttPath, mqtt_topic_keypad_command_action);
-            _network->subscribe(_mqttPath, mqtt_topic_keypad_command_id);
-            _network->subscribe(_mqttPath, mqtt_topic_keypad_command_name);
-            _network->subscribe(_mqttPath, mqtt_topic_keypad_command_code);
-            _network->subscribe(_mqttPath, mqtt_topic_keypad_command_enabled);
+            subscribe(mqtt_topic_keypad_command_action, [this](const char* data)
+            {
+                onKeypadCommandActionReceived(data);
+            });
+            subscribe(mqtt_topic_keypad_command_id, [this](const char* data)
+            {
+                _keypadCommandId = atoi(data);
+            });
+            subscribe(mqtt_topic_keypad_command_name, [this](const char* data)
+            {
+                _keypadCommandName = data;
+            });
+            subscribe(mqtt_topic_keypad_command_code, [this](const char* data)
+            {
+                _keypadCommandCode = data;
+            });
+            subscribe(mqtt_topic_keypad_command_enabled, [this](const char* data)
+            {
+                _keypadCommandEnabled = atoi(data);
+            });
         }
 
-        _network->subscribe(_mqttPath, mqtt_topic_query_keypad);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_json_action);
+        subscribe(mqtt_topic_query_keypad, [this](const char* data)
+        {
+            onQueryReceived(mqtt_topic_query_keypad, QUERY_COMMAND_KEYPAD, data);
+        });
+        subscribe(mqtt_topic_keypad_json_action, [this](const char* data)
+        {
+            onJsonCommandReceived(mqtt_topic_keypad_json_action, _keypadJsonCommandReceivedReceivedCallback, data);
+        });
     }
 
     if(_preferences->getBool(preference_timecontrol_control_enabled))
     {
-        _network->subscribe(_mqttPath, mqtt_topic_timecontrol_action);
+        subscribe(mqtt_topic_timecontrol_action, [this](const char* data)
+        {
+            onJsonCommandReceived(mqtt_topic_timecontrol_action, _timeControlCommandReceivedReceivedCallback, data);
+        });
     }
 
     if(_preferences->getBool(preference_auth_control_enabled))
     {
-        _network->subscribe(_mqttPath, mqtt_topic_auth_action);
+        subscribe(mqtt_topic_auth_action, [this](const char* data)
+        {
+            onJsonCommandReceived(mqtt_topic_auth_action, _authCommandReceivedReceivedCallback, data);
+        });
     }
 
     if(_nukiOfficial->getOffEnabled())
@@ -148,13 +196,22 @@ void NukiNetworkLock::initialize()
 
         for(const auto& offTopic : _nukiOfficial->getOffTopics())
         {
-            _network->subscribe(_nukiOfficial->getMqttPath(), offTopic);
+            _network->subscribe(_nukiOfficial->getMqttPath(), offTopic, [this, offTopic](const char* topic, const char* data, const unsigned int length)
+            {
+                if(_officialUpdateReceivedCallback != nullptr)
+                {
+                    _officialUpdateReceivedCallback(offTopic, data);
+                }
+            });
         }
     }
 
     if(_preferences->getBool(preference_publish_authdata, false))
     {
-        _network->subscribe(_mqttPath, mqtt_topic_lock_log_rolling_last);
+        subscribe(mqtt_topic_lock_log_rolling_last, [this](const char* data)
+        {
+            onRollingLogReceived(data);
+        });
     }
 }
 
@@ -187,207 +244,114 @@ bool NukiNetworkLock::update()
     return ret;
 }
 
-void NukiNetworkLock::onMqttDataReceived(const char* topic, byte* payload, const unsigned int length)
+void NukiNetworkLock::subscribe(const char* path, std::function<void(const char* data)> handler)
 {
-    char* data = (char*)payload;
+    _network->subscribe(_mqttPath, path, [handler](const char* topic, const char* data, const unsigned int length)
+    {
+        handler(data);
+    });
+}
 
-    if(_network->mqttRecentlyConnected() && _network->pathEquals(_mqttPath, mqtt_topic_lock_action, topic))
+void NukiNetworkLock::onRollingLogReceived(const char* data)
+{
+    if(strcmp(data, "") == 0 ||
+            strcmp(data, "--") == 0)
     {
-        Log->println("MQTT recently connected, ignoring lock action.");
         return;
     }
 
-    if(comparePrefixedPath(topic, mqtt_topic_lock_log_rolling_last))
+    if(atoi(data) > 0 && atoi(data) > _lastRollingLog)
     {
-        if(strcmp(data, "") == 0 ||
-                strcmp(data, "--") == 0)
-        {
-            return;
-        }
-
-        if(atoi(data) > 0 && atoi(data) > _lastRollingLog)
-        {
-            _lastRollingLog = atoi(data);
-        }
+        _lastRollingLog = atoi(data);
     }
+}
 
-    if(_nukiOfficial->getOffEnabled())
+void NukiNetworkLock::onLockActionReceived(const char* data)
+{
+    if(_network->mqttRecentlyConnected())
     {
-        for(auto offTopic : _nukiOfficial->getOffTopics())
-        {
-            if(_nukiOfficial->comparePrefixedPath(topic, offTopic))
-            {
-                if(_officialUpdateReceivedCallback != nullptr)
-                {
-                    _officialUpdateReceivedCallback(offTopic, data);
-                }
-            }
-        }
+        Log->println("MQTT recently connected, ignoring lock action.");
+        return;
     }
 
-    if(comparePrefixedPath(topic, mqtt_topic_lock_action))
+    if(strcmp(data, "") == 0 ||
+            strcmp(data, "--") == 0 ||
+            strcmp(data, "ack") == 0 ||
+            strcmp(data, "unknown_action") == 0 ||
+            strcmp(data, "denied") == 0 ||
+            strcmp(data, "error") == 0)
     {
-        if(strcmp(data, "") == 0 ||
-                strcmp(data, "--") == 0 ||
-                strcmp(data, "ack") == 0 ||
-                strcmp(data, "unknown_action") == 0 ||
-                strcmp(data, "denied") == 0 ||
-                strcmp(data, "error") == 0)
-        {
-            return;
-        }
-
-        Log->print(("Lock action received: "));
-        Log->println(data);
-        LockActionResult lockActionResult = LockActionResult::Failed;
-        if(_lockActionReceivedCallback != NULL)
-        {
-            lockActionResult = _lockActionReceivedCallback(data);
-        }
-
-        switch(lockActionResult)
-        {
-        case LockActionResult::Success:
-            _nukiPublisher->publishString(mqtt_topic_lock_action, "ack", false);
-            break;
-        case LockActionResult::UnknownAction:
-            _nukiPublisher->publishString(mqtt_topic_lock_action, "unknown_action", false);
-            break;
-        case LockActionResult::AccessDenied:
-            _nukiPublisher->publishString(mqtt_topic_lock_action, "denied", false);
-            break;
-        case LockActionResult::Failed:
-            _nukiPublisher->publishString(mqtt_topic_lock_action, "error", false);
-            break;
-        }
+        return;
     }
 
-    if(!_disableNonJSON)
+    Log->print(("Lock action received: "));
+    Log->println(data);
+    LockActionResult lockActionResult = LockActionResult::Failed;
+    if(_lockActionReceivedCallback != NULL)
     {
-        if(comparePrefixedPath(topic, mqtt_topic_keypad_command_action))
-        {
-            if(_keypadCommandReceivedReceivedCallback != nullptr)
-            {
-                if(strcmp(data, "--") == 0)
-                {
-                    return;
-                }
-
-                _keypadCommandReceivedReceivedCallback(data, _keypadCommandId, _keypadCommandName, _keypadCommandCode, _keypadCommandEnabled);
-
-                _keypadCommandId = 0;
-                _keypadCommandName = "--";
-                _keypadCommandCode = "000000";
-                _keypadCommandEnabled = 1;
-
-                if(strcmp(data, "--") != 0)
-                {
-                    _nukiPublisher->publishString(mqtt_topic_keypad_command_action, "--", true);
-                }
-                _nukiPublisher->publishInt(mqtt_topic_keypad_command_id, _keypadCommandId, true);
-                _nukiPublisher->publishString(mqtt_topic_keypad_command_name, _keypadCommandName, true);
-                _nukiPublisher->publishString(mqtt_topic_keypad_command_code, _keypadCommandCode, true);
-                _nukiPublisher->publishInt(mqtt_topic_keypad_command_enabled, _keypadCommandEnabled, true);
-            }
-        }
-        else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_id))
-        {
-            _keypadCommandId = atoi(data);
-        }
-        else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_name))
-        {
-            _keypadCommandName = data;
-        }
-        else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_code))
-        {
-            _keypadCommandCode = data;
-        }
-        else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_enabled))
-        {
-            _keypadCommandEnabled = atoi(data);
-        }
+        lockActionResult = _lockActionReceivedCallback(data);
     }
 
-    if(comparePrefixedPath(topic, mqtt_topic_query_config) && strcmp(data, "1") == 0)
+    switch(lockActionResult)
     {
-        _queryCommands = _queryCommands | QUERY_COMMAND_CONFIG;
-        _nukiPublisher->publishInt(mqtt_topic_query_config, 0, true);
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_lockstate) && strcmp(data, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_LOCKSTATE;
-        _nukiPublisher->publishInt(mqtt_topic_query_lockstate, 0, true);
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_keypad) && strcmp(data, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_KEYPAD;
-        _nukiPublisher->publishInt(mqtt_topic_query_keypad, 0, true);
+    case LockActionResult::Success:
+        _nukiPublisher->publishString(mqtt_topic_lock_action, "ack", false);
+        break;
+    case LockActionResult::UnknownAction:
+        _nukiPublisher->publishString(mqtt_topic_lock_action, "unknown_action", false);
+        break;
+    case LockActionResult::AccessDenied:
+        _nukiPublisher->publishString(mqtt_topic_lock_action, "denied", false);
+        break;
+    case LockActionResult::Failed:
+        _nukiPublisher->publishString(mqtt_topic_lock_action, "error", false);
+        break;
     }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_battery) && strcmp(data, "1") == 0)
+}
+
+void NukiNetworkLock::onKeypadCommandActionReceived(const char* data)
+{
+    if(_keypadCommandReceivedReceivedCallback == nullptr || strcmp(data, "--") == 0)
     {
-        _queryCommands = _queryCommands | QUERY_COMMAND_BATTERY;
-        _nukiPublisher->publishInt(mqtt_topic_query_battery, 0, true);
+        return;
     }
 
-    if(comparePrefixedPath(topic, mqtt_topic_config_action))
-    {
-        if(strcmp(data, "") == 0 || strcmp(data, "--") == 0)
-        {
-            return;
-        }
+    _keypadCommandReceivedReceivedCallback(data, _keypadCommandId, _keypadCommandName, _keypadCommandCode, _keypadCommandEnabled);
 
-        if(_configUpdateReceivedCallback != NULL)
-        {
-            _configUpdateReceivedCallback(data);
-        }
+    _keypadCommandId = 0;
+    _keypadCommandName = "--";
+    _keypadCommandCode = "000000";
+    _keypadCommandEnabled = 1;
 
-        _nukiPublisher->publishString(mqtt_topic_config_action, "--", true);
-    }
+    _nukiPublisher->publishString(mqtt_topic_keypad_command_action, "--", true);
+    _nukiPublisher->publishInt(mqtt_topic_keypad_command_id, _keypadCommandId, true);
+    _nukiPublisher->publishString(mqtt_topic_keypad_command_name, _keypadCommandName, true);
+    _nukiPublisher->publishString(mqtt_topic_keypad_command_code, _keypadCommandCode, true);
+    _nukiPublisher->publishInt(mqtt_topic_keypad_command_enabled, _keypadCommandEnabled, true);
+}
 
-    if(comparePrefixedPath(topic, mqtt_topic_keypad_json_action))
+void NukiNetworkLock::onQueryReceived(const char* topic, const uint8_t queryCommand, const char* data)
+{
+    if(strcmp(data, "1") == 0)
     {
-        if(strcmp(data, "") == 0 || strcmp(data, "--") == 0)
-        {
-            return;
-        }
-
-        if(_keypadJsonCommandReceivedReceivedCallback != NULL)
-        {
-            _keypadJsonCommandReceivedReceivedCallback(data);
-        }
-
-        _nukiPublisher->publishString(mqtt_topic_keypad_json_action, "--", true);
+        _queryCommands = _queryCommands | queryCommand;
+        _nukiPublisher->publishInt(topic, 0, true);
     }
+}
 
-    if(comparePrefixedPath(topic, mqtt_topic_timecontrol_action))
+void NukiNetworkLock::onJsonCommandReceived(const char* topic, void (*callback)(const char* value), const char* data)
+{
+    if(strcmp(data, "") == 0 || strcmp(data, "--") == 0)
     {
-        if(strcmp(data, "") == 0 || strcmp(data, "--") == 0)
-        {
-            return;
-        }
-
-        if(_timeControlCommandReceivedReceivedCallback != NULL)
-        {
-            _timeControlCommandReceivedReceivedCallback(data);
-        }
-
-        _nukiPublisher->publishString(mqtt_topic_timecontrol_action, "--", true);
+        return;
     }
 
-    if(comparePrefixedPath(topic, mqtt_topic_auth_action))
+    if(callback != NULL)
     {
-        if(strcmp(data, "") == 0 || strcmp(data, "--") == 0)
-        {
-            return;
-        }
-
-        if(_authCommandReceivedReceivedCallback != NULL)
-        {
-            _authCommandReceivedReceivedCallback(data);
-        }
-
-        _nukiPublisher->publishString(mqtt_topic_auth_action, "--", true);
+        callback(data);
     }
+
+    _nukiPublisher->publishString(topic, "--", true);
 }
 
 void NukiNetworkLock::publishKeyTurnerState(const NukiLock::KeyTurnerState& keyTurnerState, const NukiLock::KeyTurnerState& lastKeyTurnerState)
@@ -405,7 +369,7 @@ void NukiNetworkLock::publishKeyTurnerState(const NukiLock::KeyTurnerState& keyT
         if(keyTurnerState.lockState != NukiLock::LockState::Undefined)
         {
 
-            _nukiPublisher->publishString(mqtt_topic_lock_state, str, true);
+            _network->publish(_lockStateTopicId, str, true);
 
             if(_haEnabled)
             {
@@ -524,8 +488,7 @@ void NukiNetworkLock::publishKeyTurnerState(const NukiLock::KeyTurnerState& keyT
             _nukiPublisher->publishBool(mqtt_topic_battery_doorsensor_critical, doorSensorCritical, true);
         }
 
-        serializeJson(jsonBattery, _buffer, _bufferSize);
-        _nukiPublisher->publishString(mqtt_topic_battery_basic_json, _buffer, true);
+        _nukiPublisher->publishJson(mqtt_topic_battery_basic_json, jsonBattery, true);
     }
     else
     {
@@ -573,8 +536,12 @@ void NukiNetworkLock::publishKeyTurnerState(const NukiLock::KeyTurnerState& keyT
     json["auth_id"] = getAuthId();
     json["auth_name"] = getAuthName();
 
-    serializeJson(json, _buffer, _bufferSize);
-    _nukiPublisher->publishString(mqtt_topic_lock_json, _buffer, true);
+    _nukiPublisher->publishJson(mqtt_topic_lock_json, json, true);
+
+    if(_firstTunerStatePublish || keyTurnerState.lockState != lastKeyTurnerState.lockState)
+    {
+        _network->notifyStatusChanged();
+    }
 
     _firstTunerStatePublish = false;
 }
@@ -584,35 +551,35 @@ void NukiNetworkLock::publishState(NukiLock::LockState lockState)
     switch(lockState)
     {
     case NukiLock::LockState::Locked:
-        _nukiPublisher->publishString(mqtt_topic_lock_ha_state, "locked", true);
-        _nukiPublisher->publishString(mqtt_topic_lock_binary_state, "locked", true);
+        _network->publish(_haStateTopicId, "locked", true);
+        _network->publish(_binaryStateTopicId, "locked", true);
         break;
     case NukiLock::LockState::Locking:
-        _nukiPublisher->publishString(mqtt_topic_lock_ha_state, "locking", true);
-        _nukiPublisher->publishString(mqtt_topic_lock_binary_state, "locked", true);
+        _network->publish(_haStateTopicId, "locking", true);
+        _network->publish(_binaryStateTopicId, "locked", true);
         break;
     case NukiLock::LockState::Unlocking:
-        _nukiPublisher->publishString(mqtt_topic_lock_ha_state, "unlocking", true);
-        _nukiPublisher->publishString(mqtt_topic_lock_binary_state, "unlocked", true);
+        _network->publish(_haStateTopicId, "unlocking", true);
+        _network->publish(_binaryStateTopicId, "unlocked", true);
         break;
     case NukiLock::LockState::Unlocked:
     case NukiLock::LockState::UnlockedLnga:
-        _nukiPublisher->publishString(mqtt_topic_lock_ha_state, "unlocked", true);
-        _nukiPublisher->publishString(mqtt_topic_lock_binary_state, "unlocked", true);
+        _network->publish(_haStateTopicId, "unlocked", true);
+        _network->publish(_binaryStateTopicId, "unlocked", true);
         break;
     case NukiLock::LockState::Unlatched:
-        _nukiPublisher->publishString(mqtt_topic_lock_ha_state, "open", true);
-        _nukiPublisher->publishString(mqtt_topic_lock_binary_state, "unlocked", true);
+        _network->publish(_haStateTopicId, "open", true);
+        _network->publish(_binaryStateTopicId, "unlocked", true);
         break;
     case NukiLock::LockState::Unlatching:
-        _nukiPublisher->publishString(mqtt_topic_lock_ha_state, "opening", true);
-        _nukiPublisher->publishString(mqtt_topic_lock_binary_state, "unlocked", true);
+        _network->publish(_haStateTopicId, "opening", true);
+        _network->publish(_binaryStateTopicId, "unlocked", true);
         break;
     case NukiLock::LockState::Uncalibrated:
     case NukiLock::LockState::Calibration:
     case NukiLock::LockState::BootRun:
     case NukiLock::LockState::MotorBlocked:
-        _nukiPublisher->publishString(mqtt_topic_lock_ha_state, "jammed", true);
+        _network->publish(_haStateTopicId, "jammed", true);
         break;
     default:
         break;
@@ -755,21 +722,18 @@ void NukiNetworkLock::publishAuthorizationInfo(const std::list<NukiLock::LogEntr
         if(log.index > _lastRollingLog)
         {
             _lastRollingLog = log.index;
-            serializeJson(entry, _buffer, _bufferSize);
-            _nukiPublisher->publishString(mqtt_topic_lock_log_rolling, _buffer, true);
+            _nukiPublisher->publishJson(mqtt_topic_lock_log_rolling, entry, true);
             _nukiPublisher->publishInt(mqtt_topic_lock_log_rolling_last, log.index, true);
         }
     }
 
-    serializeJson(json, _buffer, _bufferSize);
-
     if(latest)
     {
-        _nukiPublisher->publishString(mqtt_topic_lock_log_latest, _buffer, true);
+        _nukiPublisher->publishJson(mqtt_topic_lock_log_latest, json, true);
     }
     else
     {
-        _nukiPublisher->publishString(mqtt_topic_lock_log, _buffer, true);
+        _nukiPublisher->publishJson(mqtt_topic_lock_log, json, true);
     }
 
     if(authIndex > 0 || (_nukiOfficial->getOffConnected() && _nukiOfficial->hasAuthId()))
@@ -823,8 +787,7 @@ void NukiNetworkLock::publishBatteryReport(const NukiLock::BatteryReport& batter
     json["maxTurnCurrent"] = (float)batteryReport.maxTurnCurrent / 1000.0;
     json["batteryResistance"] = (float)batteryReport.batteryResistance / 1000.0;
 
-    serializeJson(json, _buffer, _bufferSize);
-    _nukiPublisher->publishString(mqtt_topic_battery_advanced_json, _buffer, true);
+    _nukiPublisher->publishJson(mqtt_topic_battery_advanced_json, json, true);
 }
 
 void NukiNetworkLock::publishConfig(const NukiLock::Config &config)
@@ -882,8 +845,7 @@ void NukiNetworkLock::publishConfig(const NukiLock::Config &config)
     json["matterStatus"] = (config.matterStatus == 255 ? 0 : config.matterStatus);
     json["productVariant"] = (config.productVariant == 255 ? 0 : config.productVariant);
 
-    serializeJson(json, _buffer, _bufferSize);
-    _nukiPublisher->publishString(mqtt_topic_config_basic_json, _buffer, true);
+    _nukiPublisher->publishJson(mqtt_topic_config_basic_json, json, true);
 
     if(!_disableNonJSON)
     {
@@ -949,8 +911,7 @@ void NukiNetworkLock::publishAdvancedConfig(const NukiLock::AdvancedConfig &conf
     }
     json["rebootNuki"] = 0;
 
-    serializeJson(json, _buffer, _bufferSize);
-    _nukiPublisher->publishString(mqtt_topic_config_advanced_json, _buffer, true);
+    _nukiPublisher->publishJson(mqtt_topic_config_advanced_json, json, true);
 
     if(!_disableNonJSON)
     {
@@ -983,14 +944,32 @@ void NukiNetworkLock::publishKeypad(const std::list<NukiLock::KeypadEntry>& entr
     itoa(_preferences->getUInt(preference_nuki_id_lock, 0), uidString, 16);
     String baseTopic = _preferences->getString(preference_mqtt_lock_path);
     baseTopic.concat("/lock");
+
+    _keypadSnapshot.begin((_mqttReconnects << 3) | (publishCode << 2) | (topicPerEntry << 1) | _disableNonJSON);
+    for(const auto& entry : entries)
+    {
+        _keypadSnapshot.add(entry.codeId, index++, &entry, sizeof(entry));
+    }
+
+    if(!_keypadSnapshot.changed())
+    {
+        return;
+    }
+
+    index = 0;
     JsonDocument json;
 
     for(const auto& entry : entries)
     {
+        bool entryChanged = _keypadSnapshot.changed(entry.codeId);
         String basePath = mqtt_topic_keypad;
         basePath.concat("/code_");
         basePath.concat(std::to_string(index).c_str());
-        publishKeypadEntry(basePath, entry);
+
+        if(entryChanged)
+        {
+            publishKeypadEntry(basePath, entry);
+        }
 
         auto jsonEntry = json.add<JsonVariant>();
 
@@ -1081,55 +1060,59 @@ void NukiNetworkLock::publishKeypad(const std::list<NukiLock::KeypadEntry>& entr
             basePath.concat(std::to_string(index).c_str());
             jsonEntry["name_ha"] = entry.name;
             jsonEntry["index"] = index;
-            serializeJson(jsonEntry, _buffer, _bufferSize);
-            _nukiPublisher->publishString(basePath.c_str(), _buffer, true);
-
-            String basePathPrefix = "~";
-            basePathPrefix.concat(basePath);
-            const char *basePathPrefixChr = basePathPrefix.c_str();
-
-            std::string baseCommand = std::string("{ \"action\": \"update\", \"codeId\": \"") + std::to_string(entry.codeId);
-            std::string enaCommand = baseCommand + (char*)"\", \"enabled\": \"1\" }";
-            std::string disCommand = baseCommand + (char*)"\", \"enabled\": \"0\" }";
-            std::string mqttDeviceName = std::string("keypad_") + std::to_string(index);
-            std::string uidStringPostfix = std::string("_") + mqttDeviceName;
-            char codeName[33];
-            memcpy(codeName, entry.name, sizeof(entry.name));
-            codeName[sizeof(entry.name)] = '\0';
-            std::string displayName = std::string("Keypad - ") + std::string((char*)codeName) + " - " + std::to_string(entry.codeId);
-
-            _network->publishHassTopic("switch",
-                                       mqttDeviceName.c_str(),
-                                       uidString,
-                                       uidStringPostfix.c_str(),
-                                       displayName.c_str(),
-                                       _nukiName,
-                                       baseTopic.c_str(),
-                                       String("~") + basePath.c_str(),
-                                       (char*)"SmartLock",
-                                       "",
-                                       "",
-                                       "diagnostic",
-                                       String("~") + mqtt_topic_keypad_json_action,
+
+            if(entryChanged)
             {
-                { (char*)"json_attr_t", (char*)basePathPrefixChr },
-                { (char*)"pl_on", (char*)enaCommand.c_str() },
-                { (char*)"pl_off", (char*)disCommand.c_str() },
-                { (char*)"val_tpl", (char*)"{{value_json.enabled}}" },
-                { (char*)"stat_on", (char*)"1" },
-                { (char*)"stat_off", (char*)"0" }
-            });
+                _nukiPublisher->publishJson(basePath.c_str(), jsonEntry, true);
+
+                String basePathPrefix = "~";
+                basePathPrefix.concat(basePath);
+                const char *basePathPrefixChr = basePathPrefix.c_str();
+
+                std::string baseCommand = std::string("{ \"action\": \"update\", \"codeId\": \"") + std::to_string(entry.codeId);
+                std::string enaCommand = baseCommand + (char*)"\", \"enabled\": \"1\" }";
+                std::string disCommand = baseCommand + (char*)"\", \"enabled\": \"0\" }";
+                std::string mqttDeviceName = std::string("keypad_") + std::to_string(index);
+                std::string uidStringPostfix = std::string("_") + mqttDeviceName;
+                char codeName[33];
+                memcpy(codeName, entry.name, sizeof(entry.name));
+                codeName[sizeof(entry.name)] = '\0';
+                std::string displayName = std::string("Keypad - ") + std::string((char*)codeName) + " - " + std::to_string(entry.codeId);
+
+                _network->publishHassTopic("switch",
+                                           mqttDeviceName.c_str(),
+                                           uidString,
+                                           uidStringPostfix.c_str(),
+                                           displayName.c_str(),
+                                           _nukiName,
+                                           baseTopic.c_str(),
+                                           String("~") + basePath.c_str(),
+                                           (char*)"SmartLock",
+                                           "",
+                                           "",
+                                           "diagnostic",
+                                           String("~") + mqtt_topic_keypad_json_action,
+                {
+                    { (char*)"json_attr_t", (char*)basePathPrefixChr },
+                    { (char*)"pl_on", (char*)enaCommand.c_str() },
+                    { (char*)"pl_off", (char*)disCommand.c_str() },
+                    { (char*)"val_tpl", (char*)"{{value_json.enabled}}" },
+                    { (char*)"stat_on", (char*)"1" },
+                    { (char*)"stat_off", (char*)"0" }
+                });
+            }
         }
 
         ++index;
     }
 
-    serializeJson(json, _buffer, _bufferSize);
-    _nukiPublisher->publishString(mqtt_topic_keypad_json, _buffer, true);
+    _nukiPublisher->publishJson(mqtt_topic_keypad_json, json, true);
+
+    uint previousCount = _keypadSnapshot.previousCount(maxKeypadCodeCount);
 
     if(!_disableNonJSON)
     {
-        while(index < maxKeypadCodeCount)
+        while(index < previousCount)
         {
             NukiLock::KeypadEntry entry;
             memset(&entry, 0, sizeof(entry));
@@ -1141,7 +1124,7 @@ void NukiNetworkLock::publishKeypad(const std::list<NukiLock::KeypadEntry>& entr
             ++index;
         }
 
-        if(!publishCode)
+        if(!publishCode && !_keypadSnapshot.valid())
         {
             for(int i=0; i<maxKeypadCodeCount; i++)
             {
@@ -1179,19 +1162,19 @@ void NukiNetworkLock::publishKeypad(const std::list<NukiLock::KeypadEntry>& entr
                 _network->removeTopic(codeTopic, "lockCount");
             }
         }
+    }
 
-        for(int j=entries.size(); j<maxKeypadCodeCount; j++)
-        {
-            String codesTopic = _mqttPath;
-            codesTopic.concat(mqtt_topic_keypad_codes);
-            codesTopic.concat("/");
-            String codeTopic = "code_";
-            codeTopic.concat(std::to_string(j).c_str());
-            _network->removeTopic(codesTopic, codeTopic);
-            std::string mqttDeviceName = std::string("keypad_") + std::to_string(j);
-            _network->removeHassTopic((char*)"switch", (char*)mqttDeviceName.c_str(), uidString);
-        }
+    for(int j=entries.size(); j<previousCount; j++)
+    {
+        String codesTopic = _mqttPath;
+        codesTopic.concat(mqtt_topic_keypad_codes);
+        codesTopic.concat("/");
+        _network->removeTopic(codesTopic, (char*)std::to_string(j).c_str());
+        std::string mqttDeviceName = std::string("keypad_") + std::to_string(j);
+        _network->removeHassTopic((char*)"switch", (char*)mqttDeviceName.c_str(), uidString);
     }
+
+    _keypadSnapshot.end();
 }
 
 void NukiNetworkLock::publishKeypadEntry(const String topic, NukiLock::KeypadEntry entry)
@@ -1232,10 +1215,24 @@ void NukiNetworkLock::publishTimeControl(const std::list<NukiLock::TimeControlEn
     itoa(_preferences->getUInt(preference_nuki_id_lock, 0), uidString, 16);
     String baseTopic = _preferences->getString(preference_mqtt_lock_path);
     baseTopic.concat("/lock");
+
+    _timeControlSnapshot.begin((_mqttReconnects << 1) | topicPerEntry);
+    for(const auto& entry : timeControlEntries)
+    {
+        _timeControlSnapshot.add(entry.entryId, index++, &entry, sizeof(entry));
+    }
+
+    if(!_timeControlSnapshot.changed())
+    {
+        return;
+    }
+
+    index = 0;
     JsonDocument json;
 
     for(const auto& entry : timeControlEntries)
     {
+        bool entryChanged = _timeControlSnapshot.changed(entry.entryId);
         auto jsonEntry = json.add<JsonVariant>();
 
         jsonEntry["entryId"] = entry.entryId;
@@ -1303,50 +1300,52 @@ void NukiNetworkLock::publishTimeControl(const std::list<NukiLock::TimeControlEn
             basePath.concat("/entries/");
             basePath.concat(std::to_string(index).c_str());
             jsonEntry["index"] = index;
-            serializeJson(jsonEntry, _buffer, _bufferSize);
-            _nukiPublisher->publishString(basePath.c_str(), _buffer, true);
-
-            String basePathPrefix = "~";
-            basePathPrefix.concat(basePath);
-            const char *basePathPrefixChr = basePathPrefix.c_str();
-
-            std::string baseCommand = std::string("{ \"action\": \"update\", \"entryId\": \"") + std::to_string(entry.entryId);
-            std::string enaCommand = baseCommand + (char*)"\", \"enabled\": \"1\" }";
-            std::string disCommand = baseCommand + (char*)"\", \"enabled\": \"0\" }";
-            std::string mqttDeviceName = std::string("timecontrol_") + std::to_string(index);
-            std::string uidStringPostfix = std::string("_") + mqttDeviceName;
-            std::string displayName = std::string("Timecontrol - ") + std::to_string(entry.entryId);
-
-            _network->publishHassTopic("switch",
-                                       mqttDeviceName.c_str(),
-                                       uidString,
-                                       uidStringPostfix.c_str(),
-                                       displayName.c_str(),
-                                       _nukiName,
-                                       baseTopic.c_str(),
-                                       String("~") + basePath.c_str(),
-                                       (char*)"SmartLock",
-                                       "",
-                                       "",
-                                       "diagnostic",
-                                       String("~") + mqtt_topic_timecontrol_action,
+
+            if(entryChanged)
             {
-                { (char*)"json_attr_t", (char*)basePathPrefixChr },
-                { (char*)"pl_on", (char*)enaCommand.c_str() },
-                { (char*)"pl_off", (char*)disCommand.c_str() },
-                { (char*)"val_tpl", (char*)"{{value_json.enabled}}" },
-                { (char*)"stat_on", (char*)"1" },
-                { (char*)"stat_off", (char*)"0" }
-            });
+                _nukiPublisher->publishJson(basePath.c_str(), jsonEntry, true);
+
+                String basePathPrefix = "~";
+                basePathPrefix.concat(basePath);
+                const char *basePathPrefixChr = basePathPrefix.c_str();
+
+                std::string baseCommand = std::string("{ \"action\": \"update\", \"entryId\": \"") + std::to_string(entry.entryId);
+                std::string enaCommand = baseCommand + (char*)"\", \"enabled\": \"1\" }";
+                std::string disCommand = baseCommand + (char*)"\", \"enabled\": \"0\" }";
+                std::string mqttDeviceName = std::string("timecontrol_") + std::to_string(index);
+                std::string uidStringPostfix = std::string("_") + mqttDeviceName;
+                std::string displayName = std::string("Timecontrol - ") + std::to_string(entry.entryId);
+
+                _network->publishHassTopic("switch",
+                                           mqttDeviceName.c_str(),
+                                           uidString,
+                                           uidStringPostfix.c_str(),
+                                           displayName.c_str(),
+                                           _nukiName,
+                                           baseTopic.c_str(),
+                                           String("~") + basePath.c_str(),
+                                           (char*)"SmartLock",
+                                           "",
+                                           "",
+                                           "diagnostic",
+                                           String("~") + mqtt_topic_timecontrol_action,
+                {
+                    { (char*)"json_attr_t", (char*)basePathPrefixChr },
+                    { (char*)"pl_on", (char*)enaCommand.c_str() },
+                    { (char*)"pl_off", (char*)disCommand.c_str() },
+                    { (char*)"val_tpl", (char*)"{{value_json.enabled}}" },
+                    { (char*)"stat_on", (char*)"1" },
+                    { (char*)"stat_off", (char*)"0" }
+                });
+            }
         }
 
         ++index;
     }
 
-    serializeJson(json, _buffer, _bufferSize);
-    _nukiPublisher->publishString(mqtt_topic_timecontrol_json, _buffer, true);
+    _nukiPublisher->publishJson(mqtt_topic_timecontrol_json, json, true);
 
-    for(int j=timeControlEntries.size(); j<maxTimeControlEntryCount; j++)
+    for(int j=timeControlEntries.size(); j<_timeControlSnapshot.previousCount(maxTimeControlEntryCount); j++)
     {
         String entriesTopic = _mqttPath;
         entriesTopic.concat(mqtt_topic_timecontrol_entries);
@@ -1355,20 +1354,37 @@ void NukiNetworkLock::publishTimeControl(const std::list<NukiLock::TimeControlEn
         std::string mqttDeviceName = std::string("timecontrol_") + std::to_string(j);
         _network->removeHassTopic((char*)"switch", (char*)mqttDeviceName.c_str(), uidString);
     }
+
+    _timeControlSnapshot.end();
 }
 
 void NukiNetworkLock::publishAuth(const std::list<NukiLock::AuthorizationEntry>& authEntries, uint maxAuthEntryCount)
 {
+    bool topicPerEntry = _preferences->getBool(preference_auth_topic_per_entry, false);
     uint index = 0;
     char str[50];
     char uidString[20];
     itoa(_preferences->getUInt(preference_nuki_id_lock, 0), uidString, 16);
     String baseTopic = _preferences->getString(preference_mqtt_lock_path);
     baseTopic.concat("/lock");
+
+    _authSnapshot.begin((_mqttReconnects << 1) | topicPerEntry);
+    for(const auto& entry : authEntries)
+    {
+        _authSnapshot.add(entry.authId, index++, &entry, sizeof(entry));
+    }
+
+    if(!_authSnapshot.changed())
+    {
+        return;
+    }
+
+    index = 0;
     JsonDocument json;
 
     for(const auto& entry : authEntries)
     {
+        bool entryChanged = _authSnapshot.changed(entry.authId);
         auto jsonEntry = json.add<JsonVariant>();
 
         jsonEntry["authId"] = entry.authId;
@@ -1448,56 +1464,58 @@ void NukiNetworkLock::publishAuth(const std::list<NukiLock::AuthorizationEntry>&
         sprintf(allowedUntilTimeT, "%02d:%02d", entry.allowedUntilTimeHour, entry.allowedUntilTimeMin);
         jsonEntry["allowedUntilTime"] = allowedUntilTimeT;
 
-        if(_preferences->getBool(preference_auth_topic_per_entry, false))
+        if(topicPerEntry)
         {
             String basePath = mqtt_topic_auth;
             basePath.concat("/entries/");
             basePath.concat(std::to_string(index).c_str());
             jsonEntry["index"] = index;
-            serializeJson(jsonEntry, _buffer, _bufferSize);
-            _nukiPublisher->publishString(basePath.c_str(), _buffer, true);
-
-            String basePathPrefix = "~";
-            basePathPrefix.concat(basePath);
-            const char *basePathPrefixChr = basePathPrefix.c_str();
-
-            std::string baseCommand = std::string("{ \"action\": \"update\", \"authId\": \"") + std::to_string(entry.authId);
-            std::string enaCommand = baseCommand + (char*)"\", \"enabled\": \"1\" }";
-            std::string disCommand = baseCommand + (char*)"\", \"enabled\": \"0\" }";
-            std::string mqttDeviceName = std::string("auth_") + std::to_string(index);
-            std::string uidStringPostfix = std::string("_") + mqttDeviceName;
-            std::string displayName = std::string("Authorization - ") + std::to_string(entry.authId);
-
-            _network->publishHassTopic("switch",
-                                       mqttDeviceName.c_str(),
-                                       uidString,
-                                       uidStringPostfix.c_str(),
-                                       displayName.c_str(),
-                                       _nukiName,
-                                       baseTopic.c_str(),
-                                       String("~") + basePath.c_str(),
-                                       (char*)"SmartLock",
-                                       "",
-                                       "",
-                                       "diagnostic",
-                                       String("~") + mqtt_topic_auth_action,
+
+            if(entryChanged)
             {
-                { (char*)"json_attr_t", (char*)basePathPrefixChr },
-                { (char*)"pl_on", (char*)enaCommand.c_str() },
-                { (char*)"pl_off", (char*)disCommand.c_str() },
-                { (char*)"val_tpl", (char*)"{{value_json.enabled}}" },
-                { (char*)"stat_on", (char*)"1" },
-                { (char*)"stat_off", (char*)"0" }
-            });
+                _nukiPublisher->publishJson(basePath.c_str(), jsonEntry, true);
+
+                String basePathPrefix = "~";
+                basePathPrefix.concat(basePath);
+                const char *basePathPrefixChr = basePathPrefix.c_str();
+
+                std::string baseCommand = std::string("{ \"action\": \"update\", \"authId\": \"") + std::to_string(entry.authId);
+                std::string enaCommand = baseCommand + (char*)"\", \"enabled\": \"1\" }";
+                std::string disCommand = baseCommand + (char*)"\", \"enabled\": \"0\" }";
+                std::string mqttDeviceName = std::string("auth_") + std::to_string(index);
+                std::string uidStringPostfix = std::string("_") + mqttDeviceName;
+                std::string displayName = std::string("Authorization - ") + std::to_string(entry.authId);
+
+                _network->publishHassTopic("switch",
+                                           mqttDeviceName.c_str(),
+                                           uidString,
+                                           uidStringPostfix.c_str(),
+                                           displayName.c_str(),
+                                           _nukiName,
+                                           baseTopic.c_str(),
+                                           String("~") + basePath.c_str(),
+                                           (char*)"SmartLock",
+                                           "",
+                                           "",
+                                           "diagnostic",
+                                           String("~") + mqtt_topic_auth_action,
+                {
+                    { (char*)"json_attr_t", (char*)basePathPrefixChr },
+                    { (char*)"pl_on", (char*)enaCommand.c_str() },
+                    { (char*)"pl_off", (char*)disCommand.c_str() },
+                    { (char*)"val_tpl", (char*)"{{value_json.enabled}}" },
+                    { (char*)"stat_on", (char*)"1" },
+                    { (char*)"stat_off", (char*)"0" }
+                });
+            }
         }
 
         ++index;
     }
 
-    serializeJson(json, _buffer, _bufferSize);
-    _nukiPublisher->publishString(mqtt_topic_auth_json, _buffer, true);
+    _nukiPublisher->publishJson(mqtt_topic_auth_json, json, true);
 
-    for(int j=authEntries.size(); j<maxAuthEntryCount; j++)
+    for(int j=authEntries.size(); j<_authSnapshot.previousCount(maxAuthEntryCount); j++)
     {
         String entriesTopic = _mqttPath;
         entriesTopic.concat(mqtt_topic_auth_entries);
@@ -1506,6 +1524,8 @@ void NukiNetworkLock::publishAuth(const std::list<NukiLock::AuthorizationEntry>&
         std::string mqttDeviceName = std::string("auth_") + std::to_string(j);
         _network->removeHassTopic((char*)"switch", (char*)mqttDeviceName.c_str(), uidString);
     }
+
+    _authSnapshot.end();
 }
 
 void NukiNetworkLock::publishConfigCommandResult(const char* result)
@@ -1581,39 +1601,6 @@ void NukiNetworkLock::setAuthCommandReceivedCallback(void (*authCommandReceivedR
     _authCommandReceivedReceivedCallback = authCommandReceivedReceivedCallback;
 }
 
-void NukiNetworkLock::buildMqttPath(const char* path, char* outPath)
-{
-    int offset = 0;
-    char inPath[181] = {0};
-
-    memcpy(inPath, _mqttPath, sizeof(_mqttPath));
-
-    for(const char& c : inPath)
-    {
-        if(c == 0x00)
-        {
-            break;
-        }
-        outPath[offset] = c;
-        ++offset;
-    }
-    int i=0;
-    while(outPath[i] != 0x00)
-    {
-        outPath[offset] = path[i];
-        ++i;
-        ++offset;
-    }
-    outPath[i+1] = 0x00;
-}
-
-bool NukiNetworkLock::comparePrefixedPath(const char *fullPath, const char *subPath)
-{
-    char prefixedPath[500];
-    buildMqttPath(subPath, prefixedPath);
-    return strcmp(fullPath, prefixedPath) == 0;
-}
-
 void NukiNetworkLock::publishOffAction(const int value)
 {
     _network->publishInt(_nukiOfficial->getMqttPath(), mqtt_topic_official_lock_action, value, false);
@@ -4,8 +4,9 @@
 #ifndef CONFIG_IDF_TARGET_ESP32H2
 #include "networkDevices/WifiDevice.h"
 #endif
-#include <Preferences.h>
+#include "CachedPreferences.h"
 #include <vector>
+#include <atomic>
 #include <list>
 #include "NukiConstants.h"
 #include "NukiLockConstants.h"
@@ -15,11 +16,12 @@
 #include "NukiOfficial.h"
 #include "NukiPublisher.h"
 #include "EspMillis.h"
+#include "NukiEntrySnapshot.h"
 
-class NukiNetworkLock : public MqttReceiver
+class NukiNetworkLock
 {
 public:
-    explicit NukiNetworkLock(NukiNetwork* network, NukiOfficial* nukiOfficial, Preferences* preferences, char* buffer, size_t bufferSize);
+    explicit NukiNetworkLock(NukiNetwork* network, NukiOfficial* nukiOfficial, CachedPreferences* preferences);
     virtual ~NukiNetworkLock();
 
     void initialize();
@@ -55,7 +57,6 @@ public:
     void setKeypadJsonCommandReceivedCallback(void (*keypadJsonCommandReceivedReceivedCallback)(const char* value));
     void setTimeControlCommandReceivedCallback(void (*timeControlCommandReceivedReceivedCallback)(const char* value));
     void setAuthCommandReceivedCallback(void (*authCommandReceivedReceivedCallback)(const char* value));
-    void onMqttDataReceived(const char* topic, byte* payload, const unsigned int length) override;
     void setupHASS(int type, uint32_t nukiId, char* nukiName, const char* firmwareVersion, const char* hardwareVersion, bool hasDoorSensor, bool hasKeypad);
 
     const uint32_t getAuthId() const;
@@ -64,7 +65,12 @@ public:
     uint8_t queryCommands();
 
 private:
-    bool comparePrefixedPath(const char* fullPath, const char* subPath);
+    void subscribe(const char* path, std::function<void(const char* data)> handler);
+    void onRollingLogReceived(const char* data);
+    void onLockActionReceived(const char* data);
+    void onKeypadCommandActionReceived(const char* data);
+    void onQueryReceived(const char* topic, const uint8_t queryCommand, const char* data);
+    void onJsonCommandReceived(const char* topic, void (*callback)(const char* value), const char* data);
 
     void publishKeypadEntry(const String topic, NukiLock::KeypadEntry entry);
     void buttonPressActionToString(const NukiLock::ButtonPressAction btnPressAction, char* str);
@@ -76,15 +82,20 @@ private:
 
     String concat(String a, String b);
 
-    void buildMqttPath(const char* path, char* outPath);
-
     NukiNetwork* _network = nullptr;
     NukiPublisher* _nukiPublisher = nullptr;
     NukiOfficial* _nukiOfficial = nullptr;
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
 
     std::map<uint32_t, String> _authEntries;
+    NukiEntrySnapshot _keypadSnapshot;
+    NukiEntrySnapshot _timeControlSnapshot;
+    NukiEntrySnapshot _authSnapshot;
+    std::atomic<uint32_t> _mqttReconnects{0};
     char _mqttPath[181] = {0};
+    uint16_t _lockStateTopicId = MQTT_TOPIC_ID_INVALID;
+    uint16_t _haStateTopicId = MQTT_TOPIC_ID_INVALID;
+    uint16_t _binaryStateTopicId = MQTT_TOPIC_ID_INVALID;
 
     bool _firstTunerStatePublish = true;
     bool _haEnabled = false;
@@ -106,9 +117,6 @@ private:
     char _nukiName[33];
     char _authName[33];
 
-    char* _buffer;
-    size_t _bufferSize;
-
     LockActionResult (*_lockActionReceivedCallback)(const char* value) = nullptr;
     void (*_configUpdateReceivedCallback)(const char* value) = nullptr;
     void (*_keypadCommandReceivedReceivedCallback)(const char* command, const uint& id, const String& name, const String& code, const int& enabled) = nullptr;
@@ -1,17 +1,19 @@
 #pragma once
 
 #include "networkDevices/NetworkDevice.h"
-#include <Preferences.h>
+#include "CachedPreferences.h"
 #include <vector>
+#include <atomic>
 #include "NukiConstants.h"
 #include "NukiOpenerConstants.h"
 #include "NukiNetworkLock.h"
 #include "EspMillis.h"
+#include "NukiEntrySnapshot.h"
 
-class NukiNetworkOpener : public MqttReceiver
+class NukiNetworkOpener
 {
 public:
-    explicit NukiNetworkOpener(NukiNetwork* network, Preferences* preferences, char* buffer, size_t bufferSize);
+    explicit NukiNetworkOpener(NukiNetwork* network, CachedPreferences* preferences);
     virtual ~NukiNetworkOpener() = default;
 
     void initialize();
@@ -46,7 +48,6 @@ public:
     void setKeypadJsonCommandReceivedCallback(void (*keypadJsonCommandReceivedReceivedCallback)(const char* value));
     void setTimeControlCommandReceivedCallback(void (*timeControlCommandReceivedReceivedCallback)(const char* value));
     void setAuthCommandReceivedCallback(void (*authCommandReceivedReceivedCallback)(const char* value));
-    void onMqttDataReceived(const char* topic, byte* payload, const unsigned int length) override;
     void setupHASS(int type, uint32_t nukiId, char* nukiName, const char* firmwareVersion, const char* hardwareVersion, bool hasDoorSensor, bool hasKeypad);
 
     int mqttConnectionState();
@@ -54,12 +55,15 @@ public:
     char _nukiName[33];
 
 private:
-    bool comparePrefixedPath(const char* fullPath, const char* subPath);
+    void subscribe(const char* path, std::function<void(const char* data)> handler);
+    void onRollingLogReceived(const char* data);
+    void onLockActionReceived(const char* data);
+    void onKeypadCommandActionReceived(const char* data);
+    void onQueryReceived(const char* topic, const uint8_t queryCommand, const char* data);
+    void onJsonCommandReceived(const char* topic, void (*callback)(const char* value), const char* data);
 
     void publishKeypadEntry(const String topic, NukiLock::KeypadEntry entry);
 
-    void buildMqttPath(const char* path, char* outPath);
-    void subscribe(const char* path);
     void buttonPressActionToString(const NukiOpener::ButtonPressAction btnPressAction, char* str);
     void fobActionToString(const int fobact, char* str);
     void operatingModeToString(const int opmode, char* str);
@@ -69,13 +73,20 @@ private:
 
     String concat(String a, String b);
 
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
 
     NukiNetwork* _network = nullptr;
     NukiPublisher* _nukiPublisher = nullptr;
 
     std::map<uint32_t, String> _authEntries;
+    NukiEntrySnapshot _keypadSnapshot;
+    NukiEntrySnapshot _timeControlSnapshot;
+    NukiEntrySnapshot _authSnapshot;
+    std::atomic<uint32_t> _mqttReconnects{0};
     char _mqttPath[181] = {0};
+    uint16_t _lockStateTopicId = MQTT_TOPIC_ID_INVALID;
+    uint16_t _haStateTopicId = MQTT_TOPIC_ID_INVALID;
+    uint16_t _binaryStateTopicId = MQTT_TOPIC_ID_INVALID;
     bool _firstTunerStatePublish = true;
     bool _haEnabled = false;
     bool _disableNonJSON = false;
@@ -91,9 +102,6 @@ private:
     char _authName[33];
     uint32_t _lastRollingLog = 0;
 
-    char* _buffer;
-    const size_t _bufferSize;
-
     LockActionResult (*_lockActionReceivedCallback)(const char* value) = nullptr;
     void (*_configUpdateReceivedCallback)(const char* value) = nullptr;
     void (*_keypadCommandReceivedReceivedCallback)(const char* command, const uint& id, const String& name, const String& code, const int& enabled) = nullptr;
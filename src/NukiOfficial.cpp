@@ -6,7 +6,7 @@
 #include <stdlib.h>
 #include <ctype.h>
 
-NukiOfficial::NukiOfficial(Preferences *preferences)
+NukiOfficial::NukiOfficial(CachedPreferences *preferences)
 {
     offEnabled = preferences->getBool(preference_official_hybrid_enabled, false);
     _disableNonJSON = preferences->getBool(preference_disable_non_json, false);
@@ -72,13 +72,6 @@ void NukiOfficial::buildMqttPath(const char *path, char *outPath)
     outPath[i+1] = 0x00;
 }
 
-bool NukiOfficial::comparePrefixedPath(const char *fullPath, const char *subPath)
-{
-    char prefixedPath[500];
-    buildMqttPath(subPath, prefixedPath);
-    return strcmp(fullPath, prefixedPath) == 0;
-}
-
 void NukiOfficial::onOfficialUpdateReceived(const char *topic, const char *value)
 {
     char str[50];
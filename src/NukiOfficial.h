@@ -8,7 +8,7 @@
 class NukiOfficial
 {
 public:
-    explicit NukiOfficial(Preferences* preferences);
+    explicit NukiOfficial(CachedPreferences* preferences);
     void setPublisher(NukiPublisher* publisher);
 
     void setUid(const uint32_t& uid);
@@ -24,7 +24,6 @@ public:
     void clearAuthId();
 
     void buildMqttPath(const char* path, char* outPath);
-    bool comparePrefixedPath(const char *fullPath, const char *subPath);
 
     void onOfficialUpdateReceived(const char* topic, const char* value);
 
@@ -6,13 +6,16 @@
 #include <NukiOpenerUtils.h>
 #include "Config.h"
 #include "hal/wdt_hal.h"
+#include "esp_task_wdt.h"
 #include <time.h>
 #include "esp_sntp.h"
+#include "NukiTaskWakeup.h"
+#include "CharBuffer.h"
 
 NukiOpenerWrapper* nukiOpenerInst;
 Preferences* nukiOpenerPreferences = nullptr;
 
-NukiOpenerWrapper::NukiOpenerWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NukiNetworkOpener* network, Gpio* gpio, Preferences* preferences)
+NukiOpenerWrapper::NukiOpenerWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NukiNetworkOpener* network, Gpio* gpio, CachedPreferences* preferences)
     : _deviceName(deviceName),
       _deviceId(deviceId),
       _nukiOpener(deviceName, _deviceId->get()),
@@ -66,6 +69,37 @@ void NukiOpenerWrapper::initialize()
 
     _hassEnabled = _preferences->getBool(preference_mqtt_hass_enabled, false);
     readSettings();
+
+    _preferences->addChangeListener([this](const char* key)
+    {
+        if(isSettingsKey(key))
+        {
+            _settingsChanged = true;
+        }
+    });
+}
+
+bool NukiOpenerWrapper::isSettingsKey(const char* key)
+{
+    // Keys read by readSettings(), the max entry counts are runtime state written by the wrapper itself
+    static const char* const settingsKeys[] =
+    {
+        preference_ble_tx_power, preference_query_interval_lockstate, preference_query_interval_configuration,
+        preference_query_interval_battery, preference_query_interval_keypad, preference_keypad_info_enabled, preference_publish_authdata,
+        preference_restart_ble_beacon_lost, preference_command_nr_of_retries, preference_command_retry_delay, preference_rssi_publish_interval,
+        preference_disable_non_json, preference_keypad_check_code_enabled,
+        preference_register_opener_as_app, preference_opener_force_keypad, preference_opener_force_id, preference_conf_opener_basic_acl,
+        preference_conf_opener_advanced_acl
+    };
+
+    for(const char* settingsKey : settingsKeys)
+    {
+        if(strcmp(key, settingsKey) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 void NukiOpenerWrapper::readSettings()
@@ -193,6 +227,12 @@ void NukiOpenerWrapper::update()
     wdt_hal_write_protect_disable(&rtc_wdt_ctx);
     wdt_hal_feed(&rtc_wdt_ctx);
     wdt_hal_write_protect_enable(&rtc_wdt_ctx);
+
+    if(_settingsChanged.exchange(false))
+    {
+        readSettings();
+    }
+
     if(!_paired)
     {
         Log->println(("Nuki opener start pairing"));
@@ -234,61 +274,7 @@ void NukiOpenerWrapper::update()
 
     _nukiOpener.updateConnectionState();
 
-    if(_nextLockAction != (NukiOpener::LockAction)0xff)
-    {
-        int retryCount = 0;
-        Nuki::CmdResult cmdResult = (Nuki::CmdResult)-1;
-
-        while(retryCount < _nrOfRetries + 1 && cmdResult != Nuki::CmdResult::Success)
-        {
-            cmdResult = _nukiOpener.lockAction(_nextLockAction, 0, 0);
-            char resultStr[15] = {0};
-            NukiOpener::cmdResultToString(cmdResult, resultStr);
-
-            _network->publishCommandResult(resultStr);
-
-            Log->print(("Opener action result: "));
-            Log->println(resultStr);
-
-            if(cmdResult != Nuki::CmdResult::Success)
-            {
-                Log->print(("Opener: Last command failed, retrying after "));
-                Log->print(_retryDelay);
-                Log->print((" milliseconds. Retry "));
-                Log->print(retryCount + 1);
-                Log->print(" of ");
-                Log->println(_nrOfRetries);
-
-                _network->publishRetry(std::to_string(retryCount + 1));
-
-                delay(_retryDelay);
-
-                ++retryCount;
-            }
-            postponeBleWatchdog();
-        }
-
-        if(cmdResult == Nuki::CmdResult::Success)
-        {
-            _nextLockAction = (NukiOpener::LockAction) 0xff;
-            _network->publishRetry("--");
-            retryCount = 0;
-            _statusUpdated = true;
-            Log->println(("Opener: updating status after action"));
-            _statusUpdatedTs = ts;
-            if(_intervalLockstate > 10)
-            {
-                _nextLockStateUpdateTs = ts + 10 * 1000;
-            }
-        }
-        else
-        {
-            Log->println(("Opener: Maximum number of retries exceeded, aborting."));
-            _network->publishRetry("failed");
-            retryCount = 0;
-            _nextLockAction = (NukiOpener::LockAction) 0xff;
-        }
-    }
+    processCommandQueue();
     if(_statusUpdated || _nextLockStateUpdateTs == 0 || ts >= _nextLockStateUpdateTs || (queryCommands & QUERY_COMMAND_LOCKSTATE) > 0)
     {
         _statusUpdated = updateKeyTurnerState();
@@ -371,42 +357,196 @@ void NukiOpenerWrapper::update()
     memcpy(&_lastKeyTurnerState, &_keyTurnerState, sizeof(NukiOpener::OpenerState));
 }
 
+void NukiOpenerWrapper::processCommandQueue()
+{
+    NukiCommand command;
+
+    while(_commandQueue.pop(command))
+    {
+        Log->print("Opener: Executing queued command, queued for ");
+        Log->print(espMillis() - command.enqueuedTs);
+        Log->println(" ms");
+
+        switch(command.type)
+        {
+        case NukiCommandType::LockAction:
+            executeLockAction((NukiOpener::LockAction)command.lockAction);
+            break;
+        case NukiCommandType::ConfigUpdate:
+            onConfigUpdateReceived(command.payload);
+            break;
+        case NukiCommandType::Keypad:
+            executeKeypadCommand(command.payload);
+            break;
+        case NukiCommandType::KeypadJson:
+            onKeypadJsonCommandReceived(command.payload);
+            break;
+        case NukiCommandType::TimeControl:
+            onTimeControlCommandReceived(command.payload);
+            break;
+        case NukiCommandType::Auth:
+            onAuthCommandReceived(command.payload);
+            break;
+        }
+
+        command.freePayload();
+    }
+}
+
+void NukiOpenerWrapper::executeLockAction(const NukiOpener::LockAction action)
+{
+    int64_t ts = espMillis();
+    int retryCount = 0;
+    Nuki::CmdResult cmdResult = (Nuki::CmdResult)-1;
+
+    while(retryCount < _nrOfRetries + 1 && cmdResult != Nuki::CmdResult::Success)
+    {
+        cmdResult = _nukiOpener.lockAction(action, 0, 0);
+        char resultStr[15] = {0};
+        NukiOpener::cmdResultToString(cmdResult, resultStr);
+
+        _network->publishCommandResult(resultStr);
+
+        Log->print(("Opener action result: "));
+        Log->println(resultStr);
+
+        if(cmdResult != Nuki::CmdResult::Success)
+        {
+            Log->print(("Opener: Last command failed, retrying after "));
+            Log->print(_retryDelay);
+            Log->print((" milliseconds. Retry "));
+            Log->print(retryCount + 1);
+            Log->print(" of ");
+            Log->println(_nrOfRetries);
+
+            _network->publishRetry(std::to_string(retryCount + 1));
+
+            delay(_retryDelay);
+
+            ++retryCount;
+        }
+        postponeBleWatchdog();
+    }
+
+    if(cmdResult == Nuki::CmdResult::Success)
+    {
+        _network->publishRetry("--");
+        _statusUpdated = true;
+        Log->println(("Opener: updating status after action"));
+        _statusUpdatedTs = ts;
+        if(_intervalLockstate > 10)
+        {
+            _nextLockStateUpdateTs = ts + 10 * 1000;
+        }
+    }
+    else
+    {
+        Log->println(("Opener: Maximum number of retries exceeded, aborting."));
+        _network->publishRetry("failed");
+    }
+}
+
+bool NukiOpenerWrapper::queueLockAction(const NukiOpener::LockAction action)
+{
+    if(!_commandQueue.pushLockAction((uint8_t)action))
+    {
+        return false;
+    }
+    wakeNukiTask();
+    return true;
+}
+
+uint32_t NukiOpenerWrapper::commandsDropped() const
+{
+    return _commandQueue.droppedCount();
+}
+
+bool NukiOpenerWrapper::queueCommand(const NukiCommandType type, const char* value)
+{
+    if(!_commandQueue.pushPayload(type, value))
+    {
+        Log->println("Opener: Command queue full, dropping command");
+        return false;
+    }
+    wakeNukiTask();
+    return true;
+}
+
+int64_t NukiOpenerWrapper::nextUpdateTs()
+{
+    int64_t ts = espMillis();
+
+    if(!_paired || !_commandQueue.empty() || _statusUpdated || _nextLockStateUpdateTs == 0)
+    {
+        return ts;
+    }
+
+    int64_t nextTs = _nextLockStateUpdateTs;
+
+    if(_network->mqttConnectionState() == 2)
+    {
+        if(_nextBatteryReportTs == 0 || _nextConfigUpdateTs == 0 || _clearAuthData ||
+                (_hassEnabled && _nukiConfigValid && _nukiAdvancedConfigValid && !_hassSetupCompleted))
+        {
+            return ts;
+        }
+
+        mergeDeadline(nextTs, _nextBatteryReportTs);
+        mergeDeadline(nextTs, _nextConfigUpdateTs);
+        mergeDeadline(nextTs, _waitAuthLogUpdateTs);
+        mergeDeadline(nextTs, _waitKeypadUpdateTs);
+        mergeDeadline(nextTs, _waitTimeControlUpdateTs);
+        mergeDeadline(nextTs, _waitAuthUpdateTs);
+
+        if(_rssiPublishInterval > 0)
+        {
+            mergeDeadline(nextTs, _nextRssiTs > 0 ? _nextRssiTs : ts);
+        }
+        if(hasKeypad() && _keypadEnabled)
+        {
+            mergeDeadline(nextTs, _nextKeypadUpdateTs > 0 ? _nextKeypadUpdateTs : ts);
+        }
+    }
+
+    return nextTs;
+}
+
 
 void NukiOpenerWrapper::electricStrikeActuation()
 {
-    _nextLockAction = NukiOpener::LockAction::ElectricStrikeActuation;
+    queueLockAction(NukiOpener::LockAction::ElectricStrikeActuation);
 }
 
 void NukiOpenerWrapper::activateRTO()
 {
-    _nextLockAction = NukiOpener::LockAction::ActivateRTO;
+    queueLockAction(NukiOpener::LockAction::ActivateRTO);
 }
 
 void NukiOpenerWrapper::activateCM()
 {
-    _nextLockAction = NukiOpener::LockAction::ActivateCM;
+    queueLockAction(NukiOpener::LockAction::ActivateCM);
 }
 
 void NukiOpenerWrapper::deactivateRtoCm()
 {
     if(_keyTurnerState.nukiState == NukiOpener::State::ContinuousMode)
     {
-        _nextLockAction = NukiOpener::LockAction::DeactivateCM;
+        queueLockAction(NukiOpener::LockAction::DeactivateCM);
     }
     else if(_keyTurnerState.lockState == NukiOpener::LockState::RTOactive)
     {
-        _nextLockAction = NukiOpener::LockAction::DeactivateRTO;
+        queueLockAction(NukiOpener::LockAction::DeactivateRTO);
     }
 }
 
 void NukiOpenerWrapper::deactivateRTO()
 {
-    _nextLockAction = NukiOpener::LockAction::DeactivateRTO;
+    queueLockAction(NukiOpener::LockAction::DeactivateRTO);
 }
 
 void NukiOpenerWrapper::deactivateCM()
 {
-    _nextLockAction = NukiOpener::LockAction::DeactivateCM;
+    queueLockAction(NukiOpener::LockAction::DeactivateCM);
 }
 
 bool NukiOpenerWrapper::isPinSet()
@@ -1087,7 +1227,10 @@ LockActionResult NukiOpenerWrapper::onLockActionReceivedCallback(const char *val
     if((action == NukiOpener::LockAction::ActivateRTO && (int)aclPrefs[9] == 1) || (action == NukiOpener::LockAction::DeactivateRTO && (int)aclPrefs[10] == 1) || (action == NukiOpener::LockAction::ElectricStrikeActuation && (int)aclPrefs[11] == 1) || (action == NukiOpener::LockAction::ActivateCM && (int)aclPrefs[12] == 1) || (action == NukiOpener::LockAction::DeactivateCM && (int)aclPrefs[13] == 1) || (action == NukiOpener::LockAction::FobAction1 && (int)aclPrefs[14] == 1) || (action == NukiOpener::LockAction::FobAction2 && (int)aclPrefs[15] == 1) || (action == NukiOpener::LockAction::FobAction3 && (int)aclPrefs[16] == 1))
     {
         nukiOpenerPreferences->end();
-        nukiOpenerInst->_nextLockAction = action;
+        if(!nukiOpenerInst->queueLockAction(action))
+        {
+            return LockActionResult::Failed;
+        }
         return LockActionResult::Success;
     }
 
@@ -1097,7 +1240,7 @@ LockActionResult NukiOpenerWrapper::onLockActionReceivedCallback(const char *val
 
 void NukiOpenerWrapper::onConfigUpdateReceivedCallback(const char *value)
 {
-    nukiOpenerInst->onConfigUpdateReceived(value);
+    nukiOpenerInst->queueCommand(NukiCommandType::ConfigUpdate, value);
 }
 
 Nuki::AdvertisingMode NukiOpenerWrapper::advertisingModeToEnum(const char *str)
@@ -1528,7 +1671,7 @@ void NukiOpenerWrapper::onConfigUpdateReceived(const char *value)
 {
 
     JsonDocument jsonResult;
-    char _resbuf[2048];
+    static char _resbuf[2048]; // only executed on the nuki task, keep it off the task stack
 
     if(!_nukiConfigValid)
     {
@@ -2413,22 +2556,32 @@ void NukiOpenerWrapper::onConfigUpdateReceived(const char *value)
 
 void NukiOpenerWrapper::onKeypadCommandReceivedCallback(const char *command, const uint &id, const String &name, const String &code, const int& enabled)
 {
-    nukiOpenerInst->onKeypadCommandReceived(command, id, name, code, enabled);
+    // The parameters come from separate topics, they are passed to the nuki task as one JSON payload
+    JsonDocument json;
+    json["command"] = command;
+    json["id"] = id;
+    json["name"] = name;
+    json["code"] = code;
+    json["enabled"] = enabled;
+
+    String payload;
+    serializeJson(json, payload);
+    nukiOpenerInst->queueCommand(NukiCommandType::Keypad, payload.c_str());
 }
 
 void NukiOpenerWrapper::onKeypadJsonCommandReceivedCallback(const char *value)
 {
-    nukiOpenerInst->onKeypadJsonCommandReceived(value);
+    nukiOpenerInst->queueCommand(NukiCommandType::KeypadJson, value);
 }
 
 void NukiOpenerWrapper::onTimeControlCommandReceivedCallback(const char *value)
 {
-    nukiOpenerInst->onTimeControlCommandReceived(value);
+    nukiOpenerInst->queueCommand(NukiCommandType::TimeControl, value);
 }
 
 void NukiOpenerWrapper::onAuthCommandReceivedCallback(const char *value)
 {
-    nukiOpenerInst->onAuthCommandReceived(value);
+    nukiOpenerInst->queueCommand(NukiCommandType::Auth, value);
 }
 
 void NukiOpenerWrapper::gpioActionCallback(const GpioAction &action, const int& pin)
@@ -2456,6 +2609,18 @@ void NukiOpenerWrapper::gpioActionCallback(const GpioAction &action, const int&
     }
 }
 
+void NukiOpenerWrapper::executeKeypadCommand(const char *value)
+{
+    JsonDocument json;
+
+    if(deserializeJson(json, value))
+    {
+        return;
+    }
+
+    onKeypadCommandReceived(json["command"] | "", json["id"].as<uint>(), json["name"].as<String>(), json["code"].as<String>(), json["enabled"].as<int>());
+}
+
 void NukiOpenerWrapper::onKeypadCommandReceived(const char *command, const uint &id, const String &name, const String &code, const int& enabled)
 {
     if(_disableNonJSON)
@@ -2636,6 +2801,32 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
         return;
     }
 
+    if(json.is<JsonArray>())
+    {
+        _commandBatch.begin();
+
+        for(JsonObject entry : json.as<JsonArray>())
+        {
+            _commandBatch.beginEntry(entry["action"].as<const char*>());
+            executeKeypadJsonCommand(entry);
+            _commandBatch.endEntry();
+
+            postponeBleWatchdog();
+            esp_task_wdt_reset();
+        }
+
+        updateKeypad(false);
+
+        _commandBatch.end(CharBuffer::get(), CharBuffer::size());
+        _network->publishKeypadJsonCommandResult(CharBuffer::get());
+        return;
+    }
+
+    executeKeypadJsonCommand(json.as<JsonObject>());
+}
+
+void NukiOpenerWrapper::executeKeypadJsonCommand(JsonObject json)
+{
     char oldName[21];
     const char *action = json["action"].as<const char*>();
     uint16_t codeId = json["codeId"].as<unsigned int>();
@@ -2714,13 +2905,13 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
         {
             if(!_preferences->getBool(preference_keypad_check_code_enabled, false))
             {
-                _network->publishKeypadJsonCommandResult("checkingKeypadCodesDisabled");
+                publishKeypadJsonCommandResult("checkingKeypadCodesDisabled");
                 return;
             }
 
             if((pow(_invalidCount, 5) + _lastCodeCheck) > espMillis())
             {
-                _network->publishKeypadJsonCommandResult("checkingCodesBlockedTooManyInvalid");
+                publishKeypadJsonCommandResult("checkingCodesBlockedTooManyInvalid");
                 _lastCodeCheck = espMillis();
                 return;
             }
@@ -2736,14 +2927,14 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
                 if(code == _keypadCodes[index])
                 {
                     _invalidCount = 0;
-                    _network->publishKeypadJsonCommandResult("codeValid");
+                    publishKeypadJsonCommandResult("codeValid");
                     Log->println("Valid");
                     return;
                 }
                 else
                 {
                     _invalidCount++;
-                    _network->publishKeypadJsonCommandResult("codeInvalid");
+                    publishKeypadJsonCommandResult("codeInvalid");
                     Log->print("Invalid\nInvalid count: ");
                     Log->println(_invalidCount);
                     return;
@@ -2752,7 +2943,7 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
             else
             {
                 _invalidCount++;
-                _network->publishKeypadJsonCommandResult("noExistingCodeIdSet");
+                publishKeypadJsonCommandResult("noExistingCodeIdSet");
                 Log->print("Invalid count: ");
                 Log->println(_invalidCount);
                 return;
@@ -2775,7 +2966,7 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
                     }
                     else
                     {
-                        _network->publishKeypadJsonCommandResult("noExistingCodeIdSet");
+                        publishKeypadJsonCommandResult("noExistingCodeIdSet");
                         return;
                     }
                 }
@@ -2785,7 +2976,7 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
                     {
                         if (strcmp(action, "update") != 0)
                         {
-                            _network->publishKeypadJsonCommandResult("noNameSet");
+                            publishKeypadJsonCommandResult("noNameSet");
                             return;
                         }
                     }
@@ -2797,13 +2988,13 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
 
                         if (!codeValid)
                         {
-                            _network->publishKeypadJsonCommandResult("noValidCodeSet");
+                            publishKeypadJsonCommandResult("noValidCodeSet");
                             return;
                         }
                     }
                     else if (strcmp(action, "update") != 0)
                     {
-                        _network->publishKeypadJsonCommandResult("noCodeSet");
+                        publishKeypadJsonCommandResult("noCodeSet");
                         return;
                     }
 
@@ -2828,13 +3019,13 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
 
                                 if(allowedFromAr[0] < 2000 || allowedFromAr[0] > 3000 || allowedFromAr[1] < 1 || allowedFromAr[1] > 12 || allowedFromAr[2] < 1 || allowedFromAr[2] > 31 || allowedFromAr[3] < 0 || allowedFromAr[3] > 23 || allowedFromAr[4] < 0 || allowedFromAr[4] > 59 || allowedFromAr[5] < 0 || allowedFromAr[5] > 59)
                                 {
-                                    _network->publishKeypadJsonCommandResult("invalidAllowedFrom");
+                                    publishKeypadJsonCommandResult("invalidAllowedFrom");
                                     return;
                                 }
                             }
                             else
                             {
-                                _network->publishKeypadJsonCommandResult("invalidAllowedFrom");
+                                publishKeypadJsonCommandResult("invalidAllowedFrom");
                                 return;
                             }
                         }
@@ -2852,13 +3043,13 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
 
                                 if(allowedUntilAr[0] < 2000 || allowedUntilAr[0] > 3000 || allowedUntilAr[1] < 1 || allowedUntilAr[1] > 12 || allowedUntilAr[2] < 1 || allowedUntilAr[2] > 31 || allowedUntilAr[3] < 0 || allowedUntilAr[3] > 23 || allowedUntilAr[4] < 0 || allowedUntilAr[4] > 59 || allowedUntilAr[5] < 0 || allowedUntilAr[5] > 59)
                                 {
-                                    _network->publishKeypadJsonCommandResult("invalidAllowedUntil");
+                                    publishKeypadJsonCommandResult("invalidAllowedUntil");
                                     return;
                                 }
                             }
                             else
                             {
-                                _network->publishKeypadJsonCommandResult("invalidAllowedUntil");
+                                publishKeypadJsonCommandResult("invalidAllowedUntil");
                                 return;
                             }
                         }
@@ -2872,13 +3063,13 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
 
                                 if(allowedFromTimeAr[0] < 0 || allowedFromTimeAr[0] > 23 || allowedFromTimeAr[1] < 0 || allowedFromTimeAr[1] > 59)
                                 {
-                                    _network->publishKeypadJsonCommandResult("invalidAllowedFromTime");
+                                    publishKeypadJsonCommandResult("invalidAllowedFromTime");
                                     return;
                                 }
                             }
                             else
                             {
-                                _network->publishKeypadJsonCommandResult("invalidAllowedFromTime");
+                                publishKeypadJsonCommandResult("invalidAllowedFromTime");
                                 return;
                             }
                         }
@@ -2892,13 +3083,13 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
 
                                 if(allowedUntilTimeAr[0] < 0 || allowedUntilTimeAr[0] > 23 || allowedUntilTimeAr[1] < 0 || allowedUntilTimeAr[1] > 59)
                                 {
-                                    _network->publishKeypadJsonCommandResult("invalidAllowedUntilTime");
+                                    publishKeypadJsonCommandResult("invalidAllowedUntilTime");
                                     return;
                                 }
                             }
                             else
                             {
-                                _network->publishKeypadJsonCommandResult("invalidAllowedUntilTime");
+                                publishKeypadJsonCommandResult("invalidAllowedUntilTime");
                                 return;
                             }
                         }
@@ -2984,22 +3175,26 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
                     {
                         if(!codeId)
                         {
-                            _network->publishKeypadJsonCommandResult("noCodeIdSet");
+                            publishKeypadJsonCommandResult("noCodeIdSet");
                             return;
                         }
 
                         if(!idExists)
                         {
-                            _network->publishKeypadJsonCommandResult("noExistingCodeIdSet");
+                            publishKeypadJsonCommandResult("noExistingCodeIdSet");
                             return;
                         }
 
-                        Nuki::CmdResult resultKp = _nukiOpener.retrieveKeypadEntries(0, _preferences->getInt(preference_keypad_max_entries, MAX_KEYPAD));
+                        Nuki::CmdResult resultKp = _commandBatch.entriesRetrieved() ? Nuki::CmdResult::Success : _nukiOpener.retrieveKeypadEntries(0, _preferences->getInt(preference_keypad_max_entries, MAX_KEYPAD));
                         bool foundExisting = false;
 
                         if(resultKp == Nuki::CmdResult::Success)
                         {
-                            delay(5000);
+                            if(!_commandBatch.entriesRetrieved())
+                            {
+                                delay(5000);
+                                _commandBatch.setEntriesRetrieved();
+                            }
                             std::list<NukiOpener::KeypadEntry> entries;
                             _nukiOpener.getKeypadEntries(&entries);
 
@@ -3073,13 +3268,13 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
 
                             if(!foundExisting)
                             {
-                                _network->publishKeypadJsonCommandResult("failedToRetrieveExistingKeypadEntry");
+                                publishKeypadJsonCommandResult("failedToRetrieveExistingKeypadEntry");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishKeypadJsonCommandResult("failedToRetrieveExistingKeypadEntry");
+                            publishKeypadJsonCommandResult("failedToRetrieveExistingKeypadEntry");
                             return;
                         }
 
@@ -3149,7 +3344,7 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
                 }
                 else
                 {
-                    _network->publishKeypadJsonCommandResult("invalidAction");
+                    publishKeypadJsonCommandResult("invalidAction");
                     return;
                 }
 
@@ -3163,24 +3358,40 @@ void NukiOpenerWrapper::onKeypadJsonCommandReceived(const char *value)
                 }
             }
 
-            updateKeypad(false);
+            _commandBatch.invalidateEntries();
+
+            if(!_commandBatch.active())
+            {
+                updateKeypad(false);
+            }
 
             if((int)result != -1)
             {
                 char resultStr[15];
                 memset(&resultStr, 0, sizeof(resultStr));
                 NukiOpener::cmdResultToString(result, resultStr);
-                _network->publishKeypadJsonCommandResult(resultStr);
+                publishKeypadJsonCommandResult(resultStr);
             }
         }
     }
     else
     {
-        _network->publishKeypadJsonCommandResult("noActionSet");
+        publishKeypadJsonCommandResult("noActionSet");
         return;
     }
 }
 
+void NukiOpenerWrapper::publishKeypadJsonCommandResult(const char* result)
+{
+    if(_commandBatch.active())
+    {
+        _commandBatch.addResult(result);
+        return;
+    }
+
+    _network->publishKeypadJsonCommandResult(result);
+}
+
 void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
 {
     if(!_nukiConfigValid)
@@ -3210,6 +3421,30 @@ void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
         return;
     }
 
+    if(json.is<JsonArray>())
+    {
+        _commandBatch.begin();
+
+        for(JsonObject entry : json.as<JsonArray>())
+        {
+            _commandBatch.beginEntry(entry["action"].as<const char*>());
+            executeTimeControlCommand(entry);
+            _commandBatch.endEntry();
+
+            postponeBleWatchdog();
+            esp_task_wdt_reset();
+        }
+
+        _commandBatch.end(CharBuffer::get(), CharBuffer::size());
+        _network->publishTimeControlCommandResult(CharBuffer::get());
+        return;
+    }
+
+    executeTimeControlCommand(json.as<JsonObject>());
+}
+
+void NukiOpenerWrapper::executeTimeControlCommand(JsonObject json)
+{
     const char *action = json["action"].as<const char*>();
     uint8_t entryId = json["entryId"].as<unsigned int>();
     uint8_t enabled;
@@ -3246,7 +3481,7 @@ void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
 
         if((int)timeControlLockAction == 0xff)
         {
-            _network->publishTimeControlCommandResult("invalidLockAction");
+            publishTimeControlCommandResult("invalidLockAction");
             return;
         }
     }
@@ -3275,7 +3510,7 @@ void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
                 }
                 else
                 {
-                    _network->publishTimeControlCommandResult("noExistingEntryIdSet");
+                    publishTimeControlCommandResult("noExistingEntryIdSet");
                     return;
                 }
             }
@@ -3295,13 +3530,13 @@ void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
 
                         if(timeAr[0] < 0 || timeAr[0] > 23 || timeAr[1] < 0 || timeAr[1] > 59)
                         {
-                            _network->publishTimeControlCommandResult("invalidTime");
+                            publishTimeControlCommandResult("invalidTime");
                             return;
                         }
                     }
                     else
                     {
-                        _network->publishTimeControlCommandResult("invalidTime");
+                        publishTimeControlCommandResult("invalidTime");
                         return;
                     }
                 }
@@ -3356,16 +3591,20 @@ void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
                 {
                     if(!idExists)
                     {
-                        _network->publishTimeControlCommandResult("noExistingEntryIdSet");
+                        publishTimeControlCommandResult("noExistingEntryIdSet");
                         return;
                     }
 
-                    Nuki::CmdResult resultTc = _nukiOpener.retrieveTimeControlEntries();
+                    Nuki::CmdResult resultTc = _commandBatch.entriesRetrieved() ? Nuki::CmdResult::Success : _nukiOpener.retrieveTimeControlEntries();
                     bool foundExisting = false;
 
                     if(resultTc == Nuki::CmdResult::Success)
                     {
-                        delay(5000);
+                        if(!_commandBatch.entriesRetrieved())
+                        {
+                            delay(5000);
+                            _commandBatch.setEntriesRetrieved();
+                        }
                         std::list<NukiOpener::TimeControlEntry> timeControlEntries;
                         _nukiOpener.getTimeControlEntries(&timeControlEntries);
 
@@ -3402,13 +3641,13 @@ void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
 
                         if(!foundExisting)
                         {
-                            _network->publishTimeControlCommandResult("failedToRetrieveExistingTimeControlEntry");
+                            publishTimeControlCommandResult("failedToRetrieveExistingTimeControlEntry");
                             return;
                         }
                     }
                     else
                     {
-                        _network->publishTimeControlCommandResult("failedToRetrieveExistingTimeControlEntry");
+                        publishTimeControlCommandResult("failedToRetrieveExistingTimeControlEntry");
                         return;
                     }
 
@@ -3432,7 +3671,7 @@ void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
             }
             else
             {
-                _network->publishTimeControlCommandResult("invalidAction");
+                publishTimeControlCommandResult("invalidAction");
                 return;
             }
 
@@ -3446,23 +3685,36 @@ void NukiOpenerWrapper::onTimeControlCommandReceived(const char *value)
             }
         }
 
+        _commandBatch.invalidateEntries();
+
         if((int)result != -1)
         {
             char resultStr[15];
             memset(&resultStr, 0, sizeof(resultStr));
             NukiOpener::cmdResultToString(result, resultStr);
-            _network->publishTimeControlCommandResult(resultStr);
+            publishTimeControlCommandResult(resultStr);
         }
 
         _nextConfigUpdateTs = espMillis() + 300;
     }
     else
     {
-        _network->publishTimeControlCommandResult("noActionSet");
+        publishTimeControlCommandResult("noActionSet");
         return;
     }
 }
 
+void NukiOpenerWrapper::publishTimeControlCommandResult(const char* result)
+{
+    if(_commandBatch.active())
+    {
+        _commandBatch.addResult(result);
+        return;
+    }
+
+    _network->publishTimeControlCommandResult(result);
+}
+
 void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
 {
     if(!_nukiConfigValid)
@@ -3492,6 +3744,32 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
         return;
     }
 
+    if(json.is<JsonArray>())
+    {
+        _commandBatch.begin();
+
+        for(JsonObject entry : json.as<JsonArray>())
+        {
+            _commandBatch.beginEntry(entry["action"].as<const char*>());
+            executeAuthCommand(entry);
+            _commandBatch.endEntry();
+
+            postponeBleWatchdog();
+            esp_task_wdt_reset();
+        }
+
+        updateAuth(false);
+
+        _commandBatch.end(CharBuffer::get(), CharBuffer::size());
+        _network->publishAuthCommandResult(CharBuffer::get());
+        return;
+    }
+
+    executeAuthCommand(json.as<JsonObject>());
+}
+
+void NukiOpenerWrapper::executeAuthCommand(JsonObject json)
+{
     char oldName[33];
     const char *action = json["action"].as<const char*>();
     uint32_t authId = json["authId"].as<unsigned int>();
@@ -3585,7 +3863,7 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
                 }
                 else
                 {
-                    _network->publishAuthCommandResult("noExistingAuthIdSet");
+                    publishAuthCommandResult("noExistingAuthIdSet");
                     return;
                 }
             }
@@ -3595,7 +3873,7 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
                 {
                     if (strcmp(action, "update") != 0)
                     {
-                        _network->publishAuthCommandResult("noNameSet");
+                        publishAuthCommandResult("noNameSet");
                         return;
                     }
                 }
@@ -3605,7 +3883,7 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
                 {
                     if (strcmp(action, "update") != 0)
                     {
-                        _network->publishAuthCommandResult("noSharedKeySet");
+                        publishAuthCommandResult("noSharedKeySet");
                         return;
                     }
                 }
@@ -3636,13 +3914,13 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
 
                             if(allowedFromAr[0] < 2000 || allowedFromAr[0] > 3000 || allowedFromAr[1] < 1 || allowedFromAr[1] > 12 || allowedFromAr[2] < 1 || allowedFromAr[2] > 31 || allowedFromAr[3] < 0 || allowedFromAr[3] > 23 || allowedFromAr[4] < 0 || allowedFromAr[4] > 59 || allowedFromAr[5] < 0 || allowedFromAr[5] > 59)
                             {
-                                _network->publishAuthCommandResult("invalidAllowedFrom");
+                                publishAuthCommandResult("invalidAllowedFrom");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishAuthCommandResult("invalidAllowedFrom");
+                            publishAuthCommandResult("invalidAllowedFrom");
                             return;
                         }
                     }
@@ -3660,13 +3938,13 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
 
                             if(allowedUntilAr[0] < 2000 || allowedUntilAr[0] > 3000 || allowedUntilAr[1] < 1 || allowedUntilAr[1] > 12 || allowedUntilAr[2] < 1 || allowedUntilAr[2] > 31 || allowedUntilAr[3] < 0 || allowedUntilAr[3] > 23 || allowedUntilAr[4] < 0 || allowedUntilAr[4] > 59 || allowedUntilAr[5] < 0 || allowedUntilAr[5] > 59)
                             {
-                                _network->publishAuthCommandResult("invalidAllowedUntil");
+                                publishAuthCommandResult("invalidAllowedUntil");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishAuthCommandResult("invalidAllowedUntil");
+                            publishAuthCommandResult("invalidAllowedUntil");
                             return;
                         }
                     }
@@ -3680,13 +3958,13 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
 
                             if(allowedFromTimeAr[0] < 0 || allowedFromTimeAr[0] > 23 || allowedFromTimeAr[1] < 0 || allowedFromTimeAr[1] > 59)
                             {
-                                _network->publishAuthCommandResult("invalidAllowedFromTime");
+                                publishAuthCommandResult("invalidAllowedFromTime");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishAuthCommandResult("invalidAllowedFromTime");
+                            publishAuthCommandResult("invalidAllowedFromTime");
                             return;
                         }
                     }
@@ -3700,13 +3978,13 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
 
                             if(allowedUntilTimeAr[0] < 0 || allowedUntilTimeAr[0] > 23 || allowedUntilTimeAr[1] < 0 || allowedUntilTimeAr[1] > 59)
                             {
-                                _network->publishAuthCommandResult("invalidAllowedUntilTime");
+                                publishAuthCommandResult("invalidAllowedUntilTime");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishAuthCommandResult("invalidAllowedUntilTime");
+                            publishAuthCommandResult("invalidAllowedUntilTime");
                             return;
                         }
                     }
@@ -3743,7 +4021,7 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
 
                 if(strcmp(action, "add") == 0)
                 {
-                    _network->publishAuthCommandResult("addActionNotSupported");
+                    publishAuthCommandResult("addActionNotSupported");
                     return;
 
                     NukiOpener::NewAuthorizationEntry entry;
@@ -3755,7 +4033,7 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
 
                     if(idType != 1)
                     {
-                        _network->publishAuthCommandResult("invalidIdType");
+                        publishAuthCommandResult("invalidIdType");
                         return;
                     }
 
@@ -3806,22 +4084,26 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
                 {
                     if(!authId)
                     {
-                        _network->publishAuthCommandResult("noAuthIdSet");
+                        publishAuthCommandResult("noAuthIdSet");
                         return;
                     }
 
                     if(!idExists)
                     {
-                        _network->publishAuthCommandResult("noExistingAuthIdSet");
+                        publishAuthCommandResult("noExistingAuthIdSet");
                         return;
                     }
 
-                    Nuki::CmdResult resultAuth = _nukiOpener.retrieveAuthorizationEntries(0, _preferences->getInt(preference_auth_max_entries, MAX_AUTH));
+                    Nuki::CmdResult resultAuth = _commandBatch.entriesRetrieved() ? Nuki::CmdResult::Success : _nukiOpener.retrieveAuthorizationEntries(0, _preferences->getInt(preference_auth_max_entries, MAX_AUTH));
                     bool foundExisting = false;
 
                     if(resultAuth == Nuki::CmdResult::Success)
                     {
-                        delay(5000);
+                        if(!_commandBatch.entriesRetrieved())
+                        {
+                            delay(5000);
+                            _commandBatch.setEntriesRetrieved();
+                        }
                         std::list<NukiOpener::AuthorizationEntry> entries;
                         _nukiOpener.getAuthorizationEntries(&entries);
 
@@ -3894,13 +4176,13 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
 
                         if(!foundExisting)
                         {
-                            _network->publishAuthCommandResult("failedToRetrieveExistingAuthorizationEntry");
+                            publishAuthCommandResult("failedToRetrieveExistingAuthorizationEntry");
                             return;
                         }
                     }
                     else
                     {
-                        _network->publishAuthCommandResult("failedToRetrieveExistingAuthorizationEntry");
+                        publishAuthCommandResult("failedToRetrieveExistingAuthorizationEntry");
                         return;
                     }
 
@@ -3970,7 +4252,7 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
             }
             else
             {
-                _network->publishAuthCommandResult("invalidAction");
+                publishAuthCommandResult("invalidAction");
                 return;
             }
 
@@ -3984,23 +4266,39 @@ void NukiOpenerWrapper::onAuthCommandReceived(const char *value)
             }
         }
 
-        updateAuth(false);
+        _commandBatch.invalidateEntries();
+
+        if(!_commandBatch.active())
+        {
+            updateAuth(false);
+        }
 
         if((int)result != -1)
         {
             char resultStr[15];
             memset(&resultStr, 0, sizeof(resultStr));
             NukiOpener::cmdResultToString(result, resultStr);
-            _network->publishAuthCommandResult(resultStr);
+            publishAuthCommandResult(resultStr);
         }
     }
     else
     {
-        _network->publishAuthCommandResult("noActionSet");
+        publishAuthCommandResult("noActionSet");
         return;
     }
 }
 
+void NukiOpenerWrapper::publishAuthCommandResult(const char* result)
+{
+    if(_commandBatch.active())
+    {
+        _commandBatch.addResult(result);
+        return;
+    }
+
+    _network->publishAuthCommandResult(result);
+}
+
 const NukiOpener::OpenerState &NukiOpenerWrapper::keyTurnerState()
 {
     return _keyTurnerState;
@@ -4040,13 +4338,14 @@ void NukiOpenerWrapper::notify(Nuki::EventType eventType)
             _newSignal++;
             Log->println("KeyTurnerStatusUpdated");
             _statusUpdated = true;
+            wakeNukiTask();
             _statusUpdatedTs = espMillis();
             _network->publishStatusUpdated(_statusUpdated);
         }
     }
     else if(eventType == Nuki::EventType::ERROR_BAD_PIN)
     {
-        _preferences->putInt(preference_lock_pin_status, 2);
+        _preferences->putInt(preference_opener_pin_status, 2);
     }
     else if(eventType == Nuki::EventType::BLE_ERROR_ON_DISCONNECT)
     {
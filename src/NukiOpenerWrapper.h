@@ -7,16 +7,19 @@
 #include "BleScanner.h"
 #include "Gpio.h"
 #include "NukiDeviceId.h"
+#include "NukiCommandQueue.h"
+#include "NukiCommandBatch.h"
 
 class NukiOpenerWrapper : public NukiOpener::SmartlockEventHandler
 {
 public:
-    NukiOpenerWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NukiNetworkOpener* network, Gpio* gpio, Preferences* preferences);
+    NukiOpenerWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NukiNetworkOpener* network, Gpio* gpio, CachedPreferences* preferences);
     virtual ~NukiOpenerWrapper();
 
     void initialize();
     void readSettings();
     void update();
+    int64_t nextUpdateTs();
 
     void electricStrikeActuation();
     void activateRTO();
@@ -40,12 +43,15 @@ public:
 
     std::string firmwareVersion() const;
     std::string hardwareVersion() const;
+    // Commands that were dropped because the command queue was full
+    uint32_t commandsDropped() const;
 
     BleScanner::Scanner* bleScanner();
 
     void notify(NukiOpener::EventType eventType) override;
 
 private:
+    static bool isSettingsKey(const char* key);
     static LockActionResult onLockActionReceivedCallback(const char* value);
     static void onConfigUpdateReceivedCallback(const char* value);
     static void onKeypadCommandReceivedCallback(const char* command, const uint& id, const String& name, const String& code, const int& enabled);
@@ -59,6 +65,18 @@ private:
     void onKeypadJsonCommandReceived(const char* value);
     void onTimeControlCommandReceived(const char* value);
     void onAuthCommandReceived(const char* value);
+    void executeKeypadJsonCommand(JsonObject json);
+    void executeTimeControlCommand(JsonObject json);
+    void executeAuthCommand(JsonObject json);
+    void publishKeypadJsonCommandResult(const char* result);
+    void publishTimeControlCommandResult(const char* result);
+    void publishAuthCommandResult(const char* result);
+
+    void processCommandQueue();
+    void executeKeypadCommand(const char* value);
+    void executeLockAction(const NukiOpener::LockAction action);
+    bool queueLockAction(const NukiOpener::LockAction action);
+    bool queueCommand(const NukiCommandType type, const char* value);
 
     bool updateKeyTurnerState();
     void updateBatteryState();
@@ -93,7 +111,7 @@ private:
     BleScanner::Scanner* _bleScanner = nullptr;
     NukiNetworkOpener* _network = nullptr;
     Gpio* _gpio = nullptr;
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
     int _intervalLockstate = 0; // seconds
     int _intervalBattery = 0; // seconds
     int _intervalConfig = 60 * 60; // seconds
@@ -134,6 +152,7 @@ private:
     int _newSignal = 0;
     bool _hasKeypad = false;
     bool _forceKeypad = false;
+    std::atomic<bool> _settingsChanged{false};
     bool _keypadEnabled = false;
     bool _forceId = false;
     uint _maxKeypadCodeCount = 0;
@@ -158,5 +177,6 @@ private:
     uint32_t _advancedOpenerConfigAclPrefs[21];
     std::string _firmwareVersion = "";
     std::string _hardwareVersion = "";
-    NukiOpener::LockAction _nextLockAction = (NukiOpener::LockAction)0xff;
+    NukiCommandQueue _commandQueue;
+    NukiCommandBatch _commandBatch;
 };
@@ -49,6 +49,11 @@ void NukiPublisher::publishString(const char *topic, const char *value, bool ret
     _network->publishString(_mqttPath, topic, value, retain);
 }
 
+void NukiPublisher::publishJson(const char *topic, JsonVariantConst json, bool retain)
+{
+    _network->publishJson(_mqttPath, topic, json, retain);
+}
+
 void NukiPublisher::publishULong(const char *topic, const unsigned long value, bool retain)
 {
     _network->publishULong(_mqttPath, topic, value, retain);
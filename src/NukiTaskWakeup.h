@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+extern TaskHandle_t nukiTaskHandle;
+
+// Wakes the nuki task before its next deadline, safe to call from tasks and ISRs
+inline void wakeNukiTask()
+{
+    if(nukiTaskHandle == nullptr)
+    {
+        return;
+    }
+
+    if(xPortInIsrContext())
+    {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(nukiTaskHandle, &higherPriorityTaskWoken);
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
+    }
+    else
+    {
+        xTaskNotifyGive(nukiTaskHandle);
+    }
+}
+#endif
+
+// Merges a deadline into nextTs. A deadline of 0 means "not scheduled", nextTs == 0 means "nothing scheduled yet"
+inline void mergeDeadline(int64_t& nextTs, const int64_t deadlineTs)
+{
+    if(deadlineTs > 0 && (nextTs == 0 || deadlineTs < nextTs))
+    {
+        nextTs = deadlineTs;
+    }
+}
+
+// Returns how many milliseconds the nuki task may sleep until nextTs, clamped to [0, maxWait]. nextTs == 0 means no deadline.
+inline int64_t nukiTaskWaitTime(const int64_t nextTs, const int64_t now, const int64_t maxWait)
+{
+    if(nextTs == 0 || nextTs - now >= maxWait)
+    {
+        return maxWait;
+    }
+    if(nextTs <= now)
+    {
+        return 0;
+    }
+    return nextTs - now;
+}
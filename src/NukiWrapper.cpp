@@ -6,12 +6,15 @@
 #include <NukiLockUtils.h>
 #include "Config.h"
 #include "hal/wdt_hal.h"
+#include "esp_task_wdt.h"
 #include <time.h>
 #include "esp_sntp.h"
+#include "NukiTaskWakeup.h"
+#include "CharBuffer.h"
 
 NukiWrapper* nukiInst = nullptr;
 
-NukiWrapper::NukiWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NukiNetworkLock* network, NukiOfficial* nukiOfficial, Gpio* gpio, Preferences* preferences)
+NukiWrapper::NukiWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NukiNetworkLock* network, NukiOfficial* nukiOfficial, Gpio* gpio, CachedPreferences* preferences)
     : _deviceName(deviceName),
       _deviceId(deviceId),
       _bleScanner(scanner),
@@ -73,6 +76,37 @@ void NukiWrapper::initialize()
 
     _hassEnabled = _preferences->getBool(preference_mqtt_hass_enabled, false);
     readSettings();
+
+    _preferences->addChangeListener([this](const char* key)
+    {
+        if(isSettingsKey(key))
+        {
+            _settingsChanged = true;
+        }
+    });
+}
+
+bool NukiWrapper::isSettingsKey(const char* key)
+{
+    // Keys read by readSettings(). The max entry counts are written by the wrapper itself and are left out, like all other runtime state
+    static const char* const settingsKeys[] =
+    {
+        preference_ble_tx_power, preference_query_interval_lockstate, preference_query_interval_configuration,
+        preference_query_interval_battery, preference_query_interval_keypad, preference_keypad_info_enabled, preference_publish_authdata,
+        preference_restart_ble_beacon_lost, preference_command_nr_of_retries, preference_command_retry_delay, preference_rssi_publish_interval,
+        preference_disable_non_json, preference_keypad_check_code_enabled,
+        preference_query_interval_hybrid_lockstate, preference_register_as_app, preference_lock_force_doorsensor, preference_lock_force_keypad,
+        preference_lock_force_id, preference_lock_gemini_enabled, preference_conf_lock_basic_acl, preference_conf_lock_advanced_acl
+    };
+
+    for(const char* settingsKey : settingsKeys)
+    {
+        if(strcmp(key, settingsKey) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
 }
 
 void NukiWrapper::readSettings()
@@ -208,6 +242,12 @@ void NukiWrapper::update(bool reboot)
     wdt_hal_write_protect_disable(&rtc_wdt_ctx);
     wdt_hal_feed(&rtc_wdt_ctx);
     wdt_hal_write_protect_enable(&rtc_wdt_ctx);
+
+    if(_settingsChanged.exchange(false))
+    {
+        readSettings();
+    }
+
     if(!_paired)
     {
         Log->println(("Nuki lock start pairing"));
@@ -252,66 +292,10 @@ void NukiWrapper::update(bool reboot)
 
     if(_nukiOfficial->getOffCommandExecutedTs() > 0 && ts >= _nukiOfficial->getOffCommandExecutedTs())
     {
-        _nextLockAction = _offCommand;
+        queueLockAction(_offCommand);
         _nukiOfficial->clearOffCommandExecutedTs();
     }
-    if(_nextLockAction != (NukiLock::LockAction)0xff)
-    {
-        int retryCount = 0;
-        Nuki::CmdResult cmdResult;
-
-        while(retryCount < _nrOfRetries + 1 && cmdResult != Nuki::CmdResult::Success)
-        {
-            cmdResult = _nukiLock.lockAction(_nextLockAction, 0, 0);
-            char resultStr[15] = {0};
-            NukiLock::cmdResultToString(cmdResult, resultStr);
-            _network->publishCommandResult(resultStr);
-
-            Log->print(("Lock action result: "));
-            Log->println(resultStr);
-
-            if(cmdResult != Nuki::CmdResult::Success)
-            {
-                Log->print(("Lock: Last command failed, retrying after "));
-                Log->print(_retryDelay);
-                Log->print((" milliseconds. Retry "));
-                Log->print(retryCount + 1);
-                Log->print(" of ");
-                Log->println(_nrOfRetries);
-
-                _network->publishRetry(std::to_string(retryCount + 1));
-
-                delay(_retryDelay);
-
-                ++retryCount;
-            }
-            postponeBleWatchdog();
-        }
-
-        if(cmdResult == Nuki::CmdResult::Success)
-        {
-            _nextLockAction = (NukiLock::LockAction) 0xff;
-            _network->publishRetry("--");
-            retryCount = 0;
-            if(!_nukiOfficial->getOffConnected())
-            {
-                _statusUpdated = true;
-            }
-            Log->println(("Lock: updating status after action"));
-            _statusUpdatedTs = ts;
-            if(_intervalLockstate > 10)
-            {
-                _nextLockStateUpdateTs = ts + 10 * 1000;
-            }
-        }
-        else
-        {
-            Log->println(("Lock: Maximum number of retries exceeded, aborting."));
-            _network->publishRetry("failed");
-            retryCount = 0;
-            _nextLockAction = (NukiLock::LockAction) 0xff;
-        }
-    }
+    processCommandQueue();
     if(_nukiOfficial->getStatusUpdated() || _statusUpdated || _nextLockStateUpdateTs == 0 || ts >= _nextLockStateUpdateTs || (queryCommands & QUERY_COMMAND_LOCKSTATE) > 0)
     {
         Log->println("Updating Lock state based on status, timer or query");
@@ -402,29 +386,186 @@ void NukiWrapper::update(bool reboot)
     memcpy(&_lastKeyTurnerState, &_keyTurnerState, sizeof(NukiLock::KeyTurnerState));
 }
 
+void NukiWrapper::processCommandQueue()
+{
+    NukiCommand command;
+
+    while(_commandQueue.pop(command))
+    {
+        Log->print("Lock: Executing queued command, queued for ");
+        Log->print(espMillis() - command.enqueuedTs);
+        Log->println(" ms");
+
+        switch(command.type)
+        {
+        case NukiCommandType::LockAction:
+            executeLockAction((NukiLock::LockAction)command.lockAction);
+            break;
+        case NukiCommandType::ConfigUpdate:
+            onConfigUpdateReceived(command.payload);
+            break;
+        case NukiCommandType::Keypad:
+            executeKeypadCommand(command.payload);
+            break;
+        case NukiCommandType::KeypadJson:
+            onKeypadJsonCommandReceived(command.payload);
+            break;
+        case NukiCommandType::TimeControl:
+            onTimeControlCommandReceived(command.payload);
+            break;
+        case NukiCommandType::Auth:
+            onAuthCommandReceived(command.payload);
+            break;
+        }
+
+        command.freePayload();
+    }
+}
+
+void NukiWrapper::executeLockAction(const NukiLock::LockAction action)
+{
+    int64_t ts = espMillis();
+    int retryCount = 0;
+    Nuki::CmdResult cmdResult = (Nuki::CmdResult)-1;
+
+    while(retryCount < _nrOfRetries + 1 && cmdResult != Nuki::CmdResult::Success)
+    {
+        cmdResult = _nukiLock.lockAction(action, 0, 0);
+        char resultStr[15] = {0};
+        NukiLock::cmdResultToString(cmdResult, resultStr);
+        _network->publishCommandResult(resultStr);
+
+        Log->print(("Lock action result: "));
+        Log->println(resultStr);
+
+        if(cmdResult != Nuki::CmdResult::Success)
+        {
+            Log->print(("Lock: Last command failed, retrying after "));
+            Log->print(_retryDelay);
+            Log->print((" milliseconds. Retry "));
+            Log->print(retryCount + 1);
+            Log->print(" of ");
+            Log->println(_nrOfRetries);
+
+            _network->publishRetry(std::to_string(retryCount + 1));
+
+            delay(_retryDelay);
+
+            ++retryCount;
+        }
+        postponeBleWatchdog();
+    }
+
+    if(cmdResult == Nuki::CmdResult::Success)
+    {
+        _network->publishRetry("--");
+        if(!_nukiOfficial->getOffConnected())
+        {
+            _statusUpdated = true;
+        }
+        Log->println(("Lock: updating status after action"));
+        _statusUpdatedTs = ts;
+        if(_intervalLockstate > 10)
+        {
+            _nextLockStateUpdateTs = ts + 10 * 1000;
+        }
+    }
+    else
+    {
+        Log->println(("Lock: Maximum number of retries exceeded, aborting."));
+        _network->publishRetry("failed");
+    }
+}
+
+bool NukiWrapper::queueLockAction(const NukiLock::LockAction action)
+{
+    if(!_commandQueue.pushLockAction((uint8_t)action))
+    {
+        return false;
+    }
+    wakeNukiTask();
+    return true;
+}
+
+uint32_t NukiWrapper::commandsDropped() const
+{
+    return _commandQueue.droppedCount();
+}
+
+bool NukiWrapper::queueCommand(const NukiCommandType type, const char* value)
+{
+    if(!_commandQueue.pushPayload(type, value))
+    {
+        Log->println("Lock: Command queue full, dropping command");
+        return false;
+    }
+    wakeNukiTask();
+    return true;
+}
+
+int64_t NukiWrapper::nextUpdateTs()
+{
+    int64_t ts = espMillis();
+
+    if(!_paired || !_commandQueue.empty() || _statusUpdated || _nextLockStateUpdateTs == 0)
+    {
+        return ts;
+    }
+
+    int64_t nextTs = _nextLockStateUpdateTs;
+    mergeDeadline(nextTs, _nukiOfficial->getOffCommandExecutedTs());
+
+    if(_network->mqttConnectionState() == 2)
+    {
+        if(_nextBatteryReportTs == 0 || _nextConfigUpdateTs == 0 || _clearAuthData ||
+                (_hassEnabled && _nukiConfigValid && _nukiAdvancedConfigValid && !_hassSetupCompleted))
+        {
+            return ts;
+        }
+
+        mergeDeadline(nextTs, _nextBatteryReportTs);
+        mergeDeadline(nextTs, _nextConfigUpdateTs);
+        mergeDeadline(nextTs, _waitAuthLogUpdateTs);
+        mergeDeadline(nextTs, _waitKeypadUpdateTs);
+        mergeDeadline(nextTs, _waitTimeControlUpdateTs);
+        mergeDeadline(nextTs, _waitAuthUpdateTs);
+
+        if(_rssiPublishInterval > 0)
+        {
+            mergeDeadline(nextTs, _nextRssiTs > 0 ? _nextRssiTs : ts);
+        }
+        if(hasKeypad() && _keypadEnabled)
+        {
+            mergeDeadline(nextTs, _nextKeypadUpdateTs > 0 ? _nextKeypadUpdateTs : ts);
+        }
+    }
+
+    return nextTs;
+}
+
 void NukiWrapper::lock()
 {
-    _nextLockAction = NukiLock::LockAction::Lock;
+    queueLockAction(NukiLock::LockAction::Lock);
 }
 
 void NukiWrapper::unlock()
 {
-    _nextLockAction = NukiLock::LockAction::Unlock;
+    queueLockAction(NukiLock::LockAction::Unlock);
 }
 
 void NukiWrapper::unlatch()
 {
-    _nextLockAction = NukiLock::LockAction::Unlatch;
+    queueLockAction(NukiLock::LockAction::Unlatch);
 }
 
 void NukiWrapper::lockngo()
 {
-    _nextLockAction = NukiLock::LockAction::LockNgo;
+    queueLockAction(NukiLock::LockAction::LockNgo);
 }
 
 void NukiWrapper::lockngounlatch()
 {
-    _nextLockAction = NukiLock::LockAction::LockNgoUnlatch;
+    queueLockAction(NukiLock::LockAction::LockNgoUnlatch);
 }
 
 bool NukiWrapper::isPinSet()
@@ -1112,7 +1253,10 @@ LockActionResult NukiWrapper::onLockActionReceived(const char *value)
     {
         if(!_nukiOfficial->getOffConnected())
         {
-            nukiInst->_nextLockAction = action;
+            if(!nukiInst->queueLockAction(action))
+            {
+                return LockActionResult::Failed;
+            }
         }
         else
         {
@@ -1127,7 +1271,10 @@ LockActionResult NukiWrapper::onLockActionReceived(const char *value)
             }
             else
             {
-                nukiInst->_nextLockAction = action;
+                if(!nukiInst->queueLockAction(action))
+                {
+                    return LockActionResult::Failed;
+                }
             }
         }
         return LockActionResult::Success;
@@ -1143,7 +1290,7 @@ void NukiWrapper::onOfficialUpdateReceivedCallback(const char *topic, const char
 
 void NukiWrapper::onConfigUpdateReceivedCallback(const char *value)
 {
-    nukiInst->onConfigUpdateReceived(value);
+    nukiInst->queueCommand(NukiCommandType::ConfigUpdate, value);
 }
 
 bool NukiWrapper::offConnected()
@@ -1465,7 +1612,7 @@ void NukiWrapper::onOfficialUpdateReceived(const char *topic, const char *value)
 void NukiWrapper::onConfigUpdateReceived(const char *value)
 {
     JsonDocument jsonResult;
-    char _resbuf[2048];
+    static char _resbuf[2048]; // only executed on the nuki task, keep it off the task stack
 
     if(!_nukiConfigValid)
     {
@@ -2478,22 +2625,32 @@ void NukiWrapper::onConfigUpdateReceived(const char *value)
 
 void NukiWrapper::onKeypadCommandReceivedCallback(const char *command, const uint &id, const String &name, const String &code, const int& enabled)
 {
-    nukiInst->onKeypadCommandReceived(command, id, name, code, enabled);
+    // The parameters come from separate topics, they are passed to the nuki task as one JSON payload
+    JsonDocument json;
+    json["command"] = command;
+    json["id"] = id;
+    json["name"] = name;
+    json["code"] = code;
+    json["enabled"] = enabled;
+
+    String payload;
+    serializeJson(json, payload);
+    nukiInst->queueCommand(NukiCommandType::Keypad, payload.c_str());
 }
 
 void NukiWrapper::onKeypadJsonCommandReceivedCallback(const char *value)
 {
-    nukiInst->onKeypadJsonCommandReceived(value);
+    nukiInst->queueCommand(NukiCommandType::KeypadJson, value);
 }
 
 void NukiWrapper::onTimeControlCommandReceivedCallback(const char *value)
 {
-    nukiInst->onTimeControlCommandReceived(value);
+    nukiInst->queueCommand(NukiCommandType::TimeControl, value);
 }
 
 void NukiWrapper::onAuthCommandReceivedCallback(const char *value)
 {
-    nukiInst->onAuthCommandReceived(value);
+    nukiInst->queueCommand(NukiCommandType::Auth, value);
 }
 
 
@@ -2567,6 +2724,20 @@ void NukiWrapper::onGpioActionReceived(const GpioAction &action, const int &pin)
         }
         break;
     }
+
+    wakeNukiTask();
+}
+
+void NukiWrapper::executeKeypadCommand(const char *value)
+{
+    JsonDocument json;
+
+    if(deserializeJson(json, value))
+    {
+        return;
+    }
+
+    onKeypadCommandReceived(json["command"] | "", json["id"].as<uint>(), json["name"].as<String>(), json["code"].as<String>(), json["enabled"].as<int>());
 }
 
 void NukiWrapper::onKeypadCommandReceived(const char *command, const uint &id, const String &name, const String &code, const int& enabled)
@@ -2749,6 +2920,32 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
         return;
     }
 
+    if(json.is<JsonArray>())
+    {
+        _commandBatch.begin();
+
+        for(JsonObject entry : json.as<JsonArray>())
+        {
+            _commandBatch.beginEntry(entry["action"].as<const char*>());
+            executeKeypadJsonCommand(entry);
+            _commandBatch.endEntry();
+
+            postponeBleWatchdog();
+            esp_task_wdt_reset();
+        }
+
+        updateKeypad(false);
+
+        _commandBatch.end(CharBuffer::get(), CharBuffer::size());
+        _network->publishKeypadJsonCommandResult(CharBuffer::get());
+        return;
+    }
+
+    executeKeypadJsonCommand(json.as<JsonObject>());
+}
+
+void NukiWrapper::executeKeypadJsonCommand(JsonObject json)
+{
     char oldName[21];
     const char *action = json["action"].as<const char*>();
     uint16_t codeId = json["codeId"].as<unsigned int>();
@@ -2827,13 +3024,13 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
         {
             if(!_preferences->getBool(preference_keypad_check_code_enabled, false))
             {
-                _network->publishKeypadJsonCommandResult("checkingKeypadCodesDisabled");
+                publishKeypadJsonCommandResult("checkingKeypadCodesDisabled");
                 return;
             }
 
             if((pow(_invalidCount, 5) + _lastCodeCheck) > espMillis())
             {
-                _network->publishKeypadJsonCommandResult("checkingCodesBlockedTooManyInvalid");
+                publishKeypadJsonCommandResult("checkingCodesBlockedTooManyInvalid");
                 _lastCodeCheck = espMillis();
                 return;
             }
@@ -2849,14 +3046,14 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
                 if(code == _keypadCodes[index])
                 {
                     _invalidCount = 0;
-                    _network->publishKeypadJsonCommandResult("codeValid");
+                    publishKeypadJsonCommandResult("codeValid");
                     Log->println("Valid");
                     return;
                 }
                 else
                 {
                     _invalidCount++;
-                    _network->publishKeypadJsonCommandResult("codeInvalid");
+                    publishKeypadJsonCommandResult("codeInvalid");
                     Log->print("Invalid\nInvalid count: ");
                     Log->println(_invalidCount);
                     return;
@@ -2865,7 +3062,7 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
             else
             {
                 _invalidCount++;
-                _network->publishKeypadJsonCommandResult("noExistingCodeIdSet");
+                publishKeypadJsonCommandResult("noExistingCodeIdSet");
                 Log->print("Invalid count: ");
                 Log->println(_invalidCount);
                 return;
@@ -2889,7 +3086,7 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
                     }
                     else
                     {
-                        _network->publishKeypadJsonCommandResult("noExistingCodeIdSet");
+                        publishKeypadJsonCommandResult("noExistingCodeIdSet");
                         return;
                     }
                 }
@@ -2899,7 +3096,7 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
                     {
                         if (strcmp(action, "update") != 0)
                         {
-                            _network->publishKeypadJsonCommandResult("noNameSet");
+                            publishKeypadJsonCommandResult("noNameSet");
                             return;
                         }
                     }
@@ -2911,13 +3108,13 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
 
                         if (!codeValid)
                         {
-                            _network->publishKeypadJsonCommandResult("noValidCodeSet");
+                            publishKeypadJsonCommandResult("noValidCodeSet");
                             return;
                         }
                     }
                     else if (strcmp(action, "update") != 0)
                     {
-                        _network->publishKeypadJsonCommandResult("noCodeSet");
+                        publishKeypadJsonCommandResult("noCodeSet");
                         return;
                     }
 
@@ -2942,13 +3139,13 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
 
                                 if(allowedFromAr[0] < 2000 || allowedFromAr[0] > 3000 || allowedFromAr[1] < 1 || allowedFromAr[1] > 12 || allowedFromAr[2] < 1 || allowedFromAr[2] > 31 || allowedFromAr[3] < 0 || allowedFromAr[3] > 23 || allowedFromAr[4] < 0 || allowedFromAr[4] > 59 || allowedFromAr[5] < 0 || allowedFromAr[5] > 59)
                                 {
-                                    _network->publishKeypadJsonCommandResult("invalidAllowedFrom");
+                                    publishKeypadJsonCommandResult("invalidAllowedFrom");
                                     return;
                                 }
                             }
                             else
                             {
-                                _network->publishKeypadJsonCommandResult("invalidAllowedFrom");
+                                publishKeypadJsonCommandResult("invalidAllowedFrom");
                                 return;
                             }
                         }
@@ -2966,13 +3163,13 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
 
                                 if(allowedUntilAr[0] < 2000 || allowedUntilAr[0] > 3000 || allowedUntilAr[1] < 1 || allowedUntilAr[1] > 12 || allowedUntilAr[2] < 1 || allowedUntilAr[2] > 31 || allowedUntilAr[3] < 0 || allowedUntilAr[3] > 23 || allowedUntilAr[4] < 0 || allowedUntilAr[4] > 59 || allowedUntilAr[5] < 0 || allowedUntilAr[5] > 59)
                                 {
-                                    _network->publishKeypadJsonCommandResult("invalidAllowedUntil");
+                                    publishKeypadJsonCommandResult("invalidAllowedUntil");
                                     return;
                                 }
                             }
                             else
                             {
-                                _network->publishKeypadJsonCommandResult("invalidAllowedUntil");
+                                publishKeypadJsonCommandResult("invalidAllowedUntil");
                                 return;
                             }
                         }
@@ -2986,13 +3183,13 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
 
                                 if(allowedFromTimeAr[0] < 0 || allowedFromTimeAr[0] > 23 || allowedFromTimeAr[1] < 0 || allowedFromTimeAr[1] > 59)
                                 {
-                                    _network->publishKeypadJsonCommandResult("invalidAllowedFromTime");
+                                    publishKeypadJsonCommandResult("invalidAllowedFromTime");
                                     return;
                                 }
                             }
                             else
                             {
-                                _network->publishKeypadJsonCommandResult("invalidAllowedFromTime");
+                                publishKeypadJsonCommandResult("invalidAllowedFromTime");
                                 return;
                             }
                         }
@@ -3006,13 +3203,13 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
 
                                 if(allowedUntilTimeAr[0] < 0 || allowedUntilTimeAr[0] > 23 || allowedUntilTimeAr[1] < 0 || allowedUntilTimeAr[1] > 59)
                                 {
-                                    _network->publishKeypadJsonCommandResult("invalidAllowedUntilTime");
+                                    publishKeypadJsonCommandResult("invalidAllowedUntilTime");
                                     return;
                                 }
                             }
                             else
                             {
-                                _network->publishKeypadJsonCommandResult("invalidAllowedUntilTime");
+                                publishKeypadJsonCommandResult("invalidAllowedUntilTime");
                                 return;
                             }
                         }
@@ -3098,22 +3295,26 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
                     {
                         if(!codeId)
                         {
-                            _network->publishKeypadJsonCommandResult("noCodeIdSet");
+                            publishKeypadJsonCommandResult("noCodeIdSet");
                             return;
                         }
 
                         if(!idExists)
                         {
-                            _network->publishKeypadJsonCommandResult("noExistingCodeIdSet");
+                            publishKeypadJsonCommandResult("noExistingCodeIdSet");
                             return;
                         }
 
-                        Nuki::CmdResult resultKp = _nukiLock.retrieveKeypadEntries(0, _preferences->getInt(preference_keypad_max_entries, MAX_KEYPAD));
+                        Nuki::CmdResult resultKp = _commandBatch.entriesRetrieved() ? Nuki::CmdResult::Success : _nukiLock.retrieveKeypadEntries(0, _preferences->getInt(preference_keypad_max_entries, MAX_KEYPAD));
                         bool foundExisting = false;
 
                         if(resultKp == Nuki::CmdResult::Success)
                         {
-                            delay(5000);
+                            if(!_commandBatch.entriesRetrieved())
+                            {
+                                delay(5000);
+                                _commandBatch.setEntriesRetrieved();
+                            }
                             std::list<NukiLock::KeypadEntry> entries;
                             _nukiLock.getKeypadEntries(&entries);
 
@@ -3187,13 +3388,13 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
 
                             if(!foundExisting)
                             {
-                                _network->publishKeypadJsonCommandResult("failedToRetrieveExistingKeypadEntry");
+                                publishKeypadJsonCommandResult("failedToRetrieveExistingKeypadEntry");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishKeypadJsonCommandResult("failedToRetrieveExistingKeypadEntry");
+                            publishKeypadJsonCommandResult("failedToRetrieveExistingKeypadEntry");
                             return;
                         }
 
@@ -3263,7 +3464,7 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
                 }
                 else
                 {
-                    _network->publishKeypadJsonCommandResult("invalidAction");
+                    publishKeypadJsonCommandResult("invalidAction");
                     return;
                 }
 
@@ -3277,24 +3478,40 @@ void NukiWrapper::onKeypadJsonCommandReceived(const char *value)
                 }
             }
 
-            updateKeypad(false);
+            _commandBatch.invalidateEntries();
+
+            if(!_commandBatch.active())
+            {
+                updateKeypad(false);
+            }
 
             if((int)result != -1)
             {
                 char resultStr[15];
                 memset(&resultStr, 0, sizeof(resultStr));
                 NukiLock::cmdResultToString(result, resultStr);
-                _network->publishKeypadJsonCommandResult(resultStr);
+                publishKeypadJsonCommandResult(resultStr);
             }
         }
     }
     else
     {
-        _network->publishKeypadJsonCommandResult("noActionSet");
+        publishKeypadJsonCommandResult("noActionSet");
         return;
     }
 }
 
+void NukiWrapper::publishKeypadJsonCommandResult(const char* result)
+{
+    if(_commandBatch.active())
+    {
+        _commandBatch.addResult(result);
+        return;
+    }
+
+    _network->publishKeypadJsonCommandResult(result);
+}
+
 void NukiWrapper::onTimeControlCommandReceived(const char *value)
 {
     if(!_nukiConfigValid)
@@ -3324,6 +3541,30 @@ void NukiWrapper::onTimeControlCommandReceived(const char *value)
         return;
     }
 
+    if(json.is<JsonArray>())
+    {
+        _commandBatch.begin();
+
+        for(JsonObject entry : json.as<JsonArray>())
+        {
+            _commandBatch.beginEntry(entry["action"].as<const char*>());
+            executeTimeControlCommand(entry);
+            _commandBatch.endEntry();
+
+            postponeBleWatchdog();
+            esp_task_wdt_reset();
+        }
+
+        _commandBatch.end(CharBuffer::get(), CharBuffer::size());
+        _network->publishTimeControlCommandResult(CharBuffer::get());
+        return;
+    }
+
+    executeTimeControlCommand(json.as<JsonObject>());
+}
+
+void NukiWrapper::executeTimeControlCommand(JsonObject json)
+{
     const char *action = json["action"].as<const char*>();
     uint8_t entryId = json["entryId"].as<unsigned int>();
     uint8_t enabled;
@@ -3360,7 +3601,7 @@ void NukiWrapper::onTimeControlCommandReceived(const char *value)
 
         if((int)timeControlLockAction == 0xff)
         {
-            _network->publishTimeControlCommandResult("invalidLockAction");
+            publishTimeControlCommandResult("invalidLockAction");
             return;
         }
     }
@@ -3389,7 +3630,7 @@ void NukiWrapper::onTimeControlCommandReceived(const char *value)
                 }
                 else
                 {
-                    _network->publishTimeControlCommandResult("noExistingEntryIdSet");
+                    publishTimeControlCommandResult("noExistingEntryIdSet");
                     return;
                 }
             }
@@ -3409,13 +3650,13 @@ void NukiWrapper::onTimeControlCommandReceived(const char *value)
 
                         if(timeAr[0] < 0 || timeAr[0] > 23 || timeAr[1] < 0 || timeAr[1] > 59)
                         {
-                            _network->publishTimeControlCommandResult("invalidTime");
+                            publishTimeControlCommandResult("invalidTime");
                             return;
                         }
                     }
                     else
                     {
-                        _network->publishTimeControlCommandResult("invalidTime");
+                        publishTimeControlCommandResult("invalidTime");
                         return;
                     }
                 }
@@ -3471,16 +3712,20 @@ void NukiWrapper::onTimeControlCommandReceived(const char *value)
                 {
                     if(!idExists)
                     {
-                        _network->publishTimeControlCommandResult("noExistingEntryIdSet");
+                        publishTimeControlCommandResult("noExistingEntryIdSet");
                         return;
                     }
 
-                    Nuki::CmdResult resultTc = _nukiLock.retrieveTimeControlEntries();
+                    Nuki::CmdResult resultTc = _commandBatch.entriesRetrieved() ? Nuki::CmdResult::Success : _nukiLock.retrieveTimeControlEntries();
                     bool foundExisting = false;
 
                     if(resultTc == Nuki::CmdResult::Success)
                     {
-                        delay(5000);
+                        if(!_commandBatch.entriesRetrieved())
+                        {
+                            delay(5000);
+                            _commandBatch.setEntriesRetrieved();
+                        }
                         std::list<NukiLock::TimeControlEntry> timeControlEntries;
                         _nukiLock.getTimeControlEntries(&timeControlEntries);
 
@@ -3517,13 +3762,13 @@ void NukiWrapper::onTimeControlCommandReceived(const char *value)
 
                         if(!foundExisting)
                         {
-                            _network->publishTimeControlCommandResult("failedToRetrieveExistingTimeControlEntry");
+                            publishTimeControlCommandResult("failedToRetrieveExistingTimeControlEntry");
                             return;
                         }
                     }
                     else
                     {
-                        _network->publishTimeControlCommandResult("failedToRetrieveExistingTimeControlEntry");
+                        publishTimeControlCommandResult("failedToRetrieveExistingTimeControlEntry");
                         return;
                     }
 
@@ -3548,7 +3793,7 @@ void NukiWrapper::onTimeControlCommandReceived(const char *value)
             }
             else
             {
-                _network->publishTimeControlCommandResult("invalidAction");
+                publishTimeControlCommandResult("invalidAction");
                 return;
             }
 
@@ -3562,21 +3807,34 @@ void NukiWrapper::onTimeControlCommandReceived(const char *value)
             }
         }
 
+        _commandBatch.invalidateEntries();
+
         if((int)result != -1)
         {
             char resultStr[15];
             memset(&resultStr, 0, sizeof(resultStr));
             NukiLock::cmdResultToString(result, resultStr);
-            _network->publishTimeControlCommandResult(resultStr);
+            publishTimeControlCommandResult(resultStr);
         }
 
         _nextConfigUpdateTs = espMillis() + 300;
     }
     else
     {
-        _network->publishTimeControlCommandResult("noActionSet");
+        publishTimeControlCommandResult("noActionSet");
+        return;
+    }
+}
+
+void NukiWrapper::publishTimeControlCommandResult(const char* result)
+{
+    if(_commandBatch.active())
+    {
+        _commandBatch.addResult(result);
         return;
     }
+
+    _network->publishTimeControlCommandResult(result);
 }
 
 void NukiWrapper::onAuthCommandReceived(const char *value)
@@ -3608,6 +3866,32 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
         return;
     }
 
+    if(json.is<JsonArray>())
+    {
+        _commandBatch.begin();
+
+        for(JsonObject entry : json.as<JsonArray>())
+        {
+            _commandBatch.beginEntry(entry["action"].as<const char*>());
+            executeAuthCommand(entry);
+            _commandBatch.endEntry();
+
+            postponeBleWatchdog();
+            esp_task_wdt_reset();
+        }
+
+        updateAuth(false);
+
+        _commandBatch.end(CharBuffer::get(), CharBuffer::size());
+        _network->publishAuthCommandResult(CharBuffer::get());
+        return;
+    }
+
+    executeAuthCommand(json.as<JsonObject>());
+}
+
+void NukiWrapper::executeAuthCommand(JsonObject json)
+{
     char oldName[33];
     const char *action = json["action"].as<const char*>();
     uint32_t authId = json["authId"].as<unsigned int>();
@@ -3702,7 +3986,7 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
                 }
                 else
                 {
-                    _network->publishAuthCommandResult("noExistingAuthIdSet");
+                    publishAuthCommandResult("noExistingAuthIdSet");
                     return;
                 }
             }
@@ -3712,7 +3996,7 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
                 {
                     if (strcmp(action, "update") != 0)
                     {
-                        _network->publishAuthCommandResult("noNameSet");
+                        publishAuthCommandResult("noNameSet");
                         return;
                     }
                 }
@@ -3722,7 +4006,7 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
                 {
                     if (strcmp(action, "update") != 0)
                     {
-                        _network->publishAuthCommandResult("noSharedKeySet");
+                        publishAuthCommandResult("noSharedKeySet");
                         return;
                     }
                 }
@@ -3753,13 +4037,13 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
 
                             if(allowedFromAr[0] < 2000 || allowedFromAr[0] > 3000 || allowedFromAr[1] < 1 || allowedFromAr[1] > 12 || allowedFromAr[2] < 1 || allowedFromAr[2] > 31 || allowedFromAr[3] < 0 || allowedFromAr[3] > 23 || allowedFromAr[4] < 0 || allowedFromAr[4] > 59 || allowedFromAr[5] < 0 || allowedFromAr[5] > 59)
                             {
-                                _network->publishAuthCommandResult("invalidAllowedFrom");
+                                publishAuthCommandResult("invalidAllowedFrom");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishAuthCommandResult("invalidAllowedFrom");
+                            publishAuthCommandResult("invalidAllowedFrom");
                             return;
                         }
                     }
@@ -3777,13 +4061,13 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
 
                             if(allowedUntilAr[0] < 2000 || allowedUntilAr[0] > 3000 || allowedUntilAr[1] < 1 || allowedUntilAr[1] > 12 || allowedUntilAr[2] < 1 || allowedUntilAr[2] > 31 || allowedUntilAr[3] < 0 || allowedUntilAr[3] > 23 || allowedUntilAr[4] < 0 || allowedUntilAr[4] > 59 || allowedUntilAr[5] < 0 || allowedUntilAr[5] > 59)
                             {
-                                _network->publishAuthCommandResult("invalidAllowedUntil");
+                                publishAuthCommandResult("invalidAllowedUntil");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishAuthCommandResult("invalidAllowedUntil");
+                            publishAuthCommandResult("invalidAllowedUntil");
                             return;
                         }
                     }
@@ -3797,13 +4081,13 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
 
                             if(allowedFromTimeAr[0] < 0 || allowedFromTimeAr[0] > 23 || allowedFromTimeAr[1] < 0 || allowedFromTimeAr[1] > 59)
                             {
-                                _network->publishAuthCommandResult("invalidAllowedFromTime");
+                                publishAuthCommandResult("invalidAllowedFromTime");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishAuthCommandResult("invalidAllowedFromTime");
+                            publishAuthCommandResult("invalidAllowedFromTime");
                             return;
                         }
                     }
@@ -3817,13 +4101,13 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
 
                             if(allowedUntilTimeAr[0] < 0 || allowedUntilTimeAr[0] > 23 || allowedUntilTimeAr[1] < 0 || allowedUntilTimeAr[1] > 59)
                             {
-                                _network->publishAuthCommandResult("invalidAllowedUntilTime");
+                                publishAuthCommandResult("invalidAllowedUntilTime");
                                 return;
                             }
                         }
                         else
                         {
-                            _network->publishAuthCommandResult("invalidAllowedUntilTime");
+                            publishAuthCommandResult("invalidAllowedUntilTime");
                             return;
                         }
                     }
@@ -3860,7 +4144,7 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
 
                 if(strcmp(action, "add") == 0)
                 {
-                    _network->publishAuthCommandResult("addActionNotSupported");
+                    publishAuthCommandResult("addActionNotSupported");
                     return;
 
                     NukiLock::NewAuthorizationEntry entry;
@@ -3872,7 +4156,7 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
 
                     if(idType != 1)
                     {
-                        _network->publishAuthCommandResult("invalidIdType");
+                        publishAuthCommandResult("invalidIdType");
                         return;
                     }
 
@@ -3924,22 +4208,26 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
                 {
                     if(!authId)
                     {
-                        _network->publishAuthCommandResult("noAuthIdSet");
+                        publishAuthCommandResult("noAuthIdSet");
                         return;
                     }
 
                     if(!idExists)
                     {
-                        _network->publishAuthCommandResult("noExistingAuthIdSet");
+                        publishAuthCommandResult("noExistingAuthIdSet");
                         return;
                     }
 
-                    Nuki::CmdResult resultAuth = _nukiLock.retrieveAuthorizationEntries(0, _preferences->getInt(preference_auth_max_entries, MAX_AUTH));
+                    Nuki::CmdResult resultAuth = _commandBatch.entriesRetrieved() ? Nuki::CmdResult::Success : _nukiLock.retrieveAuthorizationEntries(0, _preferences->getInt(preference_auth_max_entries, MAX_AUTH));
                     bool foundExisting = false;
 
                     if(resultAuth == Nuki::CmdResult::Success)
                     {
-                        delay(5000);
+                        if(!_commandBatch.entriesRetrieved())
+                        {
+                            delay(5000);
+                            _commandBatch.setEntriesRetrieved();
+                        }
                         std::list<NukiLock::AuthorizationEntry> entries;
                         _nukiLock.getAuthorizationEntries(&entries);
 
@@ -4012,13 +4300,13 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
 
                         if(!foundExisting)
                         {
-                            _network->publishAuthCommandResult("failedToRetrieveExistingAuthorizationEntry");
+                            publishAuthCommandResult("failedToRetrieveExistingAuthorizationEntry");
                             return;
                         }
                     }
                     else
                     {
-                        _network->publishAuthCommandResult("failedToRetrieveExistingAuthorizationEntry");
+                        publishAuthCommandResult("failedToRetrieveExistingAuthorizationEntry");
                         return;
                     }
 
@@ -4089,7 +4377,7 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
             }
             else
             {
-                _network->publishAuthCommandResult("invalidAction");
+                publishAuthCommandResult("invalidAction");
                 return;
             }
 
@@ -4103,23 +4391,39 @@ void NukiWrapper::onAuthCommandReceived(const char *value)
             }
         }
 
-        updateAuth(false);
+        _commandBatch.invalidateEntries();
+
+        if(!_commandBatch.active())
+        {
+            updateAuth(false);
+        }
 
         if((int)result != -1)
         {
             char resultStr[15];
             memset(&resultStr, 0, sizeof(resultStr));
             NukiLock::cmdResultToString(result, resultStr);
-            _network->publishAuthCommandResult(resultStr);
+            publishAuthCommandResult(resultStr);
         }
     }
     else
     {
-        _network->publishAuthCommandResult("noActionSet");
+        publishAuthCommandResult("noActionSet");
         return;
     }
 }
 
+void NukiWrapper::publishAuthCommandResult(const char* result)
+{
+    if(_commandBatch.active())
+    {
+        _commandBatch.addResult(result);
+        return;
+    }
+
+    _network->publishAuthCommandResult(result);
+}
+
 const NukiLock::KeyTurnerState &NukiWrapper::keyTurnerState()
 {
     return _keyTurnerState;
@@ -4143,6 +4447,7 @@ void NukiWrapper::notify(Nuki::EventType eventType)
         {
             Log->println("OffKeyTurnerStatusUpdated");
             _statusUpdated = true;
+            wakeNukiTask();
         }
         else
         {
@@ -4158,6 +4463,7 @@ void NukiWrapper::notify(Nuki::EventType eventType)
                     _newSignal++;
                     Log->println("KeyTurnerStatusUpdated");
                     _statusUpdated = true;
+                    wakeNukiTask();
                     _statusUpdatedTs = espMillis();
                     _network->publishStatusUpdated(_statusUpdated);
                 }
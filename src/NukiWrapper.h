@@ -10,16 +10,19 @@
 #include "NukiDeviceId.h"
 #include "NukiOfficial.h"
 #include "EspMillis.h"
+#include "NukiCommandQueue.h"
+#include "NukiCommandBatch.h"
 
 class NukiWrapper : public Nuki::SmartlockEventHandler
 {
 public:
-    NukiWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NukiNetworkLock* network, NukiOfficial* nukiOfficial, Gpio* gpio, Preferences* preferences);
+    NukiWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NukiNetworkLock* network, NukiOfficial* nukiOfficial, Gpio* gpio, CachedPreferences* preferences);
     virtual ~NukiWrapper();
 
     void initialize();
     void readSettings();
     void update(bool reboot = false);
+    int64_t nextUpdateTs();
 
     void lock();
     void unlock();
@@ -46,10 +49,13 @@ public:
 
     std::string firmwareVersion() const;
     std::string hardwareVersion() const;
+    // Commands that were dropped because the command queue was full
+    uint32_t commandsDropped() const;
 
     void notify(Nuki::EventType eventType) override;
 
 private:
+    static bool isSettingsKey(const char* key);
     static LockActionResult onLockActionReceivedCallback(const char* value);
     static void onOfficialUpdateReceivedCallback(const char* topic, const char* value);
     static void onConfigUpdateReceivedCallback(const char* value);
@@ -65,8 +71,20 @@ private:
     void onKeypadJsonCommandReceived(const char* value);
     void onTimeControlCommandReceived(const char* value);
     void onAuthCommandReceived(const char* value);
+    void executeKeypadJsonCommand(JsonObject json);
+    void executeTimeControlCommand(JsonObject json);
+    void executeAuthCommand(JsonObject json);
+    void publishKeypadJsonCommandResult(const char* result);
+    void publishTimeControlCommandResult(const char* result);
+    void publishAuthCommandResult(const char* result);
     void onGpioActionReceived(const GpioAction& action, const int& pin);
 
+    void processCommandQueue();
+    void executeKeypadCommand(const char* value);
+    void executeLockAction(const NukiLock::LockAction action);
+    bool queueLockAction(const NukiLock::LockAction action);
+    bool queueCommand(const NukiCommandType type, const char* value);
+
     bool updateKeyTurnerState();
     void updateBatteryState();
     void updateConfig();
@@ -99,7 +117,7 @@ private:
     NukiNetworkLock* _network = nullptr;
     NukiOfficial* _nukiOfficial = nullptr;
     Gpio* _gpio = nullptr;
-    Preferences* _preferences;
+    CachedPreferences* _preferences;
     int _intervalLockstate = 0; // seconds
     int _intervalHybridLockstate = 0; // seconds
     int _intervalBattery = 0; // seconds
@@ -141,6 +159,7 @@ private:
     bool _keypadEnabled = false;
     bool _forceId = false;
     bool _isUltra = false;
+    std::atomic<bool> _settingsChanged{false};
     uint _maxKeypadCodeCount = 0;
     uint _maxTimeControlEntryCount = 0;
     uint _maxAuthEntryCount = 0;
@@ -167,5 +186,6 @@ private:
     uint32_t _advancedLockConfigaclPrefs[25];
     std::string _firmwareVersion = "";
     std::string _hardwareVersion = "";
-    volatile NukiLock::LockAction _nextLockAction = (NukiLock::LockAction)0xff;
+    NukiCommandQueue _commandQueue;
+    NukiCommandBatch _commandBatch;
 };
@@ -2,6 +2,7 @@
 
 #include <vector>
 #include "Config.h"
+#include "CachedPreferences.h"
 #include "Logger.h"
 #include "FS.h"
 #include "SPIFFS.h"
@@ -122,6 +123,12 @@
 #define preference_official_hybrid_retry (char*)"hybridRtry"
 #define preference_keypad_check_code_enabled (char*)"kpChkEna"
 #define preference_retain_gpio (char*)"retGpio"
+#define preference_mqtt_wildcard_subscriptions (char*)"mqttWildcard"
+#define preference_mqtt_v5 (char*)"mqttV5"
+#define preference_mqtt_outbox_capacity (char*)"mqttOutboxCap"
+#define preference_mqtt_qos_state (char*)"mqttQosState"
+#define preference_mqtt_qos_telemetry (char*)"mqttQosTelem"
+#define preference_mqtt_qos_command (char*)"mqttQosCmd"
 #define preference_lock_force_id (char*)"lckForceId"
 #define preference_lock_force_doorsensor (char*)"lckForceDrsns"
 #define preference_lock_force_keypad (char*)"lckForceKp"
@@ -151,12 +158,15 @@
 #define preference_latest_version (char*)"latest"
 #define preference_reset_mqtt_topics (char*)"rstMqtt"
 #define preference_nukihub_id (char*)"nukihubId"
+#define preference_hass_hash_hub (char*)"hassHashHub"
+#define preference_hass_hash_lock (char*)"hassHashLock"
+#define preference_hass_hash_opener (char*)"hassHashOp"
 
 //OBSOLETE
 #define preference_access_level (char*)"accLvl"
 #define preference_mqtt_opener_path (char*)"mqttoppath"
 
-inline void initPreferences(Preferences* preferences)
+inline void initPreferences(CachedPreferences* preferences)
 {
     #ifdef NUKI_HUB_UPDATER
     return;
@@ -492,7 +502,9 @@ private:
         preference_auth_control_enabled, preference_auth_topic_per_entry, preference_auth_info_enabled, preference_auth_max_entries, preference_wifi_ssid, preference_wifi_pass,
         preference_keypad_check_code_enabled, preference_disable_network_not_connected, preference_mqtt_hass_enabled, preference_hass_device_discovery, preference_retain_gpio,
         preference_debug_connect, preference_debug_communication, preference_debug_readable_data, preference_debug_hex_data, preference_debug_command, preference_connect_mode,
-        preference_lock_force_id, preference_lock_force_doorsensor, preference_lock_force_keypad, preference_opener_force_id, preference_opener_force_keypad, preference_nukihub_id
+        preference_lock_force_id, preference_lock_force_doorsensor, preference_lock_force_keypad, preference_opener_force_id, preference_opener_force_keypad, preference_nukihub_id,
+        preference_mqtt_wildcard_subscriptions, preference_mqtt_v5, preference_mqtt_outbox_capacity, preference_mqtt_qos_state,
+        preference_mqtt_qos_telemetry, preference_mqtt_qos_command
     };
     std::vector<char*> _redact =
     {
@@ -511,7 +523,8 @@ private:
         preference_ntw_reconfigure, preference_keypad_check_code_enabled, preference_disable_network_not_connected, preference_find_best_rssi, preference_http_auth_type,
         preference_debug_connect, preference_debug_communication, preference_debug_readable_data, preference_debug_hex_data, preference_debug_command, preference_connect_mode,
         preference_lock_force_id, preference_lock_force_doorsensor, preference_lock_force_keypad, preference_opener_force_id, preference_opener_force_keypad, preference_mqtt_ssl_enabled,
-        preference_hybrid_reboot_on_disconnect, preference_lock_gemini_enabled, preference_enable_debug_mode
+        preference_hybrid_reboot_on_disconnect, preference_lock_gemini_enabled, preference_enable_debug_mode, preference_mqtt_wildcard_subscriptions,
+        preference_mqtt_v5
     };
     std::vector<char*> _bytePrefs =
     {
@@ -528,7 +541,8 @@ private:
         preference_task_size_network, preference_task_size_nuki, preference_authlog_max_entries, preference_keypad_max_entries, preference_timecontrol_max_entries,
         preference_ble_tx_power, preference_network_custom_mdc, preference_network_custom_clk, preference_network_custom_phy, preference_network_custom_addr,
         preference_network_custom_irq, preference_network_custom_rst, preference_network_custom_cs, preference_network_custom_sck, preference_network_custom_miso,
-        preference_network_custom_mosi, preference_network_custom_pwr, preference_network_custom_mdio
+        preference_network_custom_mosi, preference_network_custom_pwr, preference_network_custom_mdio, preference_mqtt_outbox_capacity,
+        preference_mqtt_qos_state, preference_mqtt_qos_telemetry, preference_mqtt_qos_command
     };
     std::vector<char*> _uintPrefs =
     {
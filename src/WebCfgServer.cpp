@@ -24,7 +24,7 @@ extern const uint8_t x509_crt_imported_bundle_bin_end[]   asm("_binary_x509_crt_
 #include <NetworkClientSecure.h>
 #include "ArduinoJson.h"
 
-WebCfgServer::WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, NukiNetwork* network, Gpio* gpio, Preferences* preferences, bool allowRestartToPortal, uint8_t partitionType, PsychicHttpServer* psychicServer)
+WebCfgServer::WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, NukiNetwork* network, Gpio* gpio, CachedPreferences* preferences, bool allowRestartToPortal, uint8_t partitionType, PsychicHttpServer* psychicServer)
     : _nuki(nuki),
       _nukiOpener(nukiOpener),
       _network(network),
@@ -34,7 +34,7 @@ WebCfgServer::WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, Nuk
       _partitionType(partitionType),
       _psychicServer(psychicServer)
 #else
-WebCfgServer::WebCfgServer(NukiNetwork* network, Preferences* preferences, bool allowRestartToPortal, uint8_t partitionType, PsychicHttpServer* psychicServer)
+WebCfgServer::WebCfgServer(NukiNetwork* network, CachedPreferences* preferences, bool allowRestartToPortal, uint8_t partitionType, PsychicHttpServer* psychicServer)
     : _network(network),
       _preferences(preferences),
       _allowRestartToPortal(allowRestartToPortal),
@@ -180,6 +180,26 @@ void WebCfgServer::initialize()
     }
     else
     {
+#ifndef NUKI_HUB_UPDATER
+        // The status page gets its updates pushed, it authenticates with the same token as /get?page=status
+        _statusEvents.addFilter([&](PsychicRequest *request)
+        {
+            return request->hasParam("token") && request->getParam("token")->value().toInt() == _randomInt;
+        });
+        _statusEvents.onOpen([&](PsychicEventSourceClient *client)
+        {
+            JsonDocument json;
+            String jsonStr;
+            buildStatusJson(json);
+            serializeJson(json, jsonStr);
+            client->send(jsonStr.c_str(), "status");
+        });
+        _psychicServer->on("/events", HTTP_GET, &_statusEvents);
+        _network->addStatusChangedCallback([&]()
+        {
+            queueStatusEvent();
+        });
+#endif
         _psychicServer->on("/get", HTTP_GET, [&](PsychicRequest *request, PsychicResponse* resp)
         {
             String value = "";
@@ -1417,6 +1437,9 @@ esp_err_t WebCfgServer::sendSettings(PsychicRequest *request, PsychicResponse* r
             }
         }
 
+        // isKey() and getType() read NVS, write-behind keys that are still in the journal would be exported as missing or stale
+        _preferences->flush();
+
         DebugPreferences debugPreferences;
 
         const std::vector<char*> keysPrefs = debugPreferences.getPreferencesKeys();
@@ -2263,6 +2286,78 @@ bool WebCfgServer::processArgs(PsychicRequest *request, PsychicResponse* resp, S
                 //configChanged = true;
             }
         }
+        else if(key == "MQTTWILDCARD")
+        {
+            if(_preferences->getBool(preference_mqtt_wildcard_subscriptions, false) != (value == "1"))
+            {
+                _preferences->putBool(preference_mqtt_wildcard_subscriptions, (value == "1"));
+                Log->print(("Setting changed: "));
+                Log->println(key);
+                configChanged = true;
+            }
+        }
+        else if(key == "MQTTV5")
+        {
+            if(_preferences->getBool(preference_mqtt_v5, false) != (value == "1"))
+            {
+                _preferences->putBool(preference_mqtt_v5, (value == "1"));
+                Log->print(("Setting changed: "));
+                Log->println(key);
+                configChanged = true;
+            }
+        }
+        else if(key == "MQTTOUTBOX")
+        {
+            if(value.toInt() > 15 && value.toInt() <= MQTT_OUTBOX_CAPACITY_MAX)
+            {
+                if(_preferences->getInt(preference_mqtt_outbox_capacity, MQTT_OUTBOX_CAPACITY) != value.toInt())
+                {
+                    _preferences->putInt(preference_mqtt_outbox_capacity, value.toInt());
+                    Log->print(("Setting changed: "));
+                    Log->println(key);
+                    configChanged = true;
+                }
+            }
+        }
+        else if(key == "MQTTQOSSTATE")
+        {
+            if(value.toInt() >= 0 && value.toInt() <= 2)
+            {
+                if(_preferences->getInt(preference_mqtt_qos_state, MQTT_QOS_LEVEL) != value.toInt())
+                {
+                    _preferences->putInt(preference_mqtt_qos_state, value.toInt());
+                    Log->print(("Setting changed: "));
+                    Log->println(key);
+                    configChanged = true;
+                }
+            }
+        }
+        else if(key == "MQTTQOSTELEM")
+        {
+            if(value.toInt() >= 0 && value.toInt() <= 2)
+            {
+                if(_preferences->getInt(preference_mqtt_qos_telemetry, MQTT_QOS_LEVEL_TELEMETRY) != value.toInt())
+                {
+                    _preferences->putInt(preference_mqtt_qos_telemetry, value.toInt());
+                    Log->print(("Setting changed: "));
+                    Log->println(key);
+                    configChanged = true;
+                }
+            }
+        }
+        else if(key == "MQTTQOSCMD")
+        {
+            if(value.toInt() >= 0 && value.toInt() <= 2)
+            {
+                if(_preferences->getInt(preference_mqtt_qos_command, MQTT_QOS_LEVEL) != value.toInt())
+                {
+                    _preferences->putInt(preference_mqtt_qos_command, value.toInt());
+                    Log->print(("Setting changed: "));
+                    Log->println(key);
+                    configChanged = true;
+                }
+            }
+        }
         else if(key == "DISNONJSON")
         {
             if(_preferences->getBool(preference_disable_non_json, false) != (value == "1"))
@@ -3550,16 +3645,6 @@ bool WebCfgServer::processArgs(PsychicRequest *request, PsychicResponse* resp, S
         message = "Configuration saved.";
     }
 
-    _network->readSettings();
-    if(_nuki != nullptr)
-    {
-        _nuki->readSettings();
-    }
-    if(_nukiOpener != nullptr)
-    {
-        _nukiOpener->readSettings();
-    }
-
     return configChanged;
 }
 
@@ -3915,7 +4000,7 @@ esp_err_t WebCfgServer::buildCustomNetworkConfigHtml(PsychicRequest *request, Ps
 esp_err_t WebCfgServer::buildHtml(PsychicRequest *request, PsychicResponse* resp)
 {
     _randomInt = esp_random();
-    String header = (String)"<script>let intervalId; window.onload = function() { updateInfo(); intervalId = setInterval(updateInfo, 3000); }; function updateInfo() { var request = new XMLHttpRequest(); request.open('GET', '/get?page=status&token=" + _randomInt + "', true); request.onload = () => { const obj = JSON.parse(request.responseText); if (obj.stop == 1) { clearInterval(intervalId); } for (var key of Object.keys(obj)) { if(key=='ota' && document.getElementById(key) !== null) { document.getElementById(key).innerText = \"<a href='/ota'>\" + obj[key] + \"</a>\"; } else if(document.getElementById(key) !== null) { document.getElementById(key).innerText = obj[key]; } } }; request.send(); }</script>";
+    String header = (String)"<script>let intervalId; window.onload = function() { if (window.EventSource) { var source = new EventSource('/events?token=" + _randomInt + "'); source.addEventListener('status', function(e) { applyInfo(JSON.parse(e.data)); }); } else { updateInfo(); intervalId = setInterval(updateInfo, 3000); } }; function updateInfo() { var request = new XMLHttpRequest(); request.open('GET', '/get?page=status&token=" + _randomInt + "', true); request.onload = () => { const obj = JSON.parse(request.responseText); if (obj.stop == 1) { clearInterval(intervalId); } applyInfo(obj); }; request.send(); } function applyInfo(obj) { for (var key of Object.keys(obj)) { if(key=='ota' && document.getElementById(key) !== null) { document.getElementById(key).innerText = \"<a href='/ota'>\" + obj[key] + \"</a>\"; } else if(document.getElementById(key) !== null) { document.getElementById(key).innerText = obj[key]; } } }</script>";
     PsychicStreamResponse response(resp, "text/html");
     response.beginSend();
     buildHtmlHeader(&response, header);
@@ -3934,6 +4019,9 @@ esp_err_t WebCfgServer::buildHtml(PsychicRequest *request, PsychicResponse* resp
     response.print("<table>");
     printParameter(&response, "Hostname", _hostname.c_str(), "", "hostname");
     printParameter(&response, "MQTT Connected", _network->mqttConnectionState() > 0 ? "Yes" : "No", "", "mqttState");
+    int8_t rssi = _network->signalStrength();
+    printParameter(&response, "Signal strength", rssi != 127 ? (String(rssi) + " dBm").c_str() : "-", "", "rssi");
+    printParameter(&response, "Free heap", (String(esp_get_free_heap_size()) + " bytes").c_str(), "", "freeHeap");
     if(_nuki != nullptr)
     {
         char lockStateArr[20];
@@ -4158,7 +4246,7 @@ esp_err_t WebCfgServer::buildMqttConfigHtml(PsychicRequest *request, PsychicResp
     response.print("<h3>Advanced MQTT Configuration</h3>");
     response.print("<table>");
     printInputField(&response, "HASSDISCOVERY", "Home Assistant discovery topic (usually \"homeassistant\")", _preferences->getString(preference_mqtt_hass_discovery).c_str(), 30, "class=\"chkHass\"");
-    //printCheckBox(&response, "HADEVDISC", "Use Home Assistant device based discovery (2024.11+)", _preferences->getBool(preference_hass_device_discovery), "");
+    printCheckBox(&response, "HADEVDISC", "Use Home Assistant device based discovery (2024.11+)", _preferences->getBool(preference_hass_device_discovery), "");
     if(_preferences->getBool(preference_opener_enabled, false))
     {
         printCheckBox(&response, "OPENERCONT", "Set Nuki Opener Lock/Unlock action in Home Assistant to Continuous mode", _preferences->getBool(preference_opener_continuous_mode), "");
@@ -4171,6 +4259,12 @@ esp_err_t WebCfgServer::buildMqttConfigHtml(PsychicRequest *request, PsychicResp
     printCheckBox(&response, "MQTTLOG", "Enable MQTT logging", _preferences->getBool(preference_mqtt_log_enabled), "");
     printCheckBox(&response, "UPDATEMQTT", "Allow updating using MQTT", _preferences->getBool(preference_update_from_mqtt), "");
     printCheckBox(&response, "DISNONJSON", "Disable some extraneous non-JSON topics", _preferences->getBool(preference_disable_non_json), "");
+    printCheckBox(&response, "MQTTWILDCARD", "Use wildcard MQTT subscriptions (disable if the broker ACL only allows the individual command topics)", _preferences->getBool(preference_mqtt_wildcard_subscriptions), "");
+    printCheckBox(&response, "MQTTV5", "Use MQTT 5 (topic aliases for frequently published topics, requires a MQTT 5 broker)", _preferences->getBool(preference_mqtt_v5), "");
+    printDropDown(&response, "MQTTQOSSTATE", "MQTT QoS for states, configuration and discovery", String(_preferences->getInt(preference_mqtt_qos_state, MQTT_QOS_LEVEL)), getMqttQosOptions(), "");
+    printDropDown(&response, "MQTTQOSTELEM", "MQTT QoS for telemetry (uptime, RSSI, free heap, debug counters)", String(_preferences->getInt(preference_mqtt_qos_telemetry, MQTT_QOS_LEVEL_TELEMETRY)), getMqttQosOptions(), "");
+    printDropDown(&response, "MQTTQOSCMD", "MQTT QoS for commands and command results", String(_preferences->getInt(preference_mqtt_qos_command, MQTT_QOS_LEVEL)), getMqttQosOptions(), "");
+    printInputField(&response, "MQTTOUTBOX", "Max queued MQTT packets before publishes are dropped (min 16, max 120)", _preferences->getInt(preference_mqtt_outbox_capacity, MQTT_OUTBOX_CAPACITY), 3, "");
     printCheckBox(&response, "OFFHYBRID", "Enable hybrid official MQTT and Nuki Hub setup", _preferences->getBool(preference_official_hybrid_enabled), "");
     printCheckBox(&response, "HYBRIDACT", "Enable sending actions through official MQTT", _preferences->getBool(preference_official_hybrid_actions), "");
     printInputField(&response, "HYBRIDTIMER", "Time between status updates when official MQTT is offline (seconds)", _preferences->getInt(preference_query_interval_hybrid_lockstate), 5, "");
@@ -4470,12 +4564,22 @@ esp_err_t WebCfgServer::buildStatusHtml(PsychicRequest *request, PsychicResponse
 {
     JsonDocument json;
     String jsonStr;
+
+    json["stop"] = buildStatusJson(json) ? 1 : 0;
+
+    serializeJson(json, jsonStr);
+    resp->setCode(200);
+    resp->setContentType("application/json");
+    resp->setContent(jsonStr.c_str());
+    return resp->send();
+}
+
+bool WebCfgServer::buildStatusJson(JsonDocument& json)
+{
     bool mqttDone = false;
     bool lockDone = false;
     bool openerDone = false;
 
-    json["stop"] = 0;
-
     if(_network->mqttConnectionState() > 0)
     {
         json["mqttState"] = "Yes";
@@ -4552,16 +4656,45 @@ esp_err_t WebCfgServer::buildStatusHtml(PsychicRequest *request, PsychicResponse
         json["latestFirmware"] = _preferences->getString(preference_latest_version);
     }
 
-    if(mqttDone && lockDone && openerDone)
+    int8_t rssi = _network->signalStrength();
+    if(rssi != 127)
     {
-        json["stop"] = 1;
+        json["rssi"] = String(rssi) + " dBm";
     }
+    json["freeHeap"] = String(esp_get_free_heap_size()) + " bytes";
 
+    return mqttDone && lockDone && openerDone;
+}
+
+void WebCfgServer::queueStatusEvent()
+{
+    // Called from the network and nuki task, the status is built on the httpd task like a polled request. Changes that arrive before it ran are sent together.
+    if(_statusEventQueued.exchange(true))
+    {
+        return;
+    }
+
+    if(httpd_queue_work(_psychicServer->server, sendStatusEvent, this) != ESP_OK)
+    {
+        _statusEventQueued = false;
+    }
+}
+
+void WebCfgServer::sendStatusEvent(void* arg)
+{
+    WebCfgServer* webCfgServer = (WebCfgServer*)arg;
+    webCfgServer->_statusEventQueued = false;
+
+    if(webCfgServer->_statusEvents.count() == 0)
+    {
+        return;
+    }
+
+    JsonDocument json;
+    String jsonStr;
+    webCfgServer->buildStatusJson(json);
     serializeJson(json, jsonStr);
-    resp->setCode(200);
-    resp->setContentType("application/json");
-    resp->setContent(jsonStr.c_str());
-    return resp->send();
+    webCfgServer->_statusEvents.send(jsonStr.c_str(), "status");
 }
 
 String WebCfgServer::pinStateToString(uint8_t value)
@@ -5157,6 +5290,36 @@ esp_err_t WebCfgServer::buildInfoHtml(PsychicRequest *request, PsychicResponse*
     response.print(_preferences->getInt(preference_query_interval_battery, 1800));
     response.print("\nMost non-JSON MQTT topics disabled: ");
     response.print(_preferences->getBool(preference_disable_non_json, false) ? "Yes" : "No");
+    response.print("\nWildcard MQTT subscriptions: ");
+    response.print(_preferences->getBool(preference_mqtt_wildcard_subscriptions, false) ? "Yes" : "No");
+    response.print("\nMQTT 5: ");
+    response.print(_preferences->getBool(preference_mqtt_v5, false) ? "Yes" : "No");
+    response.print("\nMQTT QoS states / telemetry / commands: ");
+    response.print(_preferences->getInt(preference_mqtt_qos_state, MQTT_QOS_LEVEL));
+    response.print(" / ");
+    response.print(_preferences->getInt(preference_mqtt_qos_telemetry, MQTT_QOS_LEVEL_TELEMETRY));
+    response.print(" / ");
+    response.print(_preferences->getInt(preference_mqtt_qos_command, MQTT_QOS_LEVEL));
+    response.print("\nMQTT outbox capacity: ");
+    response.print(_preferences->getInt(preference_mqtt_outbox_capacity, MQTT_OUTBOX_CAPACITY));
+    response.print("\nMQTT outbox size / high water mark: ");
+    response.print(_network->mqttQueueSize());
+    response.print(" / ");
+    response.print(_network->mqttQueueHighWaterMark());
+    response.print("\nMQTT publishes dropped: ");
+    response.print(_network->mqttPublishesDropped());
+    response.print("\nNuki commands dropped: ");
+    response.print(_network->nukiCommandsDropped());
+    HassDiscoveryProgress hassProgress = _network->hassDiscoveryProgress();
+    response.print("\nHA discovery: ");
+    response.print(hassProgress.running ? "Running" : "Idle");
+    response.print(", ");
+    response.print(hassProgress.published);
+    response.print(" / ");
+    response.print(hassProgress.total);
+    response.print(" entities, ");
+    response.print(hassProgress.duration);
+    response.print(" ms");
     response.print("\nPublish Nuki device config: ");
     response.print(_preferences->getBool(preference_conf_info_enabled, false) ? "Yes" : "No");
     response.print("\nConfig query interval (s): ");
@@ -5949,6 +6112,15 @@ const std::vector<std::pair<String, String>> WebCfgServer::getNetworkCustomCLKOp
 }
 #endif
 
+const std::vector<std::pair<String, String>> WebCfgServer::getMqttQosOptions() const
+{
+    std::vector<std::pair<String, String>> options;
+    options.push_back(std::make_pair("0", "0 (at most once)"));
+    options.push_back(std::make_pair("1", "1 (at least once)"));
+    options.push_back(std::make_pair("2", "2 (exactly once)"));
+    return options;
+}
+
 const std::vector<std::pair<String, String>> WebCfgServer::getGpioOptions() const
 {
     std::vector<std::pair<String, String>> options;
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <Preferences.h>
+#include "CachedPreferences.h"
+#include <atomic>
 #include <PsychicHttp.h>
 #ifdef CONFIG_ESP_HTTPS_SERVER_ENABLE
 #include <PsychicHttpsServer.h>
@@ -38,9 +39,9 @@ class WebCfgServer
 {
 public:
     #ifndef NUKI_HUB_UPDATER
-    WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, NukiNetwork* network, Gpio* gpio, Preferences* preferences, bool allowRestartToPortal, uint8_t partitionType, PsychicHttpServer* psychicServer);
+    WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, NukiNetwork* network, Gpio* gpio, CachedPreferences* preferences, bool allowRestartToPortal, uint8_t partitionType, PsychicHttpServer* psychicServer);
     #else
-    WebCfgServer(NukiNetwork* network, Preferences* preferences, bool allowRestartToPortal, uint8_t partitionType, PsychicHttpServer* psychicServer);
+    WebCfgServer(NukiNetwork* network, CachedPreferences* preferences, bool allowRestartToPortal, uint8_t partitionType, PsychicHttpServer* psychicServer);
     #endif
     ~WebCfgServer() = default;
 
@@ -61,6 +62,10 @@ private:
     esp_err_t buildMqttSSLConfigHtml(PsychicRequest *request, PsychicResponse* resp, int type=0);
     esp_err_t buildHttpSSLConfigHtml(PsychicRequest *request, PsychicResponse* resp, int type=0);
     esp_err_t buildStatusHtml(PsychicRequest *request, PsychicResponse* resp);
+    // Returns true when all states are known, the polling page stops then
+    bool buildStatusJson(JsonDocument& json);
+    void queueStatusEvent();
+    static void sendStatusEvent(void* arg);
     esp_err_t buildAdvancedConfigHtml(PsychicRequest *request, PsychicResponse* resp);
     esp_err_t buildNukiConfigHtml(PsychicRequest *request, PsychicResponse* resp);
     esp_err_t buildGpioConfigHtml(PsychicRequest *request, PsychicResponse* resp);
@@ -78,6 +83,7 @@ private:
 
     const std::vector<std::pair<String, String>> getNetworkDetectionOptions() const;
     const std::vector<std::pair<String, String>> getGpioOptions() const;
+    const std::vector<std::pair<String, String>> getMqttQosOptions() const;
     const std::vector<std::pair<String, String>> getNetworkCustomPHYOptions() const;
     #if defined(CONFIG_IDF_TARGET_ESP32)
     const std::vector<std::pair<String, String>> getNetworkCustomCLKOptions() const;
@@ -94,6 +100,8 @@ private:
     bool _pinsConfigured = false;
     bool _brokerConfigured = false;
     bool _rebootRequired = false;
+    PsychicEventSource _statusEvents;
+    std::atomic<bool> _statusEventQueued{false};
     #endif
 
     std::vector<String> _ssidList;
@@ -121,7 +129,7 @@ private:
 
     PsychicHttpServer* _psychicServer = nullptr;
     NukiNetwork* _network = nullptr;
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
 
     char _credUser[31] = {0};
     char _credPassword[31] = {0};
@@ -6,6 +6,7 @@
 #include "esp_http_client.h"
 #include "esp_https_ota.h"
 #include "esp_task_wdt.h"
+#include "esp_system.h"
 #include "Config.h"
 #include "esp32-hal-log.h"
 #include "hal/wdt_hal.h"
@@ -28,6 +29,7 @@
 #include "PreferencesKeys.h"
 #include "RestartReason.h"
 #include "EspMillis.h"
+#include "NukiTaskWakeup.h"
 #include "NimBLEDevice.h"
 #include "esp_netif_sntp.h"
 
@@ -76,7 +78,7 @@ PsychicHttpsServer* psychicSSLServer = nullptr;
 NukiNetwork* network = nullptr;
 WebCfgServer* webCfgServer = nullptr;
 WebCfgServer* webCfgServerSSL = nullptr;
-Preferences* preferences = nullptr;
+CachedPreferences* preferences = nullptr;
 
 RTC_NOINIT_ATTR int espRunning;
 RTC_NOINIT_ATTR int restartReason;
@@ -232,6 +234,8 @@ void networkTask(void *pvParameters)
             networkLoopTs = espMillis();
         }
 
+        preferences->flushIfDue();
+
         if(espMillis() > restartTs)
         {
             uint8_t partitionType = checkPartition();
@@ -267,10 +271,12 @@ void nukiTask(void *pvParameters)
     bool whiteListed = false;
     while(true)
     {
+        int64_t nextTs = 0;
+
         if(disableNetwork || wifiConnected)
         {
+            // Runs once per pass, when idle that is only every NUKI_TASK_MAX_WAIT ms
             bleScanner->update();
-            delay(20);
 
             bool needsPairing = (lockEnabled && !nuki->isPaired()) || (openerEnabled && !nukiOpener->isPaired());
 
@@ -295,10 +301,12 @@ void nukiTask(void *pvParameters)
             {
                 nuki->update(rebootLock);
                 rebootLock = false;
+                mergeDeadline(nextTs, nuki->nextUpdateTs());
             }
             if(openerEnabled)
             {
                 nukiOpener->update();
+                mergeDeadline(nextTs, nukiOpener->nextUpdateTs());
             }
         }
 
@@ -309,6 +317,11 @@ void nukiTask(void *pvParameters)
         }
 
         esp_task_wdt_reset();
+
+        // Sleep until the next wrapper deadline or until woken by a lock action, BLE event, GPIO or MQTT command.
+        // Always block for at least one tick so lower priority tasks on this core keep running.
+        int64_t waitTime = nukiTaskWaitTime(nextTs, espMillis(), NUKI_TASK_MAX_WAIT);
+        ulTaskNotifyTake(pdTRUE, max(pdMS_TO_TICKS(waitTime), (TickType_t)1));
     }
 }
 
@@ -526,9 +539,18 @@ void setup()
     //ets_install_putc1(&ets_putc_handler);
 #endif
 
-    preferences = new Preferences();
+    preferences = new CachedPreferences();
     preferences->begin("nukihub", false);
     initPreferences(preferences);
+    // Written on every lock / opener state or entry list update, kept in RAM and flushed to NVS periodically and before restarts
+    preferences->setWriteBehind({ preference_lock_pin_status, preference_opener_pin_status, preference_latest_version,
+                                  preference_lock_max_keypad_code_count, preference_opener_max_keypad_code_count,
+                                  preference_lock_max_timecontrol_entry_count, preference_opener_max_timecontrol_entry_count,
+                                  preference_lock_max_auth_entry_count, preference_opener_max_auth_entry_count });
+    esp_register_shutdown_handler([]()
+    {
+        preferences->flush();
+    });
     uint8_t partitionType = checkPartition();
 
     initializeRestartReason();
@@ -679,7 +701,7 @@ void setup()
 
     const String mqttLockPath = preferences->getString(preference_mqtt_lock_path);
 
-    network = new NukiNetwork(preferences, gpio, mqttLockPath, CharBuffer::get(), buffer_size);
+    network = new NukiNetwork(preferences, gpio, mqttLockPath);
     network->initialize();
 
     lockEnabled = preferences->getBool(preference_lock_enabled);
@@ -706,7 +728,7 @@ void setup()
     if(lockEnabled)
     {
         nukiOfficial = new NukiOfficial(preferences);
-        networkLock = new NukiNetworkLock(network, nukiOfficial, preferences, CharBuffer::get(), buffer_size);
+        networkLock = new NukiNetworkLock(network, nukiOfficial, preferences);
 
         if(!disableNetwork)
         {
@@ -715,12 +737,16 @@ void setup()
 
         nuki = new NukiWrapper("NukiHub", deviceIdLock, bleScanner, networkLock, nukiOfficial, gpio, preferences);
         nuki->initialize();
+        network->addNukiCommandsDroppedCounter([]()
+        {
+            return nuki->commandsDropped();
+        });
     }
 
     Log->println(openerEnabled ? F("Nuki Opener enabled") : F("Nuki Opener disabled"));
     if(openerEnabled)
     {
-        networkOpener = new NukiNetworkOpener(network, preferences, CharBuffer::get(), buffer_size);
+        networkOpener = new NukiNetworkOpener(network, preferences);
 
         if(!disableNetwork)
         {
@@ -729,6 +755,10 @@ void setup()
 
         nukiOpener = new NukiOpenerWrapper("NukiHub", deviceIdOpener, bleScanner, networkOpener, gpio, preferences);
         nukiOpener->initialize();
+        network->addNukiCommandsDroppedCounter([]()
+        {
+            return nukiOpener->commandsDropped();
+        });
     }
 
     if(!doOta && !disableNetwork && (forceEnableWebServer || preferences->getBool(preference_webserver_enabled, true) || preferences->getBool(preference_webserial_enabled, false)))
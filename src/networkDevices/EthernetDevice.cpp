@@ -14,7 +14,7 @@
 extern bool ethCriticalFailure;
 extern bool wifiFallback;
 
-EthernetDevice::EthernetDevice(const String& hostname, Preferences* preferences, const IPConfiguration* ipConfiguration, const std::string& deviceName, uint8_t phy_addr, int power, int mdc, int mdio, eth_phy_type_t ethtype, eth_clock_mode_t clock_mode)
+EthernetDevice::EthernetDevice(const String& hostname, CachedPreferences* preferences, const IPConfiguration* ipConfiguration, const std::string& deviceName, uint8_t phy_addr, int power, int mdc, int mdio, eth_phy_type_t ethtype, eth_clock_mode_t clock_mode)
     : NetworkDevice(hostname, preferences, ipConfiguration),
       _deviceName(deviceName),
       _phy_addr(phy_addr),
@@ -32,7 +32,7 @@ EthernetDevice::EthernetDevice(const String& hostname, Preferences* preferences,
 }
 
 EthernetDevice::EthernetDevice(const String &hostname,
-                               Preferences *preferences,
+                               CachedPreferences *preferences,
                                const IPConfiguration *ipConfiguration,
                                const std::string &deviceName,
                                uint8_t phy_addr,
@@ -9,7 +9,7 @@
 #include "W5500Definitions.h"
 #include <NetworkClient.h>
 #include <NetworkClientSecure.h>
-#include <Preferences.h>
+#include "../CachedPreferences.h"
 #include "NetworkDevice.h"
 
 class EthernetDevice : public NetworkDevice
@@ -17,7 +17,7 @@ class EthernetDevice : public NetworkDevice
 
 public:
     EthernetDevice(const String& hostname,
-                     Preferences* preferences,
+                     CachedPreferences* preferences,
                      const IPConfiguration* ipConfiguration,
                      const std::string& deviceName,
                      uint8_t phy_addr = ETH_PHY_ADDR_LAN8720,
@@ -28,7 +28,7 @@ public:
                      eth_clock_mode_t clock_mode = ETH_CLK_MODE_LAN8720);
 
     EthernetDevice(const String& hostname,
-                     Preferences* preferences,
+                     CachedPreferences* preferences,
                      const IPConfiguration* ipConfiguration,
                      const std::string& deviceName,
                      uint8_t phy_addr,
@@ -56,7 +56,7 @@ public:
     String BSSIDstr() override;
 
 private:
-    Preferences* _preferences;
+    CachedPreferences* _preferences;
 
     void onDisconnected();
     void onNetworkEvent(arduino_event_id_t event, arduino_event_info_t info);
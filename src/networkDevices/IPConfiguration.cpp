@@ -2,7 +2,7 @@
 #include "../PreferencesKeys.h"
 #include "../Logger.h"
 
-IPConfiguration::IPConfiguration(Preferences *preferences)
+IPConfiguration::IPConfiguration(CachedPreferences *preferences)
     : _preferences(preferences)
 {
     if(!dhcpEnabled() && _preferences->getString(preference_ip_address, "").length() <= 0)
@@ -1,11 +1,11 @@
 #pragma once
 
-#include <Preferences.h>
+#include "../CachedPreferences.h"
 
 class IPConfiguration
 {
 public:
-    explicit IPConfiguration(Preferences* preferences);
+    explicit IPConfiguration(CachedPreferences* preferences);
 
     bool dhcpEnabled() const;
     const IPAddress ipAddress() const;
@@ -14,7 +14,7 @@ public:
     const IPAddress dnsServer() const;
 
 private:
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
 
     IPAddress _ipAddress;
     IPAddress _subnet;
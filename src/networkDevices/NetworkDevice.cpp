@@ -131,6 +131,18 @@ void NetworkDevice::mqttSetCleanSession(bool cleanSession)
     }
 }
 
+void NetworkDevice::mqttSetProtocolVersion(espMqttClientTypes::ProtocolVersion version)
+{
+    if (_useEncryption)
+    {
+        _mqttClientSecure->setProtocolVersion(version);
+    }
+    else
+    {
+        _mqttClient->setProtocolVersion(version);
+    }
+}
+
 void NetworkDevice::mqttSetKeepAlive(uint16_t keepAlive)
 {
     if (_useEncryption)
@@ -143,16 +155,31 @@ void NetworkDevice::mqttSetKeepAlive(uint16_t keepAlive)
     }
 }
 
+void NetworkDevice::mqttSetQueueCapacity(size_t capacity)
+{
+    getMqttClient()->setQueueCapacity(capacity);
+}
+
 uint16_t NetworkDevice::mqttPublish(const char *topic, uint8_t qos, bool retain, const char *payload)
 {
     return getMqttClient()->publish(topic, qos, retain, payload);
 }
 
+uint16_t NetworkDevice::mqttPublish(const char *topic, uint8_t qos, bool retain, const char *payload, espMqttClientTypes::PublishMode mode)
+{
+    return getMqttClient()->publish(topic, qos, retain, payload, nullptr, mode);
+}
+
 uint16_t NetworkDevice::mqttPublish(const char *topic, uint8_t qos, bool retain, const uint8_t *payload, size_t length)
 {
     return getMqttClient()->publish(topic, qos, retain, payload, length);
 }
 
+uint16_t NetworkDevice::mqttPublish(const char *topic, uint8_t qos, bool retain, espMqttClientTypes::PayloadWriter writer, size_t length, espMqttClientTypes::PublishMode mode)
+{
+    return getMqttClient()->publish(topic, qos, retain, writer, length, nullptr, mode);
+}
+
 bool NetworkDevice::mqttConnected() const
 {
     return getMqttClient()->connected();
@@ -245,6 +272,21 @@ uint16_t NetworkDevice::mqttSubscribe(const char *topic, uint8_t qos)
     return getMqttClient()->subscribe(topic, qos);
 }
 
+uint16_t NetworkDevice::mqttSubscribe(const espMqttClientTypes::SubscribeItem* list, size_t count)
+{
+    return getMqttClient()->subscribe(list, count);
+}
+
+size_t NetworkDevice::mqttQueueSize()
+{
+    return getMqttClient()->queueSize();
+}
+
+size_t NetworkDevice::mqttQueueHighWaterMark()
+{
+    return getMqttClient()->queueHighWaterMark();
+}
+
 void NetworkDevice::mqttDisable()
 {
     getMqttClient()->disconnect();
@@ -8,7 +8,7 @@
 class NetworkDevice
 {
 public:
-    explicit NetworkDevice(const String& hostname, Preferences* preferences, const IPConfiguration* ipConfiguration)
+    explicit NetworkDevice(const String& hostname, CachedPreferences* preferences, const IPConfiguration* ipConfiguration)
     : _hostname(hostname),
       _preferences(preferences),
       _ipConfiguration(ipConfiguration)
@@ -35,13 +35,20 @@ public:
     virtual bool mqttConnected() const;
 
     virtual uint16_t mqttPublish(const char* topic, uint8_t qos, bool retain, const char* payload);
+    virtual uint16_t mqttPublish(const char* topic, uint8_t qos, bool retain, const char* payload, espMqttClientTypes::PublishMode mode);
     virtual uint16_t mqttPublish(const char* topic, uint8_t qos, bool retain, const uint8_t* payload, size_t length);
+    virtual uint16_t mqttPublish(const char* topic, uint8_t qos, bool retain, espMqttClientTypes::PayloadWriter writer, size_t length, espMqttClientTypes::PublishMode mode);
     virtual uint16_t mqttSubscribe(const char* topic, uint8_t qos);
+    virtual uint16_t mqttSubscribe(const espMqttClientTypes::SubscribeItem* list, size_t count);
+    virtual size_t mqttQueueSize();
+    virtual size_t mqttQueueHighWaterMark();
     
     virtual void mqttSetServer(const char* host, uint16_t port);
     virtual void mqttSetClientId(const char* clientId);
     virtual void mqttSetCleanSession(bool cleanSession);
+    virtual void mqttSetProtocolVersion(espMqttClientTypes::ProtocolVersion version);
     virtual void mqttSetKeepAlive(uint16_t keepAlive);
+    virtual void mqttSetQueueCapacity(size_t capacity);
     virtual void mqttSetWill(const char* topic, uint8_t qos, bool retain, const char* payload);
     virtual void mqttSetCredentials(const char* username, const char* password);
     
@@ -52,7 +59,7 @@ public:
 
 protected:
     const IPConfiguration* _ipConfiguration = nullptr;
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
     #ifndef NUKI_HUB_UPDATER
     espMqttClient *_mqttClient = nullptr;
     espMqttClientSecure *_mqttClientSecure = nullptr;
@@ -4,7 +4,7 @@
 #include "../RestartReason.h"
 #include "../EspMillis.h"
 
-WifiDevice::WifiDevice(const String& hostname, Preferences* preferences, const IPConfiguration* ipConfiguration)
+WifiDevice::WifiDevice(const String& hostname, CachedPreferences* preferences, const IPConfiguration* ipConfiguration)
     : NetworkDevice(hostname, preferences, ipConfiguration),
       _preferences(preferences)
 {
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Preferences.h>
+#include "../CachedPreferences.h"
 #include "NetworkDevice.h"
 #include "IPConfiguration.h"
 #include "esp_wifi.h"
@@ -10,7 +10,7 @@
 class WifiDevice : public NetworkDevice
 {
 public:
-    WifiDevice(const String& hostname, Preferences* preferences, const IPConfiguration* ipConfiguration);
+    WifiDevice(const String& hostname, CachedPreferences* preferences, const IPConfiguration* ipConfiguration);
 
     const String deviceName() const override;
 
@@ -35,7 +35,7 @@ private:
 
     void onWifiEvent(const WiFiEvent_t& event, const WiFiEventInfo_t& info);
 
-    Preferences* _preferences = nullptr;
+    CachedPreferences* _preferences = nullptr;
 
     String ssid;
     String pass;
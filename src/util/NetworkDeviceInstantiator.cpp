@@ -7,7 +7,7 @@
 #include "NetworkUtil.h"
 #include "../networkDevices/LAN8720Definitions.h"
 
-NetworkDevice *NetworkDeviceInstantiator::Create(NetworkDeviceType networkDeviceType, String hostname, Preferences *preferences, IPConfiguration *ipConfiguration)
+NetworkDevice *NetworkDeviceInstantiator::Create(NetworkDeviceType networkDeviceType, String hostname, CachedPreferences *preferences, IPConfiguration *ipConfiguration)
 {
     NetworkDevice* device = nullptr;
 
@@ -3,10 +3,10 @@
 #include "../networkDevices/NetworkDevice.h"
 #include "../enums/NetworkDeviceType.h"
 #include <string>
-#include <Preferences.h>
+#include "../CachedPreferences.h"
 
 class NetworkDeviceInstantiator
 {
 public:
-    static NetworkDevice* Create(NetworkDeviceType networkDeviceType, String hostname, Preferences* preferences, IPConfiguration* ipConfiguration);
+    static NetworkDevice* Create(NetworkDeviceType networkDeviceType, String hostname, CachedPreferences* preferences, IPConfiguration* ipConfiguration);
 };
@@ -0,0 +1,157 @@
+#pragma once
+
+// Host stand-in for the Arduino Preferences library, backed by a simulated flash.
+// Every put is one atomic NVS write; writes can be made to fail to simulate a power loss in the middle of a flush.
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+class String : public std::string
+{
+public:
+    String(const char* str = "") : std::string(str != nullptr ? str : "") {}
+    String(const std::string& str) : std::string(str) {}
+};
+
+typedef enum
+{
+    PT_I8, PT_U8, PT_I16, PT_U16, PT_I32, PT_U32, PT_I64, PT_U64, PT_STR, PT_BLOB, PT_INVALID
+} PreferenceType;
+
+struct SimulatedFlash
+{
+    struct Entry
+    {
+        PreferenceType type;
+        uint32_t value;
+        std::string str;
+    };
+
+    std::map<std::string, Entry> entries;
+    // Keys in the order they were written
+    std::vector<std::string> writes;
+    // Number of writes that still succeed, -1 for no limit
+    int writesLeft = -1;
+
+    bool write(const char* key, const Entry& entry)
+    {
+        if(writesLeft == 0)
+        {
+            return false;
+        }
+        if(writesLeft > 0)
+        {
+            --writesLeft;
+        }
+        entries[key] = entry;
+        writes.push_back(key);
+        return true;
+    }
+
+    void reset()
+    {
+        entries.clear();
+        writes.clear();
+        writesLeft = -1;
+    }
+};
+
+extern SimulatedFlash flash;
+
+class Preferences
+{
+public:
+    bool getBool(const char* key, bool defaultValue = false)
+    {
+        return getValue(key, PT_U8, defaultValue ? 1 : 0) != 0;
+    }
+
+    int32_t getInt(const char* key, int32_t defaultValue = 0)
+    {
+        return (int32_t)getValue(key, PT_I32, (uint32_t)defaultValue);
+    }
+
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0)
+    {
+        return getValue(key, PT_U32, defaultValue);
+    }
+
+    String getString(const char* key, String defaultValue = String())
+    {
+        auto it = flash.entries.find(key);
+        return it != flash.entries.end() && it->second.type == PT_STR ? String(it->second.str) : defaultValue;
+    }
+
+    size_t getString(const char* key, char* value, size_t maxLen)
+    {
+        String str = getString(key);
+        if(str.length() + 1 > maxLen)
+        {
+            return 0;
+        }
+        memcpy(value, str.c_str(), str.length() + 1);
+        return str.length() + 1;
+    }
+
+    size_t putBool(const char* key, bool value)
+    {
+        return flash.write(key, { PT_U8, value ? 1u : 0u, "" }) ? 1 : 0;
+    }
+
+    size_t putInt(const char* key, int32_t value)
+    {
+        return flash.write(key, { PT_I32, (uint32_t)value, "" }) ? 4 : 0;
+    }
+
+    size_t putUInt(const char* key, uint32_t value)
+    {
+        return flash.write(key, { PT_U32, value, "" }) ? 4 : 0;
+    }
+
+    size_t putString(const char* key, const char* value)
+    {
+        return flash.write(key, { PT_STR, 0, value }) ? strlen(value) : 0;
+    }
+
+    size_t putString(const char* key, String value)
+    {
+        return putString(key, value.c_str());
+    }
+
+    size_t putBytes(const char* key, const void* value, size_t len)
+    {
+        return flash.write(key, { PT_BLOB, 0, std::string((const char*)value, len) }) ? len : 0;
+    }
+
+    bool remove(const char* key)
+    {
+        return flash.entries.erase(key) > 0;
+    }
+
+    bool clear()
+    {
+        flash.entries.clear();
+        return true;
+    }
+
+    bool isKey(const char* key)
+    {
+        return flash.entries.find(key) != flash.entries.end();
+    }
+
+    PreferenceType getType(const char* key)
+    {
+        auto it = flash.entries.find(key);
+        return it != flash.entries.end() ? it->second.type : PT_INVALID;
+    }
+
+private:
+    uint32_t getValue(const char* key, PreferenceType type, uint32_t defaultValue)
+    {
+        auto it = flash.entries.find(key);
+        return it != flash.entries.end() && it->second.type == type ? it->second.value : defaultValue;
+    }
+};
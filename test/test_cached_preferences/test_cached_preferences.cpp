@@ -0,0 +1,196 @@
+#include <unity.h>
+
+#include "CachedPreferences.cpp"
+
+// Journal ordering and crash consistency of the write-behind keys in CachedPreferences.
+// A "crash" is a new CachedPreferences instance on the same simulated flash without a flush.
+
+SimulatedFlash flash;
+
+static CachedPreferences* createPreferences()
+{
+    CachedPreferences* preferences = new CachedPreferences();
+    preferences->setWriteBehind({ "a", "b", "c" });
+    return preferences;
+}
+
+void setUp()
+{
+    flash.reset();
+}
+
+void tearDown() {}
+
+void test_writeBehindStaysInRamUntilFlush()
+{
+    CachedPreferences* preferences = createPreferences();
+
+    preferences->putInt("a", 1);
+    preferences->putString("b", "x");
+
+    TEST_ASSERT_EQUAL_INT32(1, preferences->getInt("a"));
+    TEST_ASSERT_EQUAL_STRING("x", preferences->getString("b").c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, flash.writes.size());
+    TEST_ASSERT_EQUAL_UINT32(2, preferences->pendingWrites());
+
+    preferences->flush();
+
+    TEST_ASSERT_EQUAL_UINT32(2, flash.writes.size());
+    TEST_ASSERT_EQUAL_UINT32(0, preferences->pendingWrites());
+    TEST_ASSERT_EQUAL_UINT32(1, preferences->flushCount());
+
+    delete preferences;
+}
+
+void test_writeThroughIsImmediate()
+{
+    CachedPreferences* preferences = createPreferences();
+
+    preferences->putInt("d", 5);
+
+    TEST_ASSERT_EQUAL_UINT32(1, flash.writes.size());
+    TEST_ASSERT_EQUAL_UINT32(0, preferences->pendingWrites());
+
+    delete preferences;
+}
+
+void test_flushWritesInOrderOfLastWrite()
+{
+    CachedPreferences* preferences = createPreferences();
+
+    preferences->putInt("a", 1);
+    preferences->putInt("b", 1);
+    preferences->putInt("c", 1);
+    preferences->putInt("a", 2);
+
+    TEST_ASSERT_EQUAL_UINT32(1, preferences->coalescedWrites());
+    TEST_ASSERT_EQUAL_UINT32(3, preferences->pendingWrites());
+
+    preferences->flush();
+
+    TEST_ASSERT_EQUAL_UINT32(3, flash.writes.size());
+    TEST_ASSERT_EQUAL_STRING("b", flash.writes[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("c", flash.writes[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("a", flash.writes[2].c_str());
+    TEST_ASSERT_EQUAL_UINT32(2, flash.entries["a"].value);
+
+    delete preferences;
+}
+
+void test_unchangedWriteIsNotJournaled()
+{
+    CachedPreferences* preferences = createPreferences();
+
+    preferences->putInt("a", 1);
+    preferences->flush();
+    preferences->putInt("a", 1);
+
+    TEST_ASSERT_EQUAL_UINT32(0, preferences->pendingWrites());
+
+    delete preferences;
+}
+
+void test_crashLosesOnlyUnflushedWrites()
+{
+    CachedPreferences* preferences = createPreferences();
+
+    preferences->putInt("a", 1);
+    preferences->putInt("b", 1);
+    preferences->flush();
+    preferences->putInt("a", 2);
+    preferences->putInt("d", 3);
+    delete preferences;
+
+    preferences = createPreferences();
+
+    TEST_ASSERT_EQUAL_INT32(1, preferences->getInt("a"));
+    TEST_ASSERT_EQUAL_INT32(1, preferences->getInt("b"));
+    TEST_ASSERT_EQUAL_INT32(3, preferences->getInt("d"));
+
+    delete preferences;
+}
+
+void test_failedWriteStopsFlushInOrder()
+{
+    CachedPreferences* preferences = createPreferences();
+
+    preferences->putInt("a", 1);
+    preferences->putInt("b", 1);
+    preferences->putInt("c", 1);
+
+    flash.writesLeft = 1;
+    preferences->flush();
+
+    // Only a prefix of the journal reached the flash, "c" was not written before "b"
+    TEST_ASSERT_EQUAL_UINT32(1, flash.writes.size());
+    TEST_ASSERT_EQUAL_STRING("a", flash.writes[0].c_str());
+    TEST_ASSERT_EQUAL_UINT32(2, preferences->pendingWrites());
+    TEST_ASSERT_EQUAL_INT32(1, preferences->getInt("c"));
+
+    flash.writesLeft = -1;
+    preferences->flush();
+
+    TEST_ASSERT_EQUAL_UINT32(3, flash.writes.size());
+    TEST_ASSERT_EQUAL_STRING("b", flash.writes[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("c", flash.writes[2].c_str());
+    TEST_ASSERT_EQUAL_UINT32(0, preferences->pendingWrites());
+
+    delete preferences;
+}
+
+void test_crashDuringFlushKeepsPrefix()
+{
+    CachedPreferences* preferences = createPreferences();
+
+    preferences->putInt("a", 1);
+    preferences->putInt("b", 1);
+    preferences->putInt("c", 1);
+    preferences->flush();
+
+    preferences->putInt("a", 2);
+    preferences->putInt("b", 2);
+    preferences->putInt("c", 2);
+    flash.writesLeft = 2;
+    preferences->flush();
+    delete preferences;
+
+    flash.writesLeft = -1;
+    preferences = createPreferences();
+
+    TEST_ASSERT_EQUAL_INT32(2, preferences->getInt("a"));
+    TEST_ASSERT_EQUAL_INT32(2, preferences->getInt("b"));
+    TEST_ASSERT_EQUAL_INT32(1, preferences->getInt("c"));
+
+    delete preferences;
+}
+
+void test_removeDropsJournaledWrite()
+{
+    CachedPreferences* preferences = createPreferences();
+
+    preferences->putInt("a", 1);
+    preferences->remove("a");
+
+    TEST_ASSERT_EQUAL_UINT32(0, preferences->pendingWrites());
+
+    preferences->flush();
+
+    TEST_ASSERT_FALSE(flash.entries.count("a") > 0);
+    TEST_ASSERT_EQUAL_INT32(7, preferences->getInt("a", 7));
+
+    delete preferences;
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_writeBehindStaysInRamUntilFlush);
+    RUN_TEST(test_writeThroughIsImmediate);
+    RUN_TEST(test_flushWritesInOrderOfLastWrite);
+    RUN_TEST(test_unchangedWriteIsNotJournaled);
+    RUN_TEST(test_crashLosesOnlyUnflushedWrites);
+    RUN_TEST(test_failedWriteStopsFlushInOrder);
+    RUN_TEST(test_crashDuringFlushKeepsPrefix);
+    RUN_TEST(test_removeDropsJournaledWrite);
+    return UNITY_END();
+}
@@ -0,0 +1,135 @@
+#include <unity.h>
+
+#include <ArduinoJson.h>
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "CharBuffer.cpp"
+
+// The network task and the nuki task serialize their payloads into CharBuffer::get() at the same time.
+// Each thread checks that the payload it serialized is still intact when it is "published".
+
+#define ITERATIONS 20000
+
+static std::atomic<bool> start(false);
+
+static void buildKeypad(JsonDocument& json, int i)
+{
+    JsonArray codes = json.to<JsonArray>();
+    for(int j = 0; j < 3; j++)
+    {
+        JsonObject entry = codes.add<JsonObject>();
+        entry["codeId"] = i * 3 + j;
+        entry["enabled"] = 1;
+        entry["name"] = "Keypad code";
+        entry["createdYear"] = 2024;
+    }
+}
+
+static void buildAuthLog(JsonDocument& json, int i)
+{
+    JsonArray log = json.to<JsonArray>();
+    for(int j = 0; j < 2; j++)
+    {
+        JsonObject entry = log.add<JsonObject>();
+        entry["index"] = i * 2 + j;
+        entry["authorizationId"] = 12345678;
+        entry["authorizationName"] = "Nuki Hub";
+        entry["action"] = "Unlock";
+        entry["trigger"] = "system";
+    }
+}
+
+static void buildKeyturner(JsonDocument& json, int i)
+{
+    json.clear();
+    json["lock_state"] = i % 2 == 0 ? "locked" : "unlocked";
+    json["lockngo_state"] = "";
+    json["trigger"] = "manual";
+    json["night_mode"] = 0;
+    json["last_lock_action_completion_status"] = i;
+    json["door_sensor_state"] = "doorClosed";
+    json["auth_id"] = i;
+}
+
+// Serializes like the publishers do and compares the buffer to a copy serialized elsewhere, then reads it back
+static void publishTask(void (*build)(JsonDocument& json, int i), void (*build2)(JsonDocument& json, int i), std::atomic<int>* corrupted,
+                        char** buffer)
+{
+    JsonDocument json;
+    std::string expected;
+
+    while(!start)
+    {
+        std::this_thread::yield();
+    }
+
+    *buffer = CharBuffer::get();
+
+    for(int i = 0; i < ITERATIONS; i++)
+    {
+        (i % 2 == 0 ? build : build2)(json, i);
+        expected.clear();
+        serializeJson(json, expected);
+
+        serializeJson(json, CharBuffer::get(), CharBuffer::size());
+        std::this_thread::yield();
+
+        JsonDocument parsed;
+        if(expected != CharBuffer::get() || deserializeJson(parsed, CharBuffer::get()) != DeserializationError::Ok)
+        {
+            ++*corrupted;
+        }
+    }
+}
+
+void setUp()
+{
+    CharBuffer::initialize(4096);
+    start = false;
+}
+
+void tearDown() {}
+
+void test_bufferIsPerThread()
+{
+    char* mainBuffer = CharBuffer::get();
+    char* threadBuffer = nullptr;
+
+    std::thread thread([&threadBuffer]()
+    {
+        threadBuffer = CharBuffer::get();
+    });
+    thread.join();
+
+    TEST_ASSERT_NOT_NULL(threadBuffer);
+    TEST_ASSERT_TRUE(mainBuffer != threadBuffer);
+    TEST_ASSERT_TRUE(mainBuffer == CharBuffer::get());
+    TEST_ASSERT_EQUAL_UINT32(4096, CharBuffer::size());
+}
+
+void test_concurrentPublishesKeepPayloadIntact()
+{
+    std::atomic<int> corrupted(0);
+    char* networkBuffer = nullptr;
+    char* nukiBuffer = nullptr;
+
+    // Network task: keypad and keyturner state, nuki task: auth log and keyturner state
+    std::thread networkTask(publishTask, buildKeypad, buildKeyturner, &corrupted, &networkBuffer);
+    std::thread nukiTask(publishTask, buildAuthLog, buildKeyturner, &corrupted, &nukiBuffer);
+    start = true;
+    networkTask.join();
+    nukiTask.join();
+
+    TEST_ASSERT_TRUE(networkBuffer != nukiBuffer);
+    TEST_ASSERT_EQUAL_INT32(0, corrupted.load());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bufferIsPerThread);
+    RUN_TEST(test_concurrentPublishesKeepPayloadIntact);
+    return UNITY_END();
+}
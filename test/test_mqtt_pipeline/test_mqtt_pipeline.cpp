@@ -0,0 +1,88 @@
+#include <unity.h>
+
+#include <string>
+
+#include "MqttDispatcher.cpp"
+#include "MqttPublishCache.cpp"
+#include "MqttTopicRegistry.cpp"
+#include "NukiCommandQueue.h"
+
+// Smoke test of the hostable MQTT pieces: a command is routed by the dispatcher into the command queue,
+// the resulting state is published through the topic registry and the publish cache.
+
+static bool isCacheable(const char* topic)
+{
+    return strcmp(topic, "/lock/commandResult") != 0;
+}
+
+static bool isLastValue(const char* topic)
+{
+    return strcmp(topic, "/lock/state") == 0;
+}
+
+static MqttTopicClass classify(const char* topic)
+{
+    return strcmp(topic, "/lock/commandResult") == 0 ? MqttTopicClass::Command : MqttTopicClass::State;
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_commandRoundTrip()
+{
+    MqttDispatcher dispatcher;
+    NukiCommandQueue queue;
+
+    TEST_ASSERT_TRUE(dispatcher.add("nukihub/lock/action", [&queue](const char* topic, const char* data, const unsigned int length)
+    {
+        queue.pushPayload(NukiCommandType::KeypadJson, data);
+    }));
+    TEST_ASSERT_FALSE(dispatcher.add("nukihub/lock/action", nullptr));
+
+    TEST_ASSERT_TRUE(dispatcher.dispatch("nukihub/lock/action", "{\"action\":\"add\"}", 16));
+    TEST_ASSERT_FALSE(dispatcher.dispatch("nukihub/lock/unknown", "1", 1));
+    TEST_ASSERT_EQUAL_UINT32(1, dispatcher.handledCount());
+    TEST_ASSERT_EQUAL_UINT32(1, dispatcher.unhandledCount());
+
+    NukiCommand command;
+    TEST_ASSERT_TRUE(queue.pop(command));
+    TEST_ASSERT_TRUE(command.type == NukiCommandType::KeypadJson);
+    TEST_ASSERT_EQUAL_STRING("{\"action\":\"add\"}", command.payload);
+    command.freePayload();
+    TEST_ASSERT_TRUE(queue.empty());
+}
+
+void test_statePublishIsCached()
+{
+    MqttTopicRegistry registry;
+    MqttPublishCache cache(60000);
+    MqttTopicRegistry::Topic topic;
+
+    uint16_t id = registry.intern("nukihub", "/lock/state", isCacheable, isLastValue, classify);
+    TEST_ASSERT_TRUE(id != MQTT_TOPIC_ID_INVALID);
+    TEST_ASSERT_TRUE(registry.get(id, topic));
+    TEST_ASSERT_EQUAL_STRING("nukihub/lock/state", topic.path);
+    TEST_ASSERT_TRUE(topic.cacheable);
+    TEST_ASSERT_TRUE(topic.lastValue);
+    TEST_ASSERT_EQUAL_UINT32(MqttPublishCache::pathHash("nukihub/lock/state"), topic.pathHash);
+
+    TEST_ASSERT_TRUE(cache.update(topic.pathHash, "locked", 1000));
+    TEST_ASSERT_FALSE(cache.update(topic.pathHash, "locked", 2000));
+    TEST_ASSERT_TRUE(cache.update(topic.pathHash, "unlocked", 3000));
+    TEST_ASSERT_TRUE(cache.update(topic.pathHash, "unlocked", 3000 + 60000));
+
+    TEST_ASSERT_TRUE(registry.lookup("nukihub", "/lock/commandResult", isCacheable, isLastValue, classify, topic));
+    TEST_ASSERT_FALSE(topic.cacheable);
+    TEST_ASSERT_FALSE(topic.lastValue);
+    TEST_ASSERT_TRUE(topic.topicClass == MqttTopicClass::Command);
+    TEST_ASSERT_EQUAL_UINT32(2, registry.size());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_commandRoundTrip);
+    RUN_TEST(test_statePublishIsCached);
+    return UNITY_END();
+}
@@ -0,0 +1,99 @@
+#include <unity.h>
+
+#include "NukiTaskWakeup.h"
+
+// Deadline merging and sleep time clamping of the nuki task loop.
+
+#define MAX_WAIT 500
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_mergeDeadlineIgnoresUnscheduled()
+{
+    int64_t nextTs = 0;
+
+    mergeDeadline(nextTs, 0);
+    TEST_ASSERT_EQUAL_INT64(0, nextTs);
+
+    nextTs = 1000;
+    mergeDeadline(nextTs, 0);
+    TEST_ASSERT_EQUAL_INT64(1000, nextTs);
+}
+
+void test_mergeDeadlineTakesFirstDeadline()
+{
+    int64_t nextTs = 0;
+
+    mergeDeadline(nextTs, 1500);
+    TEST_ASSERT_EQUAL_INT64(1500, nextTs);
+}
+
+void test_mergeDeadlineKeepsEarliest()
+{
+    int64_t nextTs = 0;
+
+    mergeDeadline(nextTs, 3000);
+    mergeDeadline(nextTs, 1200);
+    mergeDeadline(nextTs, 0);
+    mergeDeadline(nextTs, 2000);
+
+    TEST_ASSERT_EQUAL_INT64(1200, nextTs);
+}
+
+void test_waitTimeWithoutDeadlineIsMaxWait()
+{
+    TEST_ASSERT_EQUAL_INT64(MAX_WAIT, nukiTaskWaitTime(0, 1000, MAX_WAIT));
+}
+
+void test_waitTimeForDueDeadlineIsZero()
+{
+    TEST_ASSERT_EQUAL_INT64(0, nukiTaskWaitTime(1000, 1000, MAX_WAIT));
+    TEST_ASSERT_EQUAL_INT64(0, nukiTaskWaitTime(900, 1000, MAX_WAIT));
+}
+
+void test_waitTimeUntilDeadline()
+{
+    TEST_ASSERT_EQUAL_INT64(1, nukiTaskWaitTime(1001, 1000, MAX_WAIT));
+    TEST_ASSERT_EQUAL_INT64(250, nukiTaskWaitTime(1250, 1000, MAX_WAIT));
+    TEST_ASSERT_EQUAL_INT64(MAX_WAIT - 1, nukiTaskWaitTime(1000 + MAX_WAIT - 1, 1000, MAX_WAIT));
+}
+
+void test_waitTimeIsCappedAtMaxWait()
+{
+    TEST_ASSERT_EQUAL_INT64(MAX_WAIT, nukiTaskWaitTime(1000 + MAX_WAIT, 1000, MAX_WAIT));
+    TEST_ASSERT_EQUAL_INT64(MAX_WAIT, nukiTaskWaitTime(1000 + 60000, 1000, MAX_WAIT));
+}
+
+void test_waitTimeForMergedDeadlines()
+{
+    // Same sequence as one pass of nukiTask with the lock and opener enabled
+    int64_t now = 10000;
+    int64_t nextTs = 0;
+
+    mergeDeadline(nextTs, now + 30000);
+    mergeDeadline(nextTs, now + 120);
+    mergeDeadline(nextTs, 0);
+
+    TEST_ASSERT_EQUAL_INT64(120, nukiTaskWaitTime(nextTs, now, MAX_WAIT));
+
+    // A wrapper that needs another pass right away returns the current time
+    mergeDeadline(nextTs, now);
+
+    TEST_ASSERT_EQUAL_INT64(0, nukiTaskWaitTime(nextTs, now, MAX_WAIT));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mergeDeadlineIgnoresUnscheduled);
+    RUN_TEST(test_mergeDeadlineTakesFirstDeadline);
+    RUN_TEST(test_mergeDeadlineKeepsEarliest);
+    RUN_TEST(test_waitTimeWithoutDeadlineIsMaxWait);
+    RUN_TEST(test_waitTimeForDueDeadlineIsZero);
+    RUN_TEST(test_waitTimeUntilDeadline);
+    RUN_TEST(test_waitTimeIsCappedAtMaxWait);
+    RUN_TEST(test_waitTimeForMergedDeadlines);
+    return UNITY_END();
+}